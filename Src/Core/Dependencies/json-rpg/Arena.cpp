@@ -0,0 +1,56 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#include "Arena.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace JSON
+{
+	void* Arena::allocate(size_t size, size_t alignment)
+	{
+		assert(alignment && !(alignment & (alignment - 1)) && "alignment must be a power of two");
+		while (current < blocks.size())
+		{
+			Block& block = blocks[current];
+			const auto base = reinterpret_cast<uintptr_t>(block.data.get());
+			const size_t aligned = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+			if (aligned + size <= block.size)
+			{
+				offset = aligned + size;
+				used += size;
+				return block.data.get() + aligned;
+			}
+			// block exhausted, move on to the next one (kept from before a reset)
+			current++;
+			offset = 0;
+		}
+
+		// new block, oversized requests get a block of their own
+		const size_t newSize = std::max(blockSize, size + alignment);
+		blocks.push_back(Block{ std::unique_ptr<std::byte[]>(new std::byte[newSize]), newSize }); // left uninitialized
+		current = blocks.size() - 1;
+		offset = 0;
+		return allocate(size, alignment);
+	}
+
+	void Arena::reset()
+	{
+		current = 0;
+		offset = 0;
+		used = 0;
+	}
+
+	void Arena::release()
+	{
+		blocks.clear();
+		reset();
+	}
+
+	size_t Arena::bytesReserved() const
+	{
+		size_t total = 0;
+		for (const auto& block : blocks) { total += block.size; }
+		return total;
+	}
+
+}
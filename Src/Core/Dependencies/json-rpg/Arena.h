@@ -0,0 +1,62 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <new>
+#include <type_traits>
+
+namespace JSON
+{
+	/* bump allocator that hands out memory from a few large blocks, everything is released at once
+	objects placed in the arena must be trivially destructible, since destructors are never called */
+	class Arena
+	{
+	public:
+		static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+		explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE) : blockSize{ blockSize } {};
+		~Arena() = default;
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+		Arena(Arena&&) noexcept = default;
+		Arena& operator=(Arena&&) noexcept = default;
+
+		void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		template<typename T>
+		T* allocateArray(size_t count)
+		{
+			static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+			if (!count) { return nullptr; }
+			return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+		}
+
+		// rewinds the arena, previously allocated blocks are kept and reused
+		void reset();
+		// frees all blocks
+		void release();
+
+		// bytes handed out since the last reset
+		size_t bytesUsed() const { return used; }
+		// bytes held by the arena, including unused space
+		size_t bytesReserved() const;
+		size_t numBlocks() const { return blocks.size(); }
+
+	private:
+		struct Block
+		{
+			std::unique_ptr<std::byte[]> data;
+			size_t size;
+		};
+
+		std::vector<Block> blocks;
+		size_t current = 0; // index of the block currently being filled
+		size_t offset = 0; // offset within the current block
+		size_t used = 0;
+		size_t blockSize;
+	};
+
+}
@@ -0,0 +1,122 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#include "Batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+	using JSON::Result;
+
+	uint32_t resolveThreadCount(uint32_t numThreads, size_t numItems)
+	{
+		if (!numThreads) { numThreads = std::max(1u, std::thread::hardware_concurrency()); }
+		return static_cast<uint32_t>(std::min<size_t>(numThreads, std::max<size_t>(numItems, 1)));
+	}
+
+	/* runs fn(i) for every i in [0, count), workers take chunks of grain items from a shared counter
+	the calling thread works too, fn writes its result to slot i so no ordering is needed afterwards */
+	template<typename Fn>
+	void parallelFor(size_t count, uint32_t numThreads, size_t grain, Fn fn)
+	{
+		std::atomic<size_t> nextItem{ 0 };
+		auto work = [&]()
+		{
+			while (true)
+			{
+				const size_t first = nextItem.fetch_add(grain, std::memory_order_relaxed);
+				if (first >= count) { return; }
+				const size_t last = std::min(first + grain, count);
+				for (size_t i = first; i < last; i++) { fn(i); }
+			}
+		};
+
+		std::vector<std::thread> workers;
+		workers.reserve(numThreads - 1);
+		for (uint32_t t = 1; t < numThreads; t++) { workers.emplace_back(work); }
+		work();
+		for (std::thread& worker : workers) { worker.join(); }
+	}
+
+	Result firstError(const std::vector<JSON::BatchDocument>& documents)
+	{
+		for (const JSON::BatchDocument& d : documents)
+		{
+			if (d.result != Result::OK) { return d.result; }
+		}
+		return Result::OK;
+	}
+
+	bool isBlank(str_view line)
+	{
+		return std::all_of(line.begin(), line.end(), [](char_t c) { return isWhitespaceChar(c); });
+	}
+}
+
+namespace JSON
+{
+	Result loadNDJSON(str_view text, std::vector<BatchDocument>& documentsOut, uint32_t numThreads)
+	{
+		// split into lines first, this is a memchr pass and cheap next to parsing
+		std::vector<str_view> lines;
+		std::vector<size_t> lineNumbers;
+		size_t pos = 0;
+		size_t lineNumber = 1;
+		while (pos < text.size())
+		{
+			const void* found = std::memchr(text.data() + pos, '\n', text.size() - pos);
+			const size_t end = found ? static_cast<size_t>(static_cast<const char_t*>(found) - text.data()) : text.size();
+			const str_view line = text.substr(pos, end - pos);
+			if (!isBlank(line))
+			{
+				lines.push_back(line);
+				lineNumbers.push_back(lineNumber);
+			}
+			pos = end + 1;
+			lineNumber++;
+		}
+
+		documentsOut.clear();
+		documentsOut.reserve(lines.size());
+		for (size_t i = 0; i < lines.size(); i++)
+		{
+			// lines are usually small, a full default block per document would waste most of it
+			const size_t blockSize = std::clamp<size_t>(lines[i].size() * 2, 256, Arena::DEFAULT_BLOCK_SIZE);
+			documentsOut.push_back(BatchDocument{ Document(blockSize), Result::OK, lineNumbers[i], str_t() });
+		}
+
+		// small lines are grouped so the shared counter is not hit per line
+		const size_t grain = std::clamp<size_t>(lines.size() / (resolveThreadCount(numThreads, lines.size()) * 16), 1, 256);
+		parallelFor(lines.size(), resolveThreadCount(numThreads, lines.size()), grain, [&](size_t i)
+		{
+			documentsOut[i].result = load(lines[i], documentsOut[i].document);
+		});
+		return firstError(documentsOut);
+	}
+
+	Result loadDirectory(str_view directoryPath, std::vector<BatchDocument>& documentsOut, uint32_t numThreads)
+	{
+		documentsOut.clear();
+		std::vector<std::filesystem::path> paths;
+		std::error_code error;
+		for (std::filesystem::directory_iterator it(std::filesystem::path(directoryPath), error), end; !error && it != end; it.increment(error))
+		{
+			if (it->is_regular_file(error) && it->path().extension() == ".json") { paths.push_back(it->path()); }
+		}
+		RETURN_ERROR_IF(error, Error_File);
+		std::sort(paths.begin(), paths.end());
+
+		documentsOut.reserve(paths.size());
+		for (const std::filesystem::path& path : paths) { documentsOut.push_back(BatchDocument{ Document(), Result::OK, 0, path.string() }); }
+
+		// files are large units of work, one at a time
+		parallelFor(paths.size(), resolveThreadCount(numThreads, paths.size()), 1, [&](size_t i)
+		{
+			documentsOut[i].result = loadFromFile(documentsOut[i].path, documentsOut[i].document);
+		});
+		return firstError(documentsOut);
+	}
+
+}
@@ -0,0 +1,25 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include "Document.h"
+
+namespace JSON
+{
+	// one parsed document of a batch, results keep the order of the input
+	struct BatchDocument
+	{
+		Document document;
+		Result result = Result::OK;
+		size_t line = 0; // 1-based line in the NDJSON text, 0 for files
+		str_t path; // source file for directory batches
+	};
+
+	/* parses newline-delimited JSON, one document per non-empty line, spread over numThreads worker threads
+	documents point into the text, so it must outlive them
+	numThreads 0 uses one thread per hardware thread, returns the first error in input order or OK */
+	Result loadNDJSON(str_view text, std::vector<BatchDocument>& documentsOut, uint32_t numThreads = 0);
+
+	/* parses every .json file directly in the directory, files are sorted by path and memory-mapped
+	returns Error_File if the directory can not be read, otherwise the first per-file error in path order or OK */
+	Result loadDirectory(str_view directoryPath, std::vector<BatchDocument>& documentsOut, uint32_t numThreads = 0);
+
+}
@@ -0,0 +1,887 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#include "Benchmark.h"
+#include "Batch.h"
+#include "Bind.h"
+#include "Document.h"
+#include "Lazy.h"
+#include "Binary.h"
+#include "Writer.h"
+#include "StructuralIndex.h"
+#include "MappedFile.h"
+#include "Stream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+	#include <psapi.h>
+	#ifdef _MSC_VER
+		#pragma comment(lib, "psapi.lib")
+	#endif
+#else
+	#include <sys/resource.h>
+#endif
+
+namespace
+{
+	using JSON::Result;
+	using JSON::ObjectType;
+
+	// incremented by the replaced global operator new of the standalone benchmark
+	std::atomic<uint64_t> allocationCount{ 0 };
+#ifdef JSON_RPG_BENCHMARK_MAIN
+	constexpr bool COUNTS_ALLOCATIONS = true;
+#else
+	constexpr bool COUNTS_ALLOCATIONS = false;
+#endif
+
+	size_t peakResidentBytes()
+	{
+	#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) { return 0; }
+		return counters.PeakWorkingSetSize;
+	#else
+		rusage usage{};
+		if (getrusage(RUSAGE_SELF, &usage)) { return 0; }
+		#ifdef __APPLE__
+			return static_cast<size_t>(usage.ru_maxrss); // bytes
+		#else
+			return static_cast<size_t>(usage.ru_maxrss) * 1024; // kilobytes
+		#endif
+	#endif
+	}
+
+	struct BenchCase
+	{
+		str_t name;
+		std::vector<str_t> documents;
+		std::vector<str_t> paths; // documents written to (or read from) files, in the same order
+		size_t bytes = 0;
+	};
+
+	// corpus generation, seeded so every run (and every commit) measures the same text
+
+	void appendNumber(str_t& s, int64_t n)
+	{
+		char_t buffer[24];
+		s.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), n).ptr);
+	}
+
+	void appendNumber(str_t& s, double n)
+	{
+		char_t buffer[32];
+		s.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), n).ptr);
+	}
+
+	// like the sector and material descriptions the engine loads
+	str_t generateSmallConfig(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<double> real(-1000.0, 1000.0);
+		str_t s = "{\n\t\"coordinates\": { \"x\": ";
+		appendNumber(s, static_cast<int64_t>(rng() % 64));
+		s += ", \"y\": ";
+		appendNumber(s, static_cast<int64_t>(rng() % 64));
+		s += " },\n\t\"objects\": [\n";
+		const size_t count = 1 + rng() % 6;
+		for (size_t i = 0; i < count; i++)
+		{
+			s += "\t\t{ \"mesh\": \"Models/object_";
+			appendNumber(s, static_cast<int64_t>(rng() % 1000));
+			s += ".obj\", \"transform\": { \"translation\": [";
+			for (int k = 0; k < 3; k++)
+			{
+				if (k) { s += ", "; }
+				appendNumber(s, real(rng));
+			}
+			s += "], \"scale\": ";
+			appendNumber(s, static_cast<int64_t>(1 + rng() % 200));
+			s += " }, \"shading\": { \"topology\": \"TRIANGLE_LIST\", \"cull\": ";
+			s += (rng() % 2) ? "true" : "false";
+			s += ", \"tint\": null } }";
+			s += (i + 1 < count) ? ",\n" : "\n";
+		}
+		s += "\t]\n}\n";
+		return s;
+	}
+
+	str_t generateDeepNesting(std::mt19937& rng, size_t depth)
+	{
+		str_t s;
+		str_t closing;
+		for (size_t i = 0; i < depth; i++)
+		{
+			if (i % 2)
+			{
+				s += "[";
+				appendNumber(s, static_cast<int64_t>(rng() % 100));
+				s += ",";
+				closing += "]";
+			}
+			else
+			{
+				s += "{\"level\":";
+				appendNumber(s, static_cast<int64_t>(i));
+				s += ",\"next\":";
+				closing += "}";
+			}
+		}
+		s += "null";
+		s.append(closing.rbegin(), closing.rend());
+		return s;
+	}
+
+	str_t generateNumericArray(std::mt19937& rng, size_t targetSize)
+	{
+		std::uniform_real_distribution<double> real(-1.0e6, 1.0e6);
+		std::uniform_int_distribution<int64_t> integer(INT64_MIN / 2, INT64_MAX / 2);
+		str_t s = "[";
+		while (s.size() < targetSize)
+		{
+			if (s.size() > 1) { s += ","; }
+			switch (rng() % 4)
+			{
+				case 0: appendNumber(s, integer(rng)); break;
+				case 1: appendNumber(s, static_cast<int64_t>(rng() % 1000)); break;
+				case 2: appendNumber(s, real(rng)); break;
+				default: appendNumber(s, real(rng) * 1.0e-300); break; // exponent form
+			}
+		}
+		s += "]";
+		return s;
+	}
+
+	str_t generateStrings(std::mt19937& rng, size_t targetSize, bool unicode)
+	{
+		static constexpr const char_t* words[] = { "lorem", "ipsum", "dolor", "sit", "amet", "vulkan", "sector", "mesh" };
+		// Latin, Cyrillic, CJK and emoji text, as raw UTF-8 and as escapes
+		static constexpr const char_t* unicodeWords[] = { "\xC3\xA9t\xC3\xA9", "\xD0\xBC\xD0\xB8\xD1\x80", "\xE4\xB8\x96\xE7\x95\x8C",
+			"\xF0\x9F\x98\x80", "\\u00e9", "\\u4e16\\u754c", "\\ud83d\\ude00" };
+		static constexpr const char_t* escapes[] = { "\\n", "\\t", "\\\"", "\\\\", "\\/", "\\u0001" };
+		str_t s = "[";
+		while (s.size() < targetSize)
+		{
+			if (s.size() > 1) { s += ","; }
+			s += "{\"id\":";
+			appendNumber(s, static_cast<int64_t>(rng() % 100000));
+			s += ",\"text\":\"";
+			const size_t length = 8 + rng() % 64;
+			for (size_t i = 0; i < length; i++)
+			{
+				if (i) { s += ' '; }
+				const uint32_t pick = rng() % 16;
+				if (unicode && pick < 8) { s += unicodeWords[pick % std::size(unicodeWords)]; }
+				else if (pick == 15) { s += escapes[rng() % std::size(escapes)]; }
+				else { s += words[rng() % std::size(words)]; }
+			}
+			s += "\"}";
+		}
+		s += "]";
+		return s;
+	}
+
+	std::vector<BenchCase> generateCorpus()
+	{
+		std::mt19937 rng(1234);
+		std::vector<BenchCase> cases(5);
+		cases[0].name = "small-configs";
+		for (int i = 0; i < 256; i++) { cases[0].documents.push_back(generateSmallConfig(rng)); }
+		cases[1].name = "deep-nesting";
+		for (int i = 0; i < 64; i++) { cases[1].documents.push_back(generateDeepNesting(rng, 1000)); }
+		cases[2].name = "numeric-array";
+		cases[2].documents.push_back(generateNumericArray(rng, 8 * 1024 * 1024));
+		cases[3].name = "string-heavy";
+		cases[3].documents.push_back(generateStrings(rng, 8 * 1024 * 1024, false));
+		cases[4].name = "unicode-heavy";
+		cases[4].documents.push_back(generateStrings(rng, 8 * 1024 * 1024, true));
+		return cases;
+	}
+
+	// writes the generated documents out for the file loader, false if the directory is not writable
+	bool writeCorpus(std::vector<BenchCase>& cases, const std::filesystem::path& directory)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+		for (BenchCase& benchCase : cases)
+		{
+			for (size_t i = 0; i < benchCase.documents.size(); i++)
+			{
+				const std::filesystem::path path = directory / (benchCase.name + "-" + std::to_string(i) + ".json");
+				std::ofstream file(path, std::ios::binary);
+				file.write(benchCase.documents[i].data(), static_cast<std::streamsize>(benchCase.documents[i].size()));
+				if (!file) { return false; }
+				benchCase.paths.push_back(path.string());
+			}
+		}
+		return true;
+	}
+
+	// every .json file of the directory as one case
+	bool readCorpusDirectory(const str_t& directory, BenchCase& caseOut)
+	{
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+		{
+			if (!entry.is_regular_file() || entry.path().extension() != ".json") { continue; }
+			JSON::MappedFile file;
+			if (!file.open(entry.path().string())) { return false; }
+			caseOut.documents.emplace_back(file.view());
+			caseOut.paths.push_back(entry.path().string());
+		}
+		caseOut.name = "corpus";
+		return !error;
+	}
+
+	// conformance
+
+	// bound types for the decode checks, shaped like the generated small configs and string documents
+	struct BenchCoordinates { int64_t x = 0; int64_t y = 0; };
+	struct BenchTransform { std::vector<double> translation; int64_t scale = 0; };
+	struct BenchShading { str_t topology; bool cull = false; }; // tint is null, it is skipped as an unknown member
+	struct BenchObject { str_t mesh; BenchTransform transform; BenchShading shading; };
+	struct BenchConfig { BenchCoordinates coordinates; std::vector<BenchObject> objects; };
+	struct BenchText { int64_t id = 0; str_t text; };
+}
+
+template<> struct JSON::Binding<BenchCoordinates>
+{
+	static constexpr auto fields = std::make_tuple(JSON_FIELD(BenchCoordinates, x), JSON_FIELD(BenchCoordinates, y));
+};
+template<> struct JSON::Binding<BenchTransform>
+{
+	static constexpr auto fields = std::make_tuple(JSON_FIELD(BenchTransform, translation), JSON_FIELD(BenchTransform, scale));
+};
+template<> struct JSON::Binding<BenchShading>
+{
+	static constexpr auto fields = std::make_tuple(JSON_FIELD(BenchShading, topology), JSON_FIELD(BenchShading, cull));
+};
+template<> struct JSON::Binding<BenchObject>
+{
+	static constexpr auto fields = std::make_tuple(JSON_FIELD(BenchObject, mesh), JSON_FIELD(BenchObject, transform), JSON_FIELD(BenchObject, shading));
+};
+template<> struct JSON::Binding<BenchConfig>
+{
+	static constexpr auto fields = std::make_tuple(JSON_FIELD(BenchConfig, coordinates), JSON_FIELD(BenchConfig, objects));
+};
+template<> struct JSON::Binding<BenchText>
+{
+	static constexpr auto fields = std::make_tuple(JSON_FIELD(BenchText, id), JSON_FIELD(BenchText, text));
+};
+
+namespace
+{
+	// decoded values against the Document tree of the same text
+	bool matches(const JSON::Node& node, int64_t value) { return node.isInteger() && node.asInt() == value; }
+	bool matches(const JSON::Node& node, double value) { return node.type == ObjectType::Number && node.asDouble() == value; }
+	bool matches(const JSON::Node& node, bool value) { return node.type == ObjectType::Boolean && (node.getValue() == "true") == value; }
+	bool matches(const JSON::Node& node, const str_t& value) { return node.type == ObjectType::String && node.getValue() == value; }
+
+	template<typename T>
+	bool matches(const JSON::Node& node, const std::vector<T>& values)
+	{
+		if (node.type != ObjectType::Array || node.size() != values.size()) { return false; }
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			if (!matches(node[i], values[i])) { return false; }
+		}
+		return true;
+	}
+
+	bool matches(const JSON::Node& node, const BenchCoordinates& value) { return matches(node["x"], value.x) && matches(node["y"], value.y); }
+	bool matches(const JSON::Node& node, const BenchTransform& value) { return matches(node["translation"], value.translation) && matches(node["scale"], value.scale); }
+	bool matches(const JSON::Node& node, const BenchShading& value) { return matches(node["topology"], value.topology) && matches(node["cull"], value.cull); }
+	bool matches(const JSON::Node& node, const BenchObject& value)
+	{
+		return matches(node["mesh"], value.mesh) && matches(node["transform"], value.transform) && matches(node["shading"], value.shading);
+	}
+	bool matches(const JSON::Node& node, const BenchConfig& value) { return matches(node["coordinates"], value.coordinates) && matches(node["objects"], value.objects); }
+	bool matches(const JSON::Node& node, const BenchText& value) { return matches(node["id"], value.id) && matches(node["text"], value.text); }
+
+	// compact text of a loaded Object, lone values are not wrapped so toString() does not cover them
+	str_t serialize(const JSON::Object& object)
+	{
+		if (object.isContainer()) { return object.toString(false); }
+		JSON::Writer writer;
+		writer.value(object);
+		return writer.release();
+	}
+
+	str_t serialize(const JSON::Node& node)
+	{
+		JSON::Writer writer;
+		writer.value(node);
+		return writer.release();
+	}
+
+	void writeLazy(JSON::Writer& writer, const JSON::LazyValue& value)
+	{
+		switch (value.type)
+		{
+			case ObjectType::Object:
+				writer.beginObject();
+				for (const JSON::LazyValue& member : value)
+				{
+					str_t name;
+					JSON::unescapeString(member.name, name);
+					writer.key(name);
+					writeLazy(writer, member);
+				}
+				writer.endObject();
+				break;
+			case ObjectType::Array:
+				writer.beginArray();
+				for (const JSON::LazyValue& member : value) { writeLazy(writer, member); }
+				writer.endArray();
+				break;
+			case ObjectType::String: writer.string(value.getString()); break;
+			case ObjectType::Number:
+			case ObjectType::Boolean:
+			case ObjectType::Null: writer.numberText(value.getValue()); break;
+			default: writer.null(); break;
+		}
+	}
+
+	// walks the lazy value member by member, the way a reader of the document would visit it
+	str_t serialize(const JSON::LazyValue& value)
+	{
+		JSON::Writer writer;
+		writeLazy(writer, value);
+		return writer.release();
+	}
+
+	// events of a stream as text, to compare runs that split the input differently
+	struct EventRecorder : JSON::Handler
+	{
+		str_t events;
+
+		void beginObject() override { events += '{'; }
+		void endObject() override { events += '}'; }
+		void beginArray() override { events += '['; }
+		void endArray() override { events += ']'; }
+		void key(str_view name) override { events.append("K:").append(name) += '\n'; }
+		void value(ObjectType type, str_view text) override { events.append(std::to_string(static_cast<int>(type))).append(":").append(text) += '\n'; }
+	};
+
+	// feeds text[0, split) as one chunk, then the rest in chunks of chunkSize bytes
+	Result streamChunks(str_view text, size_t split, size_t chunkSize, str_t& eventsOut)
+	{
+		EventRecorder recorder;
+		JSON::StreamParser parser(recorder);
+		Result result = parser.feed(text.substr(0, split));
+		for (size_t pos = split; pos < text.size() && result == Result::OK; pos += chunkSize) { result = parser.feed(text.substr(pos, chunkSize)); }
+		if (result == Result::OK) { result = parser.finish(); }
+		eventsOut = std::move(recorder.events);
+		return result;
+	}
+
+	// the same with the pull parser, its events recorded in the same form
+	Result pullChunks(str_view text, size_t split, size_t chunkSize, str_t& eventsOut)
+	{
+		EventRecorder recorder;
+		JSON::PullParser parser;
+		parser.feed(text.substr(0, split));
+		size_t pos = split;
+		JSON::Event event;
+		while (true)
+		{
+			const Result result = parser.next(event);
+			if (result != Result::OK)
+			{
+				eventsOut = std::move(recorder.events);
+				return result;
+			}
+			switch (event.type)
+			{
+				case JSON::EventType::NeedInput:
+					if (pos < text.size()) { parser.feed(text.substr(pos, chunkSize)); pos += chunkSize; }
+					else { parser.finish(); }
+					break;
+				case JSON::EventType::End:
+					eventsOut = std::move(recorder.events);
+					return Result::OK;
+				case JSON::EventType::BeginObject: recorder.beginObject(); break;
+				case JSON::EventType::EndObject: recorder.endObject(); break;
+				case JSON::EventType::BeginArray: recorder.beginArray(); break;
+				case JSON::EventType::EndArray: recorder.endArray(); break;
+				case JSON::EventType::Key: recorder.key(event.data); break;
+				case JSON::EventType::Value: recorder.value(event.valueType, event.data); break;
+			}
+		}
+	}
+
+	// errors load() finds in the whole text before parsing, a stream may report an earlier error instead (see StreamParser)
+	bool isWholeTextError(Result result)
+	{
+		return result == Result::Error_Lexer_UnterminatedString || result == Result::Error_Lexer_InvalidEncoding
+			|| result == Result::Error_Lexer_IncompleteUnicodeInString;
+	}
+
+	class Conformance
+	{
+	public:
+		Conformance(std::ostream& out, JSON::BenchmarkSummary& summary) : out{ out }, summary{ summary } {};
+
+		void check(bool passed, str_view caseName, size_t document, str_view what)
+		{
+			summary.conformanceChecks++;
+			if (passed) { return; }
+			summary.conformanceFailures++;
+			out << "conformance: " << caseName << " #" << document << ": " << what << "\n";
+		}
+
+		// every way of loading a document has to agree, and its serialization has to load back to itself
+		void checkDocument(str_view caseName, size_t i, str_view text)
+		{
+			JSON::Object object;
+			check(JSON::load(text, object) == Result::OK, caseName, i, "load failed");
+			const str_t expected = serialize(object);
+
+			JSON::Document document;
+			check(JSON::load(text, document) == Result::OK && serialize(document.root()) == expected, caseName, i, "Document differs from Object");
+
+			JSON::LazyDocument lazy;
+			check(JSON::load(text, lazy) == Result::OK && lazy.validate() == Result::OK, caseName, i, "LazyDocument rejects the text");
+			check(serialize(lazy.root()) == expected, caseName, i, "LazyDocument differs from Object");
+
+			JSON::Object reloaded;
+			check(JSON::load(expected, reloaded) == Result::OK && serialize(reloaded) == expected, caseName, i, "compact output does not load back");
+			if (object.isContainer())
+			{
+				check(JSON::load(object.toString(true), reloaded) == Result::OK && serialize(reloaded) == expected, caseName, i, "pretty output does not load back");
+			}
+
+			str_t encoded;
+			JSON::BinaryDocument binary;
+			const bool binaryOK = JSON::encodeBinary(object, encoded) == Result::OK && binary.assign(std::move(encoded)) == Result::OK;
+			JSON::Writer writer;
+			if (binaryOK) { writer.value(binary.root()); }
+			check(binaryOK && (!object.isContainer() || binary.toString(false) == expected) && (object.isContainer() || writer.view() == expected),
+				caseName, i, "binary encoding differs");
+
+			// the vectorized stages have to produce exactly what the scalar one does
+			const JSON::SimdLevel level = JSON::getSimdLevel();
+			for (JSON::SimdLevel other : { JSON::SimdLevel::Scalar, JSON::SimdLevel::SSE42, JSON::SimdLevel::AVX2 })
+			{
+				if (other > JSON::detectSimdLevel() || other == level) { continue; }
+				JSON::setSimdLevel(other);
+				check(JSON::load(text, reloaded) == Result::OK && serialize(reloaded) == expected, caseName, i, "result depends on the SIMD level");
+			}
+			JSON::setSimdLevel(level);
+
+			checkChunked(caseName, i, text);
+			checkTranscode(caseName, i, text);
+			if (caseName == "small-configs") { checkDecode<BenchConfig>(caseName, i, text); }
+			else if (caseName == "numeric-array") { checkDecode<std::vector<double>>(caseName, i, text); }
+			else if (caseName == "string-heavy" || caseName == "unicode-heavy") { checkDecode<std::vector<BenchText>>(caseName, i, text); }
+		}
+
+		// typed binding has to read the same values the Document tree holds
+		template<typename T>
+		void checkDecode(str_view caseName, size_t i, str_view text)
+		{
+			T value{};
+			JSON::Document document;
+			const bool same = JSON::decode(text, value) == Result::OK && JSON::load(text, document) == Result::OK && matches(document.root(), value);
+			check(same, caseName, i, "decode differs from Document");
+		}
+
+		// the vectorized transcoder against the codepoint at a time utf8to32be, at every SIMD level (valid UTF-8 only)
+		void checkTranscode(str_view caseName, size_t i, str_view text)
+		{
+			if (JSON::validateUTF8(text) != Result::OK) { return; }
+			std::u32string expected;
+			for (size_t pos = 0; pos < text.size();) { expected += static_cast<char32_t>(JSONTextUtils::utf8to32be(text, pos)); }
+
+			const JSON::SimdLevel level = JSON::getSimdLevel();
+			bool same = true;
+			for (JSON::SimdLevel other : { JSON::SimdLevel::Scalar, JSON::SimdLevel::SSE42, JSON::SimdLevel::AVX2 })
+			{
+				if (other > JSON::detectSimdLevel()) { continue; }
+				JSON::setSimdLevel(other);
+				const std::u32string big = JSONTextUtils::utf8to32str(text);
+				const std::u32string little = JSONTextUtils::utf8to32str(text, true);
+				same = same && big == expected && little.size() == expected.size()
+					&& std::equal(little.begin(), little.end(), expected.begin(), [](char32_t a, char32_t b) { return a == JSONTextUtils::swapEndian32(b); });
+			}
+			JSON::setSimdLevel(level);
+			check(same, caseName, i, "utf8to32str differs from utf8to32be");
+		}
+
+		/* the documents of a case as NDJSON, one compact document per line, loadNDJSON has to give what load() gives per line
+		lines are spread over several threads, results and line numbers have to stay in input order */
+		void checkBatch(str_view caseName, const std::vector<str_t>& lines)
+		{
+			str_t text;
+			for (const str_t& line : lines) { text.append(line) += '\n'; }
+			std::vector<JSON::BatchDocument> batch;
+			const Result result = JSON::loadNDJSON(text, batch, 4);
+
+			bool same = batch.size() == lines.size();
+			Result firstError = Result::OK;
+			for (size_t i = 0; same && i < lines.size(); i++)
+			{
+				JSON::Document document;
+				const Result expected = JSON::load(lines[i], document);
+				if (firstError == Result::OK) { firstError = expected; }
+				same = batch[i].result == expected && batch[i].line == i + 1
+					&& (expected != Result::OK || serialize(batch[i].document.root()) == serialize(document.root()));
+			}
+			check(same && result == firstError, caseName, 0, "loadNDJSON differs from load() per line");
+		}
+
+		/* streaming has to give the same events and result wherever the text is split, and accept what load() accepts
+		short texts are split at every offset and also fed a byte at a time, long ones are split at 16 offsets */
+		void checkChunked(str_view caseName, size_t i, str_view text)
+		{
+			JSON::Document document;
+			const Result loaded = JSON::load(text, document);
+			str_t expected;
+			const Result whole = streamChunks(text, text.size(), 1, expected);
+			check((whole == Result::OK) == (loaded == Result::OK) && (whole == loaded || isWholeTextError(loaded)), caseName, i, "StreamParser result differs from load()");
+
+			const bool isShort = text.size() <= 4096;
+			const size_t step = isShort ? 1 : text.size() / 16;
+			bool splitsAgree = true;
+			str_t pushed, pulled;
+			for (size_t split = 0; split <= text.size() && splitsAgree; split += step)
+			{
+				splitsAgree = streamChunks(text, split, text.size(), pushed) == whole && pullChunks(text, split, text.size(), pulled) == whole
+					&& (whole != Result::OK || (pushed == expected && pulled == expected));
+			}
+			if (isShort && splitsAgree)
+			{
+				splitsAgree = streamChunks(text, 0, 1, pushed) == whole && pullChunks(text, 0, 1, pulled) == whole
+					&& (whole != Result::OK || (pushed == expected && pulled == expected));
+			}
+			check(splitsAgree, caseName, i, "chunked result depends on where the text is split");
+		}
+
+		// hand-written cases with known results
+		void checkFixedCases()
+		{
+			struct ValidCase { str_view text; str_view expected; };
+			static constexpr ValidCase valid[] =
+			{
+				{ "{}", "{}" },
+				{ " [ ] ", "[]" },
+				{ "[1,-0,1.5e3,-2E-2,9223372036854775807]", "[1,-0,1.5e3,-2E-2,9223372036854775807]" },
+				{ "{\"a\\u0062\":\"\\ud83d\\ude00\\n\\/\"}", "{\"ab\":\"\xF0\x9F\x98\x80\\n/\"}" },
+				{ "{\"a\":{\"b\":[null,false,true,\"\"]}}", "{\"a\":{\"b\":[null,false,true,\"\"]}}" },
+				{ "\"lone\\tvalue\"", "\"lone\\tvalue\"" },
+				{ " 42 ", "42" },
+				{ "[\"\xC3\xA9\xE4\xB8\x96\xF0\x9F\x98\x80\"]", "[\"\xC3\xA9\xE4\xB8\x96\xF0\x9F\x98\x80\"]" },
+			};
+			for (size_t i = 0; i < std::size(valid); i++)
+			{
+				JSON::Object object;
+				check(JSON::load(valid[i].text, object) == Result::OK && serialize(object) == valid[i].expected, "fixed-valid", i, valid[i].text);
+				checkDocument("fixed-valid", i, valid[i].text);
+			}
+
+			struct InvalidCase { str_view text; Result expected; };
+			static constexpr InvalidCase invalid[] =
+			{
+				{ "", Result::Error_Parser_NoTokens },
+				{ "{\"a\":1,}", Result::Error_Parser_UnexpectedSeparator },
+				{ "{,}", Result::Error_Parser_UnexpectedSeparator },
+				{ "[1 2]", Result::Error_Parser_MissingSeparator },
+				{ "{\"a\" 1}", Result::Error_Parser_LoneValue },
+				{ "{\"a\":}", Result::Error_Parser_InvalidKeyValuePair },
+				{ "[\"a\":1]", Result::Error_Parser_NamedValueInArray },
+				{ "{\"a\":[1}", Result::Error_Parser_IllegalClosingToken },
+				{ "\"a\" \"b\"", Result::Error_Parser_InvalidRoot },
+				{ "[\"abc", Result::Error_Lexer_UnterminatedString },
+				{ "[\"\\q\"]", Result::Error_Lexer_InvalidEscape },
+				{ "[\"\\u12\"]", Result::Error_Lexer_InvalidEscape },
+				{ "[\"\xC0\x80\"]", Result::Error_Lexer_IncompleteUnicodeInString }, // overlong
+				{ "[\"\xED\xA0\x80\"]", Result::Error_Lexer_IncompleteUnicodeInString }, // surrogate
+				{ "\xFF", Result::Error_Lexer_InvalidEncoding },
+				{ "[tru]", Result::Error_Lexer_IllegalToken },
+				{ "[01]", Result::Error_Lexer_InvalidNumber },
+				{ "[1e]", Result::Error_Lexer_InvalidNumber },
+				{ "[true-0]", Result::Error_Lexer_IllegalToken },
+				{ "[ {\"k3\":false0},\nfalse]", Result::Error_Lexer_IllegalToken },
+				{ "[null\"a\"]", Result::Error_Parser_MissingSeparator },
+			};
+			for (size_t i = 0; i < std::size(invalid); i++)
+			{
+				JSON::Object object;
+				JSON::Document document;
+				JSON::LazyDocument lazy;
+				check(JSON::load(invalid[i].text, object) == invalid[i].expected, "fixed-invalid", i, invalid[i].text);
+				check(JSON::load(invalid[i].text, document) == invalid[i].expected, "fixed-invalid", i, invalid[i].text);
+				check(JSON::load(invalid[i].text, lazy) != Result::OK || lazy.validate() != Result::OK, "fixed-invalid", i, invalid[i].text);
+				checkChunked("fixed-invalid", i, invalid[i].text);
+			}
+
+			// valid and invalid lines mixed, the empty text is left out since loadNDJSON skips empty lines
+			std::vector<str_t> lines;
+			for (size_t i = 0; i < std::max(std::size(valid), std::size(invalid)); i++)
+			{
+				if (i < std::size(valid)) { lines.emplace_back(valid[i].text); }
+				if (i < std::size(invalid) && !invalid[i].text.empty() && invalid[i].text.find('\n') == str_view::npos) { lines.emplace_back(invalid[i].text); }
+			}
+			checkBatch("fixed-batch", lines);
+		}
+
+		// random edits of valid texts, LazyDocument has to accept exactly what load() does and read the same values from it
+		void checkLazyFuzz()
+		{
+			static constexpr str_view seeds[] =
+			{
+				"{\"a\":[1,-2.5e3,true,false,null],\"b\":{\"c\":\"d\"}}",
+				"[{\"k\\u0062\":\"\\ud83d\\ude00\"},[[]],{},\"\xC3\xA9\"]",
+				"{\"x\":{\"y\":{\"z\":[0,1e-2,\"\\n\"]}},\"w\":[]}",
+				"[\"a\",\"b\\\"\",12,{\"n\":null}]",
+				" 42 ",
+			};
+			static constexpr str_view pieces[] =
+			{
+				"{", "}", "[", "]", ",", ":", "\"", "\\", "\"k\"", "0", "1", "-", ".5", "e3", "true", "nul", "f", " ", "\n", "\xC3\xA9", "\xFF", "\\u00e9",
+			};
+			std::mt19937 rng(4321);
+			for (size_t i = 0; i < 20000; i++)
+			{
+				str_t text(seeds[rng() % std::size(seeds)]);
+				const size_t edits = 1 + rng() % 3;
+				for (size_t e = 0; e < edits; e++)
+				{
+					const size_t pos = rng() % (text.size() + 1);
+					const str_view piece = pieces[rng() % std::size(pieces)];
+					switch (rng() % 3)
+					{
+						case 0: text.insert(pos, piece); break;
+						case 1: text.erase(pos, 1 + rng() % 3); break;
+						default: text.replace(pos, 1, piece); break;
+					}
+				}
+
+				JSON::Object object;
+				JSON::LazyDocument lazy;
+				const bool objectOK = JSON::load(text, object) == Result::OK;
+				const bool lazyOK = JSON::load(text, lazy) == Result::OK && lazy.validate() == Result::OK;
+				check(lazyOK == objectOK, "lazy-fuzz", i, text);
+				if (lazyOK && objectOK) { check(serialize(lazy.root()) == serialize(object), "lazy-fuzz", i, text); }
+			}
+		}
+
+	private:
+		std::ostream& out;
+		JSON::BenchmarkSummary& summary;
+	};
+
+	// measurement
+
+	struct Measurement
+	{
+		str_view operation;
+		double megabytesPerSecond = 0.0;
+		double allocationsPerDocument = 0.0;
+	};
+
+	// runs round (one pass over all documents of a case) until targetBytes have been processed, after one warm-up pass
+	template<typename Round>
+	Measurement measure(str_view operation, size_t bytesPerRound, size_t documentsPerRound, size_t targetBytes, Round&& round)
+	{
+		round();
+		const size_t rounds = std::max<size_t>(1, (targetBytes + bytesPerRound - 1) / std::max<size_t>(bytesPerRound, 1));
+		const uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t r = 0; r < rounds; r++) { round(); }
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		const uint64_t allocations = allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+
+		Measurement measurement;
+		measurement.operation = operation;
+		measurement.megabytesPerSecond = static_cast<double>(bytesPerRound * rounds) / (1024.0 * 1024.0) / std::max(seconds, 1e-9);
+		measurement.allocationsPerDocument = static_cast<double>(allocations) / static_cast<double>(rounds * documentsPerRound);
+		return measurement;
+	}
+
+	std::vector<Measurement> measureCase(const BenchCase& benchCase, size_t targetBytes)
+	{
+		std::vector<Measurement> measurements;
+		const size_t count = benchCase.documents.size();
+		std::vector<JSON::Object> objects(count);
+		measurements.push_back(measure("load", benchCase.bytes, count, targetBytes, [&]
+		{
+			for (size_t i = 0; i < count; i++) { JSON::load(benchCase.documents[i], objects[i]); }
+		}));
+
+		// one document reused for all loads, the way a loader that keeps its arena would use it
+		JSON::Document document;
+		measurements.push_back(measure("loadDocument", benchCase.bytes, count, targetBytes, [&]
+		{
+			for (const str_t& text : benchCase.documents) { JSON::load(text, document); }
+		}));
+
+		if (benchCase.paths.size() == count)
+		{
+			measurements.push_back(measure("loadFromFile", benchCase.bytes, count, targetBytes, [&]
+			{
+				for (size_t i = 0; i < count; i++) { JSON::loadFromFile(benchCase.paths[i], objects[i]); }
+			}));
+		}
+
+		size_t outputBytes = 0;
+		for (const JSON::Object& object : objects) { outputBytes += object.toString(false).size(); }
+		str_t output;
+		measurements.push_back(measure("toString", outputBytes, count, targetBytes, [&]
+		{
+			for (const JSON::Object& object : objects) { output = object.toString(false); }
+		}));
+		return measurements;
+	}
+}
+
+namespace JSON
+{
+	Result runBenchmark(const BenchmarkOptions& options, std::ostream& out, BenchmarkSummary& summaryOut)
+	{
+		summaryOut = BenchmarkSummary();
+		std::vector<BenchCase> cases = generateCorpus();
+		RETURN_ERROR_IF(!writeCorpus(cases, options.workDirectory), Error_File);
+		if (!options.corpusDirectory.empty())
+		{
+			BenchCase corpus;
+			RETURN_ERROR_IF(!readCorpusDirectory(options.corpusDirectory, corpus), Error_File);
+			if (!corpus.documents.empty()) { cases.push_back(std::move(corpus)); }
+		}
+		for (BenchCase& benchCase : cases)
+		{
+			for (const str_t& text : benchCase.documents) { benchCase.bytes += text.size(); }
+		}
+
+		Conformance conformance(out, summaryOut);
+		conformance.checkFixedCases();
+		conformance.checkLazyFuzz();
+		for (const BenchCase& benchCase : cases)
+		{
+			std::vector<str_t> lines;
+			for (size_t i = 0; i < benchCase.documents.size(); i++)
+			{
+				conformance.checkDocument(benchCase.name, i, benchCase.documents[i]);
+				JSON::Object object;
+				if (JSON::load(benchCase.documents[i], object) == Result::OK) { lines.push_back(serialize(object)); }
+			}
+			conformance.checkBatch(benchCase.name, lines);
+		}
+		out << "conformance: " << summaryOut.conformanceChecks - summaryOut.conformanceFailures << "/" << summaryOut.conformanceChecks << " passed\n";
+
+		std::ofstream resultsFile(options.resultsPath, std::ios::binary);
+		RETURN_ERROR_IF(!resultsFile, Error_File);
+		StreamSink sink(resultsFile);
+		Writer results(sink, WriteMode::Pretty);
+		results.beginObject();
+		results.key("label"); results.string(options.label);
+		results.key("simdLevel"); results.string(simdLevelToString(getSimdLevel()));
+		results.key("allocationsCounted"); results.boolean(COUNTS_ALLOCATIONS);
+		results.key("conformance");
+		results.beginObject();
+		results.key("checks"); results.number(static_cast<int64_t>(summaryOut.conformanceChecks));
+		results.key("failures"); results.number(static_cast<int64_t>(summaryOut.conformanceFailures));
+		results.endObject();
+
+		out << std::fixed << std::setprecision(1);
+		results.key("cases");
+		results.beginArray();
+		for (const BenchCase& benchCase : cases)
+		{
+			out << benchCase.name << " (" << benchCase.documents.size() << " documents, " << benchCase.bytes / 1024 << " KiB)\n";
+			results.beginObject();
+			results.key("name"); results.string(benchCase.name);
+			results.key("documents"); results.number(static_cast<int64_t>(benchCase.documents.size()));
+			results.key("bytes"); results.number(static_cast<int64_t>(benchCase.bytes));
+			results.key("operations");
+			results.beginObject();
+			for (const Measurement& measurement : measureCase(benchCase, options.bytesPerMeasurement))
+			{
+				out << "\t" << std::setw(14) << std::left << measurement.operation << std::right << std::setw(10) << measurement.megabytesPerSecond << " MB/s";
+				if (COUNTS_ALLOCATIONS) { out << std::setw(10) << measurement.allocationsPerDocument << " allocations/document"; }
+				out << "\n";
+				results.key(measurement.operation);
+				results.beginObject();
+				results.key("mbPerSecond"); results.number(measurement.megabytesPerSecond);
+				results.key("allocationsPerDocument"); results.number(measurement.allocationsPerDocument);
+				results.endObject();
+			}
+			results.endObject();
+			results.endObject();
+		}
+		results.endArray();
+
+		const size_t peakRSS = peakResidentBytes();
+		out << "peak RSS " << peakRSS / (1024 * 1024) << " MiB\n";
+		results.key("peakRssBytes"); results.number(static_cast<int64_t>(peakRSS));
+		results.endObject();
+		results.flush();
+		RETURN_ERROR_IF(!resultsFile, Error_File);
+		return Result::OK;
+	}
+
+}
+
+#ifdef JSON_RPG_BENCHMARK_MAIN
+// counting allocation functions, the array and nothrow forms forward to these
+void* operator new(size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1)) { return p; }
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+int main(int argc, char** argv)
+{
+	JSON::BenchmarkOptions options;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const str_view option = argv[i];
+		const str_view value = argv[i + 1];
+		if (option == "--corpus") { options.corpusDirectory = value; }
+		else if (option == "--work") { options.workDirectory = value; }
+		else if (option == "--out") { options.resultsPath = value; }
+		else if (option == "--label") { options.label = value; }
+		else if (option == "--mb") { options.bytesPerMeasurement = static_cast<size_t>(std::atoll(argv[i + 1])) * 1024 * 1024; }
+		else if (option == "--simd")
+		{
+			if (value == "scalar") { JSON::setSimdLevel(JSON::SimdLevel::Scalar); }
+			else if (value == "sse4.2") { JSON::setSimdLevel(JSON::SimdLevel::SSE42); }
+			else if (value == "avx2") { JSON::setSimdLevel(JSON::SimdLevel::AVX2); }
+		}
+		else
+		{
+			std::cout << "unknown option " << option << "\n";
+			return 2;
+		}
+	}
+
+	JSON::BenchmarkSummary summary;
+	const JSON::Result result = JSON::runBenchmark(options, std::cout, summary);
+	if (result != JSON::Result::OK)
+	{
+		std::cout << "benchmark failed with error " << static_cast<int>(result) << "\n";
+		return 2;
+	}
+	return summary.conformanceFailures ? 1 : 0;
+}
+#endif
@@ -0,0 +1,40 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include "Parser.h"
+
+#include <ostream>
+
+/* throughput benchmark and conformance check for the parser
+the corpus is generated (small configs, deep nesting, numeric arrays, string and Unicode heavy text) and can be
+extended with the .json files of a directory, every document of it also goes through the conformance checks
+so a change that makes the parser faster but changes its results fails the run
+
+the standalone benchmark is Benchmark.cpp compiled with JSON_RPG_BENCHMARK_MAIN defined, together with the other json-rpg
+sources, it replaces the global allocation functions to count allocations, so it is kept out of the engine build
+	benchmark [--corpus dir] [--work dir] [--out results.json] [--label name] [--mb megabytes] [--simd scalar|sse4.2|avx2]
+the exit code is 1 if any conformance check fails */
+
+namespace JSON
+{
+	struct BenchmarkOptions
+	{
+		str_t corpusDirectory; // .json files run in addition to the generated corpus, none if empty
+		str_t workDirectory = "json-rpg-bench"; // the generated corpus is written here for the file loader
+		str_t resultsPath = "json-rpg-bench.json";
+		str_t label; // stored in the results to tell runs apart, e.g. the commit measured
+		size_t bytesPerMeasurement = 64 * 1024 * 1024; // each operation repeats over a case until this much text is processed
+	};
+
+	struct BenchmarkSummary
+	{
+		size_t conformanceChecks = 0;
+		size_t conformanceFailures = 0;
+	};
+
+	/* runs the conformance checks and measures load (Object and Document), loadFromFile and toString on every case
+	the checks hold every reader against load(): Document, LazyDocument, StreamParser and PullParser with the text split in chunks,
+	loadNDJSON over each case as one batch, decode into bound types, and utf8to32str against utf8to32be
+	results are written to options.resultsPath as JSON and printed to out, failed checks are listed in out */
+	Result runBenchmark(const BenchmarkOptions& options, std::ostream& out, BenchmarkSummary& summaryOut);
+
+}
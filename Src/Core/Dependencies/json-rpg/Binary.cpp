@@ -0,0 +1,395 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#include "Binary.h"
+#include "KeyIndex.h"
+#include "Number.h"
+#include "Writer.h"
+
+#include <algorithm>
+#include <bit>
+#include <unordered_map>
+
+namespace
+{
+	using JSON::ObjectType;
+	using JSON::Result;
+
+	constexpr char_t BINARY_MAGIC[4] = { 'J', 'R', 'P', 'B' };
+
+	struct BinaryHeader
+	{
+		char_t magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint64_t sourceSize;
+		uint32_t rootOffset;
+		uint32_t totalSize;
+	};
+	static_assert(sizeof(BinaryHeader) == 32);
+
+	constexpr uint32_t INTEGER_FLAG = 1u << 8;
+
+	uint32_t read32(const char_t* p)
+	{
+		uint32_t v;
+		std::memcpy(&v, p, 4);
+		return v;
+	}
+
+	str_view readString(const char_t* data, uint32_t offset)
+	{
+		return str_view(data + offset + 4, read32(data + offset));
+	}
+
+	BinaryHeader readHeader(str_view data)
+	{
+		BinaryHeader header;
+		std::memcpy(&header, data.data(), sizeof(header));
+		return header;
+	}
+
+	// writes records depth-first, a container's member offsets are filled in as its members are written
+	class Encoder
+	{
+	public:
+		explicit Encoder(str_t& out) : out{ out } {};
+
+		uint32_t encode(const JSON::Object& object)
+		{
+			const uint32_t nameOffset = putName(object.name);
+			const uint32_t tag = static_cast<uint32_t>(object.type) | (object.integer ? INTEGER_FLAG : 0);
+
+			if (object.isContainer())
+			{
+				const auto count = static_cast<uint32_t>(object.subobjects.size());
+				const uint32_t capacity = (object.type == ObjectType::Object && count >= JSON::KEY_INDEX_MIN_MEMBERS) ? JSON::keyIndexCapacity(count) : 0;
+				const uint32_t record = reserve(16 + (static_cast<size_t>(count) + capacity) * 4);
+				if (tooLarge) { return 0; }
+				write32(record, tag);
+				write32(record + 4, nameOffset);
+				write32(record + 8, count);
+				write32(record + 12, capacity);
+				for (uint32_t i = 0; i < count; i++)
+				{
+					const uint32_t member = encode(object.subobjects[i]);
+					if (tooLarge) { return 0; }
+					write32(record + 16 + i * 4, member);
+				}
+				if (capacity)
+				{
+					std::vector<uint32_t> slots(capacity);
+					JSON::buildKeyIndex(slots.data(), capacity, count, [&](uint32_t m) { return str_view(object.subobjects[m].name); });
+					std::memcpy(out.data() + record + 16 + count * 4, slots.data(), capacity * 4);
+				}
+				return record;
+			}
+
+			const uint32_t record = reserve(object.type == ObjectType::Number ? 16 : 8);
+			if (tooLarge) { return 0; }
+			write32(record, tag);
+			write32(record + 4, nameOffset);
+			if (object.type == ObjectType::Number)
+			{
+				if (object.integer) { std::memcpy(out.data() + record + 8, &object.intValue, 8); }
+				else { std::memcpy(out.data() + record + 8, &object.doubleValue, 8); }
+			}
+			putString(object.value); // directly after the record
+			return record;
+		}
+
+		// appends n zeroed bytes rounded up to 4, returns their offset
+		uint32_t reserve(size_t n)
+		{
+			const size_t offset = out.size();
+			const size_t padded = (n + 3) & ~size_t(3);
+			if (offset + padded > UINT32_MAX)
+			{
+				tooLarge = true;
+				return 0;
+			}
+			out.resize(offset + padded);
+			return static_cast<uint32_t>(offset);
+		}
+
+		void write32(uint32_t offset, uint32_t v) { std::memcpy(out.data() + offset, &v, 4); }
+
+		bool tooLarge = false;
+
+	private:
+		uint32_t putString(str_view s)
+		{
+			const uint32_t offset = reserve(4 + s.size());
+			if (tooLarge) { return 0; }
+			write32(offset, static_cast<uint32_t>(s.size()));
+			std::memcpy(out.data() + offset + 4, s.data(), s.size());
+			return offset;
+		}
+
+		// names repeat a lot (e.g. in arrays of objects), each distinct name is stored once
+		uint32_t putName(str_view name)
+		{
+			if (name.empty()) { return 0; }
+			const auto found = names.find(name);
+			if (found != names.end()) { return found->second; }
+			const uint32_t offset = putString(name);
+			names.emplace(name, offset);
+			return offset;
+		}
+
+		str_t& out;
+		std::unordered_map<str_view, uint32_t> names; // views into the tree being encoded
+	};
+
+	// writes next to the target first, so a cache is never seen half written
+	void writeCacheFile(const str_t& path, str_view data)
+	{
+		const std::filesystem::path target(path);
+		std::filesystem::path temporary = target;
+		temporary += ".tmp";
+		{
+			std::ofstream fs(temporary, std::ios_base::binary | std::ios_base::trunc);
+			if (!fs) { return; }
+			fs.write(data.data(), static_cast<std::streamsize>(data.size()));
+			if (!fs) { return; }
+		}
+		std::error_code error;
+		std::filesystem::rename(temporary, target, error);
+		if (error) { std::filesystem::remove(temporary, error); }
+	}
+}
+
+namespace JSON
+{
+	BinaryValue::BinaryValue(const char_t* data, uint32_t offset) : data{ data }, offset{ offset }
+	{
+		const uint32_t tag = read32(data + offset);
+		type = static_cast<ObjectType>(tag & 0xFF);
+		integer = (tag & INTEGER_FLAG) != 0;
+		const uint32_t nameOffset = read32(data + offset + 4);
+		if (nameOffset) { name = readString(data, nameOffset); }
+	}
+
+	BinaryValue BinaryValue::Iterator::operator*() const
+	{
+		return BinaryValue(data, read32(data + slot));
+	}
+
+	str_view BinaryValue::getValue() const
+	{
+		if (!data || isContainer()) { return str_view(); }
+		return readString(data, offset + ((type == ObjectType::Number) ? 16 : 8));
+	}
+
+	size_t BinaryValue::size() const
+	{
+		return isContainer() ? read32(data + offset + 8) : getValue().size();
+	}
+
+	int64_t BinaryValue::asInt() const
+	{
+		if (type != ObjectType::Number) { return 0; }
+		if (integer)
+		{
+			int64_t v;
+			std::memcpy(&v, data + offset + 8, 8);
+			return v;
+		}
+		return doubleToInt(asDouble());
+	}
+
+	double BinaryValue::asDouble() const
+	{
+		if (type != ObjectType::Number) { return 0.0; }
+		if (integer) { return static_cast<double>(asInt()); }
+		double v;
+		std::memcpy(&v, data + offset + 8, 8);
+		return v;
+	}
+
+	BinaryValue BinaryValue::operator[](size_t i) const
+	{
+		return BinaryValue(data, read32(data + offset + 16 + static_cast<uint32_t>(i) * 4));
+	}
+
+	BinaryValue BinaryValue::operator[](str_view key) const
+	{
+		if (type != ObjectType::Object) { return BinaryValue(); }
+		const auto count = static_cast<uint32_t>(size());
+		const uint32_t capacity = read32(data + offset + 12);
+		if (capacity)
+		{
+			// records are 4-byte aligned and the data itself is at least that, so the slots can be read directly
+			const auto* slots = reinterpret_cast<const uint32_t*>(data + offset + 16 + count * 4);
+			const uint32_t member = findKey(slots, capacity, key, [this](uint32_t m) { return (*this)[m].name; });
+			return (member == KEY_NOT_FOUND) ? BinaryValue() : (*this)[member];
+		}
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const BinaryValue member = (*this)[i];
+			if (member.name == key) { return member; }
+		}
+		return BinaryValue();
+	}
+
+	Result BinaryDocument::open(str_view filePath)
+	{
+		close();
+		if (!file.open(filePath)) { return Result::Error_File; }
+		return validate();
+	}
+
+	Result BinaryDocument::assign(str_t&& encoded)
+	{
+		close();
+		owned = std::move(encoded);
+		return validate();
+	}
+
+	void BinaryDocument::close()
+	{
+		file.close();
+		owned = str_t();
+		rootValue = BinaryValue();
+	}
+
+	Result BinaryDocument::validate()
+	{
+		const str_view d = data();
+		bool valid = d.size() >= sizeof(BinaryHeader);
+		if (valid)
+		{
+			const BinaryHeader header = readHeader(d);
+			valid = std::memcmp(header.magic, BINARY_MAGIC, 4) == 0 && header.version == BINARY_VERSION &&
+				header.totalSize == d.size() && header.rootOffset >= sizeof(BinaryHeader) &&
+				header.rootOffset % 4 == 0 && static_cast<size_t>(header.rootOffset) + 8 <= d.size();
+			if (valid) { rootValue = BinaryValue(d.data(), header.rootOffset); }
+		}
+		if (!valid)
+		{
+			close();
+			RETURN_ERROR(Error_Binary_InvalidFormat);
+		}
+		return Result::OK;
+	}
+
+	uint64_t BinaryDocument::sourceHash() const
+	{
+		return (data().size() >= sizeof(BinaryHeader)) ? readHeader(data()).sourceHash : 0;
+	}
+
+	uint64_t BinaryDocument::sourceSize() const
+	{
+		return (data().size() >= sizeof(BinaryHeader)) ? readHeader(data()).sourceSize : 0;
+	}
+
+	str_t BinaryDocument::toString(bool readable) const
+	{
+		if (!rootValue.isContainer() || !rootValue.size()) { return str_t(); }
+		Writer writer(readable ? WriteMode::Pretty : WriteMode::Compact);
+		writer.value(rootValue[0]);
+		return writer.release();
+	}
+
+	// four independent lanes keep the multiplies in flight, the tail and the length are mixed in at the end
+	uint64_t hashContent(str_view data)
+	{
+		constexpr uint64_t k0 = 0x9E3779B97F4A7C15ULL;
+		constexpr uint64_t k1 = 0xC2B2AE3D27D4EB4FULL;
+		uint64_t lanes[4] = { k0, k1, k0 ^ k1, k0 + k1 };
+		const char_t* p = data.data();
+		size_t n = data.size();
+		for (; n >= 32; p += 32, n -= 32)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				uint64_t v;
+				std::memcpy(&v, p + j * 8, 8);
+				lanes[j] = std::rotl(lanes[j] ^ (v * k1), 31) * k0;
+			}
+		}
+		for (int j = 0; n; j++)
+		{
+			uint64_t v = 0;
+			const size_t take = std::min<size_t>(n, 8);
+			std::memcpy(&v, p, take);
+			lanes[j] = std::rotl(lanes[j] ^ (v * k1), 31) * k0;
+			p += take;
+			n -= take;
+		}
+
+		uint64_t h = data.size() * k0;
+		for (const uint64_t lane : lanes) { h = std::rotl(h ^ (lane * k1), 27) * k0; }
+		// final avalanche, so every input bit affects every output bit
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 33;
+		h *= 0xC4CEB9FE1A85EC53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+	Result encodeBinary(const Object& object, str_t& encodedOut, uint64_t sourceHash, uint64_t sourceSize)
+	{
+		encodedOut.clear();
+		Encoder encoder(encodedOut);
+		encoder.reserve(sizeof(BinaryHeader));
+		const uint32_t root = encoder.encode(object);
+		if (encoder.tooLarge)
+		{
+			encodedOut.clear();
+			RETURN_ERROR(Error_Binary_TooLarge);
+		}
+
+		BinaryHeader header{};
+		std::memcpy(header.magic, BINARY_MAGIC, 4);
+		header.version = BINARY_VERSION;
+		header.sourceHash = sourceHash;
+		header.sourceSize = sourceSize;
+		header.rootOffset = root;
+		header.totalSize = static_cast<uint32_t>(encodedOut.size());
+		std::memcpy(encodedOut.data(), &header, sizeof(header));
+		return Result::OK;
+	}
+
+	void decodeBinary(const BinaryValue& value, Object& objectOut)
+	{
+		objectOut.reset();
+		objectOut.type = value.type;
+		objectOut.name = value.name;
+		objectOut.value = value.getValue();
+		if (value.type == ObjectType::Number)
+		{
+			objectOut.integer = value.integer;
+			objectOut.intValue = value.asInt();
+			objectOut.doubleValue = value.asDouble();
+		}
+		if (!value.isContainer()) { return; }
+
+		objectOut.subobjects.resize(value.size());
+		for (size_t i = 0; i < objectOut.subobjects.size(); i++) { decodeBinary(value[i], objectOut.subobjects[i]); }
+		objectOut.rebuildKeyIndex();
+	}
+
+	Result loadCached(str_view filePath, BinaryDocument& documentOut)
+	{
+		MappedFile source;
+		if (!source.open(filePath)) { return Result::Error_File; }
+		const uint64_t hash = hashContent(source.view());
+
+		const str_t cachePath = str_t(filePath) + str_t(BINARY_CACHE_EXTENSION);
+		if (documentOut.open(cachePath) == Result::OK && documentOut.sourceHash() == hash && documentOut.sourceSize() == source.size())
+		{
+			return Result::OK;
+		}
+		documentOut.close(); // the stale cache may be mapped, it is replaced below
+
+		Object object;
+		Result result = load(source.view(), object);
+		if (result != Result::OK) { return result; }
+		str_t encoded;
+		result = encodeBinary(object, encoded, hash, source.size());
+		if (result != Result::OK) { return result; }
+		writeCacheFile(cachePath, encoded);
+		return documentOut.assign(std::move(encoded));
+	}
+
+}
@@ -0,0 +1,113 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include "Parser.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <cstring>
+
+/* binary encoding of Object trees, read in place without a parse step
+all offsets are 32-bit and relative to the start of the data, records are 4-byte aligned
+
+header		magic "JRPB", version, source hash (u64), source size (u64), root offset, total size
+record		type (low 8 bits) and integer flag (bit 8), offset of the name string (0 if unnamed), then by type:
+	containers		member count, key index capacity, member record offsets[count], key index slots[capacity]
+	numbers			decoded value (8 bytes, int64 or double), value text as a string
+	other values	value text as a string
+string		length (u32) followed by the bytes, padded to 4 bytes
+names are shared between records, names and strings are stored decoded like in the Object they came from */
+
+namespace JSON
+{
+	constexpr uint32_t BINARY_VERSION = 2;
+	// cache files are stored next to the source, with this appended to the file name
+	constexpr str_view BINARY_CACHE_EXTENSION = ".jbin";
+
+	// value inside binary data, cheap to copy, valid as long as the data is
+	class BinaryValue
+	{
+	public:
+		class Iterator
+		{
+		public:
+			Iterator(const JSONTextUtils::char_t* data, uint32_t slot) : data{ data }, slot{ slot } {};
+			BinaryValue operator*() const;
+			Iterator& operator++() { slot += 4; return *this; }
+			bool operator!=(const Iterator& other) const { return slot != other.slot; }
+
+		private:
+			const JSONTextUtils::char_t* data;
+			uint32_t slot; // offset of the member's record offset
+		};
+
+		BinaryValue() = default;
+		BinaryValue(const JSONTextUtils::char_t* data, uint32_t offset);
+
+		bool isNamed() const { return !name.empty(); }
+		bool isValue() const { return !isContainer() && type != ObjectType::Undefined; }
+		bool isContainer() const { return type == ObjectType::Array || type == ObjectType::Object; }
+		str_view getValue() const;
+		// number of members for containers, length of the value text otherwise
+		size_t size() const;
+
+		bool isInteger() const { return type == ObjectType::Number && integer; }
+		// non-integers are truncated, non-numbers return 0
+		int64_t asInt() const;
+		double asDouble() const;
+
+		BinaryValue operator[](size_t i) const;
+		Iterator begin() const { return Iterator(data, isContainer() ? offset + 16 : 0); }
+		Iterator end() const { return Iterator(data, isContainer() ? offset + 16 + static_cast<uint32_t>(size()) * 4 : 0); }
+		// first member of an object with the given name, an undefined value if missing (or not an object)
+		BinaryValue operator[](str_view key) const;
+
+		ObjectType type = ObjectType::Undefined;
+		bool integer = false;
+		str_view name;
+
+	private:
+		const JSONTextUtils::char_t* data = nullptr;
+		uint32_t offset = 0;
+	};
+
+	/* binary data from a file (memory mapped) or from memory, the header is checked when opened
+	the records themselves are trusted, binary files are meant as caches written by encodeBinary */
+	class BinaryDocument
+	{
+	public:
+		Result open(str_view filePath);
+		// takes ownership of encoded data
+		Result assign(str_t&& encoded);
+		void close();
+
+		// the root of the encoded tree, like the Object passed to encodeBinary
+		const BinaryValue& root() const { return rootValue; }
+		uint64_t sourceHash() const;
+		uint64_t sourceSize() const;
+		str_view data() const { return owned.empty() ? file.view() : str_view(owned); }
+		bool isMapped() const { return file.isMapped(); }
+
+		// serializes the top-level value (the first member of the root), same output as Object::toString
+		str_t toString(bool readable = true) const;
+
+	private:
+		Result validate();
+
+		MappedFile file;
+		str_t owned;
+		BinaryValue rootValue;
+	};
+
+	// 64-bit hash of file contents, used to tell whether a cache is still valid
+	uint64_t hashContent(str_view data);
+
+	// encodes the whole tree, sourceHash and sourceSize are stored in the header to identify the text it came from
+	Result encodeBinary(const Object& object, str_t& encodedOut, uint64_t sourceHash = 0, uint64_t sourceSize = 0);
+	// rebuilds an Object tree from binary data
+	void decodeBinary(const BinaryValue& value, Object& objectOut);
+
+	/* opens the binary cache of a .json file, the cache is used only if it was made from identical text
+	otherwise the text is parsed, and the cache is rewritten (failing to write it is not an error) */
+	Result loadCached(str_view filePath, BinaryDocument& documentOut);
+
+}
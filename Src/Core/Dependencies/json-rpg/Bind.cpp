@@ -0,0 +1,11 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#include "Bind.h"
+
+namespace JSONReader
+{
+	std::vector<uint32_t>& bindScratchIndex()
+	{
+		thread_local std::vector<uint32_t> index;
+		return index;
+	}
+}
@@ -0,0 +1,383 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include "Parser.h"
+#include "Reader.h"
+#include "MappedFile.h"
+
+#include <array>
+#include <bit>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/* typed binding, decodes text straight into C++ structs without building a tree
+a struct is bound by specializing JSON::Binding with a constexpr tuple of its fields:
+
+	template<> struct JSON::Binding<Transform>
+	{
+		static constexpr auto fields = std::make_tuple(
+			JSON_FIELD(Transform, translation), JSON_FIELD(Transform, rotation), JSON_FIELD(Transform, scale));
+	};
+
+bound structs are read from objects (members matched by name, unknown names skipped, missing ones left as they are)
+or from arrays (members in declaration order), field names are looked up through a perfect hash built at compile time
+supported field types are bool, arithmetic types, enums, str_t, std::vector and other bound structs */
+
+namespace JSON
+{
+	template<typename T, typename M>
+	struct Field
+	{
+		str_view name;
+		M T::* member;
+	};
+
+	template<typename T, typename M>
+	constexpr Field<T, M> field(str_view name, M T::* member) { return Field<T, M>{ name, member }; }
+
+	#define JSON_FIELD(type, member) JSON::field(#member, &type::member)
+
+	// specialize with a static constexpr tuple named fields, see above
+	template<typename T>
+	struct Binding;
+
+	/* specialize to read an enum from names as well as from numbers, with a static constexpr array named names
+	of std::pair<str_view, T> */
+	template<typename T>
+	struct EnumNames;
+
+	// decodes a whole text into value, which must be a bound struct or any other supported type
+	template<typename T>
+	Result decode(str_view text, T& valueOut);
+	// maps the file and decodes it, the mapping is only kept while decoding
+	template<typename T>
+	Result decodeFile(str_view filePath, T& valueOut);
+}
+
+namespace JSONReader
+{
+	// structural index storage for decode(), one per thread
+	std::vector<uint32_t>& bindScratchIndex();
+
+	// string token contents with escapes decoded into buffer, tokens without escapes are returned as they are
+	inline str_view decodeString(str_view raw, str_t& buffer)
+	{
+		if (!JSON::hasEscapes(raw)) { return raw; }
+		buffer.resize(raw.size());
+		buffer.resize(JSON::unescapeString(raw, buffer.data()));
+		return buffer;
+	}
+
+	template<typename T>
+	concept Bound = requires { JSON::Binding<T>::fields; };
+
+	template<typename T>
+	concept Named = requires { JSON::EnumNames<T>::names; };
+
+	template<typename T> struct IsVector : std::false_type {};
+	template<typename E, typename A> struct IsVector<std::vector<E, A>> : std::true_type {};
+
+	constexpr uint32_t fieldHash(str_view s, uint32_t seed)
+	{
+		uint32_t h = 2166136261u ^ seed;
+		for (const char_t c : s)
+		{
+			h ^= static_cast<uint8_t>(c);
+			h *= 16777619u;
+		}
+		return h ^ (h >> 15);
+	}
+
+	/* collision-free table over a fixed set of names, the seed is searched for at compile time
+	with at most a quarter of the slots in use a seed is found after a handful of tries */
+	template<size_t N>
+	struct PerfectHash
+	{
+		static constexpr size_t TABLE_SIZE = std::bit_ceil(N ? N : 1) * 4;
+		static_assert(N < 255, "too many fields for a perfect hash table");
+
+		constexpr explicit PerfectHash(const std::array<str_view, N>& names) : names{ names }
+		{
+			for (seed = 0;; seed++)
+			{
+				slots.fill(0);
+				bool collision = false;
+				for (size_t i = 0; i < N && !collision; i++)
+				{
+					uint8_t& slot = slots[fieldHash(names[i], seed) & (TABLE_SIZE - 1)];
+					collision = (slot != 0);
+					slot = static_cast<uint8_t>(i + 1);
+				}
+				if (!collision) { return; }
+			}
+		}
+
+		// index of the name, or -1
+		constexpr int find(str_view name) const
+		{
+			const uint8_t slot = slots[fieldHash(name, seed) & (TABLE_SIZE - 1)];
+			return (slot && names[slot - 1] == name) ? slot - 1 : -1;
+		}
+
+		std::array<str_view, N> names;
+		std::array<uint8_t, TABLE_SIZE> slots{};
+		uint32_t seed = 0;
+	};
+
+	template<typename T>
+	constexpr size_t numFields = std::tuple_size_v<std::remove_cv_t<decltype(JSON::Binding<T>::fields)>>;
+
+	template<typename T>
+	constexpr auto fieldTable = []<size_t... I>(std::index_sequence<I...>)
+	{
+		return PerfectHash<sizeof...(I)>(std::array<str_view, sizeof...(I)>{ std::get<I>(JSON::Binding<T>::fields).name... });
+	}(std::make_index_sequence<numFields<T>>{});
+
+	// the token stream checked by the same Grammar as the DOM builders, numbers are decoded once by it and kept here
+	template<typename TokenSource>
+	class BindCursor
+	{
+	public:
+		explicit BindCursor(TokenSource& source) : source{ source } {};
+
+		Result next(TokenKind& kindOut, str_view& dataOut)
+		{
+			const Result result = source.next(kindOut, dataOut);
+			if (result != Result::OK) { return result; }
+			if (kindOut == TokenKind::End) { return grammar.finish(); }
+			return grammar.accept(kindOut, dataOut, *this);
+		}
+
+		// reads the next token that is not a comma or colon, the grammar has already checked where those are
+		Result nextValue(TokenKind& kindOut, str_view& dataOut)
+		{
+			Result result;
+			do { result = next(kindOut, dataOut); } while (result == Result::OK && (kindOut == TokenKind::MemberDelim || kindOut == TokenKind::KeyValueDelim));
+			return result;
+		}
+
+		// skips the rest of a value whose first token was kind
+		Result skip(TokenKind kind)
+		{
+			if (kind != TokenKind::ObjectBegin && kind != TokenKind::ArrayBegin) { return Result::OK; }
+			const size_t depth = grammar.depth();
+			TokenKind k;
+			str_view d;
+			while (grammar.depth() >= depth)
+			{
+				const Result result = next(k, d);
+				if (result != Result::OK) { return result; }
+			}
+			return Result::OK;
+		}
+
+		// checks that nothing follows the root value
+		Result finish()
+		{
+			TokenKind kind;
+			str_view data;
+			const Result result = next(kind, data);
+			if (result != Result::OK) { return result; }
+			RETURN_ERROR_IF(kind != TokenKind::End, Error_Parser_InvalidRoot);
+			return Result::OK;
+		}
+
+		const JSON::NumberValue& number() const { return lastNumber; }
+
+		// Grammar handler, only numbers are of interest
+		void beginContainer(ObjectType) {}
+		void endContainer(ObjectType) {}
+		void key(str_view) {}
+		void value(ObjectType, str_view) {}
+		void number(str_view, const JSON::NumberValue& n) { lastNumber = n; }
+
+	private:
+		TokenSource& source;
+		Grammar grammar;
+		JSON::NumberValue lastNumber;
+	};
+
+	template<typename Cursor, typename V>
+	Result decodeValue(Cursor& cursor, TokenKind kind, str_view data, V& out);
+
+	template<typename T, typename Cursor, size_t I>
+	Result decodeField(Cursor& cursor, TokenKind kind, str_view data, T& out)
+	{
+		return decodeValue(cursor, kind, data, out.*(std::get<I>(JSON::Binding<T>::fields).member));
+	}
+
+	template<typename T, typename Cursor>
+	using FieldDecoder = Result(*)(Cursor&, TokenKind, str_view, T&);
+
+	template<typename T, typename Cursor>
+	constexpr auto fieldDecoders = []<size_t... I>(std::index_sequence<I...>)
+	{
+		return std::array<FieldDecoder<T, Cursor>, sizeof...(I)>{ &decodeField<T, Cursor, I>... };
+	}(std::make_index_sequence<numFields<T>>{});
+
+	template<typename T, typename Cursor>
+	Result decodeStruct(Cursor& cursor, TokenKind kind, T& out)
+	{
+		constexpr auto& decoders = fieldDecoders<T, Cursor>;
+		TokenKind k;
+		str_view d;
+		if (kind == TokenKind::ObjectBegin)
+		{
+			str_t keyBuffer;
+			while (true)
+			{
+				Result result = cursor.nextValue(k, d);
+				if (result != Result::OK) { return result; }
+				if (k == TokenKind::ObjectEnd) { return Result::OK; }
+
+				const int i = fieldTable<T>.find(decodeString(d, keyBuffer)); // k is the key
+				result = cursor.nextValue(k, d);
+				if (result != Result::OK) { return result; }
+				result = (i < 0) ? cursor.skip(k) : decoders[i](cursor, k, d, out);
+				if (result != Result::OK) { return result; }
+			}
+		}
+		RETURN_ERROR_IF(kind != TokenKind::ArrayBegin, Error_Bind_TypeMismatch);
+		for (size_t i = 0;; i++)
+		{
+			Result result = cursor.nextValue(k, d);
+			if (result != Result::OK) { return result; }
+			if (k == TokenKind::ArrayEnd) { return Result::OK; }
+			result = (i < decoders.size()) ? decoders[i](cursor, k, d, out) : cursor.skip(k);
+			if (result != Result::OK) { return result; }
+		}
+	}
+
+	template<typename Cursor, typename V>
+	Result decodeValue(Cursor& cursor, TokenKind kind, str_view data, V& out)
+	{
+		if constexpr (Bound<V>)
+		{
+			return decodeStruct(cursor, kind, out);
+		}
+		else if constexpr (std::is_same_v<V, bool>)
+		{
+			RETURN_ERROR_IF(kind != TokenKind::Boolean, Error_Bind_TypeMismatch);
+			out = (data[0] == 't');
+			return Result::OK;
+		}
+		else if constexpr (std::is_enum_v<V>)
+		{
+			if constexpr (Named<V>)
+			{
+				if (kind == TokenKind::String)
+				{
+					str_t buffer;
+					const str_view decoded = decodeString(data, buffer);
+					for (const auto& [name, value] : JSON::EnumNames<V>::names)
+					{
+						if (name == decoded)
+						{
+							out = value;
+							return Result::OK;
+						}
+					}
+					RETURN_ERROR(Error_Bind_UnknownEnumName);
+				}
+			}
+			std::underlying_type_t<V> n{};
+			const Result result = decodeValue(cursor, kind, data, n);
+			out = static_cast<V>(n);
+			return result;
+		}
+		else if constexpr (std::is_integral_v<V>)
+		{
+			RETURN_ERROR_IF(kind != TokenKind::Number || !cursor.number().integer, Error_Bind_TypeMismatch);
+			const int64_t n = cursor.number().intValue;
+			if constexpr (std::is_unsigned_v<V>)
+			{
+				RETURN_ERROR_IF(n < 0 || static_cast<uint64_t>(n) > std::numeric_limits<V>::max(), Error_Bind_TypeMismatch);
+			}
+			else
+			{
+				RETURN_ERROR_IF(n < std::numeric_limits<V>::min() || n > std::numeric_limits<V>::max(), Error_Bind_TypeMismatch);
+			}
+			out = static_cast<V>(n);
+			return Result::OK;
+		}
+		else if constexpr (std::is_floating_point_v<V>)
+		{
+			RETURN_ERROR_IF(kind != TokenKind::Number, Error_Bind_TypeMismatch);
+			const JSON::NumberValue& n = cursor.number();
+			out = static_cast<V>(n.integer ? static_cast<double>(n.intValue) : n.doubleValue);
+			return Result::OK;
+		}
+		else if constexpr (std::is_same_v<V, str_t>)
+		{
+			RETURN_ERROR_IF(kind != TokenKind::String, Error_Bind_TypeMismatch);
+			if (JSON::hasEscapes(data))
+			{
+				out.resize(data.size());
+				out.resize(JSON::unescapeString(data, out.data())); // the tokenizer has already checked the escapes
+			}
+			else { out.assign(data); }
+			return Result::OK;
+		}
+		else if constexpr (IsVector<V>::value)
+		{
+			RETURN_ERROR_IF(kind != TokenKind::ArrayBegin, Error_Bind_TypeMismatch);
+			out.clear();
+			TokenKind k;
+			str_view d;
+			while (true)
+			{
+				Result result = cursor.nextValue(k, d);
+				if (result != Result::OK) { return result; }
+				if (k == TokenKind::ArrayEnd) { return Result::OK; }
+				result = decodeValue(cursor, k, d, out.emplace_back());
+				if (result != Result::OK) { return result; }
+			}
+		}
+		else
+		{
+			static_assert(Bound<V>, "type has no JSON::Binding and is not a supported value type");
+		}
+	}
+
+	template<typename TokenSource, typename T>
+	Result decodeRoot(TokenSource& source, T& valueOut)
+	{
+		BindCursor<TokenSource> cursor(source);
+		TokenKind kind;
+		str_view data;
+		Result result = cursor.next(kind, data);
+		if (result != Result::OK) { return result; }
+		RETURN_ERROR_IF(kind == TokenKind::End, Error_Parser_NoTokens);
+		result = decodeValue(cursor, kind, data, valueOut);
+		if (result != Result::OK) { return result; }
+		return cursor.finish();
+	}
+}
+
+namespace JSON
+{
+	template<typename T>
+	Result decode(str_view text, T& valueOut)
+	{
+		// same choice of token source as JSONReader::read
+		std::vector<uint32_t>& index = JSONReader::bindScratchIndex();
+		if (getSimdLevel() == SimdLevel::Scalar || text.size() >= UINT32_MAX)
+		{
+			JSONReader::Tokenizer tokenizer(text);
+			return JSONReader::preferStage1Error(text, JSONReader::decodeRoot(tokenizer, valueOut), index);
+		}
+		const Result result = buildStructuralIndex(text, index);
+		if (result != Result::OK) { return result; }
+		JSONReader::IndexedTokenizer tokenizer(text, index);
+		return JSONReader::decodeRoot(tokenizer, valueOut);
+	}
+
+	template<typename T>
+	Result decodeFile(str_view filePath, T& valueOut)
+	{
+		MappedFile file;
+		if (!file.open(filePath)) { return Result::Error_File; }
+		return decode(file.view(), valueOut);
+	}
+}
@@ -0,0 +1,70 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#include "Document.h"
+#include "Number.h"
+
+#include <algorithm>
+
+namespace
+{
+	const JSON::Node undefinedNode;
+}
+
+namespace JSON
+{
+	const Node* Node::find(str_view key) const
+	{
+		if (type != ObjectType::Object) { return nullptr; }
+		if (hasKeyIndex())
+		{
+			const auto* slots = reinterpret_cast<const uint32_t*>(children + numChildren);
+			const uint32_t i = findKey(slots, keyIndexCapacity(numChildren), key, [this](uint32_t m) { return children[m].name; });
+			return (i == KEY_NOT_FOUND) ? nullptr : &children[i];
+		}
+		for (const Node& member : *this)
+		{
+			if (member.name == key) { return &member; }
+		}
+		return nullptr;
+	}
+
+	const Node& Node::operator[](str_view key) const
+	{
+		const Node* member = find(key);
+		return member ? *member : undefinedNode;
+	}
+
+	const Node* allocateMembers(Arena& arena, ObjectType containerType, const Node* members, uint32_t count)
+	{
+		if (!count) { return nullptr; }
+		const bool indexed = (containerType == ObjectType::Object && count >= KEY_INDEX_MIN_MEMBERS);
+		const uint32_t capacity = indexed ? keyIndexCapacity(count) : 0;
+
+		static_assert(alignof(Node) >= alignof(uint32_t));
+		auto* out = static_cast<Node*>(arena.allocate(sizeof(Node) * count + sizeof(uint32_t) * capacity, alignof(Node)));
+		std::copy(members, members + count, out);
+		if (indexed)
+		{
+			buildKeyIndex(reinterpret_cast<uint32_t*>(out + count), capacity, count, [out](uint32_t m) { return out[m].name; });
+		}
+		return out;
+	}
+
+	int64_t Node::asInt() const
+	{
+		if (type != ObjectType::Number) { return 0; }
+		return integer ? intValue : doubleToInt(doubleValue);
+	}
+
+	double Node::asDouble() const
+	{
+		if (type != ObjectType::Number) { return 0.0; }
+		return integer ? static_cast<double>(intValue) : doubleValue;
+	}
+
+	void Document::clear()
+	{
+		arena.reset();
+		rootNode = Node();
+	}
+
+}
@@ -0,0 +1,95 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include "Parser.h"
+#include "Arena.h"
+#include "MappedFile.h"
+#include "KeyIndex.h"
+
+namespace JSON
+{
+	/* read-only DOM node, all nodes of a document live in the document's arena
+	name and value are views into the source text, so the text must outlive the document
+	strings containing escape sequences are the exception, they are decoded into the arena */
+	class Node
+	{
+	public:
+		Node() = default;
+		Node(ObjectType t, str_view n) : type{ t }, name{ n } {};
+		Node(ObjectType t, str_view n, str_view v) : type{ t }, name{ n }, value{ v } {};
+
+		bool isNamed() const { return !name.empty(); }
+		bool isValue() const { return !isContainer() && type != ObjectType::Undefined; }
+		bool isContainer() const { return type == ObjectType::Array || type == ObjectType::Object; }
+		str_view getValue() const { return value; }
+		// number of members for containers, length of the value text otherwise
+		size_t size() const noexcept { return isContainer() ? numChildren : value.size(); }
+
+		// numbers are decoded while parsing, integers that fit in 64 bits are exact
+		bool isInteger() const { return type == ObjectType::Number && integer; }
+		// non-integers are truncated, non-numbers return 0
+		int64_t asInt() const;
+		double asDouble() const;
+
+		const Node& operator[](size_t i) const { return children[i]; }
+		const Node* begin() const { return isContainer() ? children : nullptr; }
+		const Node* end() const { return isContainer() ? children + numChildren : nullptr; }
+
+		// first member of an object with the given name, nullptr if missing (or not an object)
+		const Node* find(str_view key) const;
+		// like find(), but returns an undefined node if the key is missing
+		const Node& operator[](str_view key) const;
+		// large objects have a hash index stored in the arena right after their members
+		bool hasKeyIndex() const { return type == ObjectType::Object && numChildren >= KEY_INDEX_MIN_MEMBERS; }
+
+		ObjectType type = ObjectType::Undefined;
+		bool integer = false;
+		str_view name;
+		str_view value;
+		union
+		{
+			const Node* children = nullptr; // contiguous array in the arena, for containers
+			int64_t intValue; // for integer numbers
+			double doubleValue; // for other numbers
+		};
+		uint32_t numChildren = 0;
+	};
+
+	/* copies container members into the arena as one contiguous array, followed by a key index for large objects
+	nodes of a document must be allocated this way, since hasKeyIndex() relies on the layout */
+	const Node* allocateMembers(Arena& arena, ObjectType containerType, const Node* members, uint32_t count);
+
+	/* arena-backed alternative to Object, parsing does no per-node heap allocations and never copies subtrees
+	unlike the Object returned by load(), root() is the top-level value itself (not wrapped in a "root" object) */
+	class Document
+	{
+	public:
+		Document() = default;
+		// a smaller arena block size suits large numbers of small documents
+		explicit Document(size_t arenaBlockSize) : arena{ arenaBlockSize } {};
+		~Document() = default;
+
+		Document(const Document&) = delete;
+		Document& operator=(const Document&) = delete;
+		Document(Document&&) noexcept = default;
+		Document& operator=(Document&&) noexcept = default;
+
+		const Node& root() const { return rootNode; }
+		const Arena& getArena() const { return arena; }
+		// drops all nodes, arena blocks are kept for the next parse
+		void clear();
+
+	private:
+		friend Result load(str_view text, Document& documentOut);
+		friend Result loadFromFile(str_view filePath, Document& documentOut);
+
+		Arena arena;
+		Node rootNode;
+		MappedFile file; // source text when loaded from file, nodes point into it
+	};
+
+	// parses into an arena-backed document, text must outlive the document
+	Result load(str_view text, Document& documentOut);
+	// maps the file and parses it, nodes point into the mapping, which the document keeps alive
+	Result loadFromFile(str_view filePath, Document& documentOut);
+
+}
@@ -0,0 +1,76 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include "Parser.h"
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+namespace JSON
+{
+	// objects with at least this many members get a hash index when parsed, smaller ones are scanned linearly
+	constexpr uint32_t KEY_INDEX_MIN_MEMBERS = 16;
+	constexpr uint32_t KEY_NOT_FOUND = UINT32_MAX;
+
+	inline uint64_t hashKey(str_view key)
+	{
+		constexpr uint64_t mul = 0x9E3779B97F4A7C15ULL;
+		uint64_t h = key.size() * mul;
+		const char* p = key.data();
+		size_t n = key.size();
+		for (; n >= 8; p += 8, n -= 8)
+		{
+			uint64_t v;
+			std::memcpy(&v, p, 8);
+			h = (h ^ v) * mul;
+			h ^= h >> 29;
+		}
+		if (n)
+		{
+			uint64_t v = 0;
+			std::memcpy(&v, p, n);
+			h = (h ^ v) * mul;
+			h ^= h >> 29;
+		}
+		return h;
+	}
+
+	// slot count for an index over numMembers keys, a power of two at most half full
+	inline uint32_t keyIndexCapacity(uint32_t numMembers)
+	{
+		return std::bit_ceil(numMembers * 2);
+	}
+
+	/* flat open-addressing table with linear probing, each slot holds a member index + 1 (0 marks an empty slot)
+	with duplicate keys the first member wins, like the linear scan
+	getName(i) returns the name of member i */
+	template<typename GetName>
+	void buildKeyIndex(uint32_t* slots, uint32_t capacity, uint32_t numMembers, GetName getName)
+	{
+		std::memset(slots, 0, capacity * sizeof(uint32_t));
+		const uint32_t mask = capacity - 1;
+		for (uint32_t i = 0; i < numMembers; i++)
+		{
+			const str_view name = getName(i);
+			uint32_t slot = static_cast<uint32_t>(hashKey(name)) & mask;
+			while (slots[slot] && getName(slots[slot] - 1) != name) { slot = (slot + 1) & mask; }
+			if (!slots[slot]) { slots[slot] = i + 1; }
+		}
+	}
+
+	// returns the member index, or KEY_NOT_FOUND
+	template<typename GetName>
+	uint32_t findKey(const uint32_t* slots, uint32_t capacity, str_view key, GetName getName)
+	{
+		const uint32_t mask = capacity - 1;
+		uint32_t slot = static_cast<uint32_t>(hashKey(key)) & mask;
+		while (slots[slot])
+		{
+			const uint32_t member = slots[slot] - 1;
+			if (getName(member) == key) { return member; }
+			slot = (slot + 1) & mask;
+		}
+		return KEY_NOT_FOUND;
+	}
+
+}
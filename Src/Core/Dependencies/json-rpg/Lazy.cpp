@@ -0,0 +1,252 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#include "Lazy.h"
+#include "Reader.h"
+#include "Unicode.h"
+
+namespace
+{
+	using JSON::ObjectType;
+	using JSON::Result;
+
+	// Grammar handler for validate(), the events are not needed
+	struct NullHandler
+	{
+		void beginContainer(ObjectType) {}
+		void endContainer(ObjectType) {}
+		void key(str_view) {}
+		void value(ObjectType, str_view) {}
+		void number(str_view, const JSON::NumberValue&) {}
+	};
+
+	bool isOpening(char_t c) { return c == STC_CBR_L || c == STC_SBR_L; }
+	bool isClosing(char_t c) { return c == STC_CBR_R || c == STC_SBR_R; }
+}
+
+namespace JSON
+{
+	LazyValue::LazyValue(const LazyDocument* document, uint32_t slot, str_view name) : name{ name }, document{ document }, slot{ slot }
+	{
+		const size_t pos = document->index[slot];
+		const str_view text = document->text;
+		switch (text[pos])
+		{
+			case STC_CBR_L: type = ObjectType::Object; break;
+			case STC_SBR_L: type = ObjectType::Array; break;
+			case STR_DELIM: type = ObjectType::String; break;
+			default:
+				if (JSONReader::hasCharClass(text[pos], JSONReader::CC_Numerical)) { type = ObjectType::Number; }
+				else if (isliteralBooleanStr(pos, text)) { type = ObjectType::Boolean; }
+				else if (isLiteralNullStr(pos, text)) { type = ObjectType::Null; }
+				break; // anything else is left undefined
+		}
+	}
+
+	str_view LazyValue::getValue() const
+	{
+		if (!document || isContainer()) { return str_view(); }
+		const str_view text = document->text;
+		const size_t pos = document->index[slot];
+		switch (type)
+		{
+			case ObjectType::String: return text.substr(pos + 1, document->index[slot + 1] - pos - 1);
+			case ObjectType::Boolean: return text.substr(pos, (text[pos] == 't') ? 4 : 5);
+			case ObjectType::Null: return text.substr(pos, 4);
+			case ObjectType::Number:
+			{
+				size_t end = pos;
+				while (end < text.size() && JSONReader::hasCharClass(text[end], JSONReader::CC_Numerical)) { end++; }
+				return text.substr(pos, end - pos);
+			}
+			default: return str_view();
+		}
+	}
+
+	str_t LazyValue::getString() const
+	{
+		str_t decoded;
+		if (type != ObjectType::String || unescapeString(getValue(), decoded) != Result::OK) { return str_t(); }
+		return decoded;
+	}
+
+	str_view LazyValue::raw() const
+	{
+		if (!document) { return str_view(); }
+		const size_t pos = document->index[slot];
+		if (isContainer()) { return document->text.substr(pos, document->index[document->matches[slot]] - pos + 1); }
+		if (type == ObjectType::String) { return document->text.substr(pos, document->index[slot + 1] - pos + 1); }
+		return getValue();
+	}
+
+	size_t LazyValue::size() const
+	{
+		if (!isContainer()) { return getValue().size(); }
+		size_t count = 0;
+		for (Iterator it = begin(), last = end(); it != last; ++it) { count++; }
+		return count;
+	}
+
+	bool LazyValue::isInteger() const
+	{
+		NumberValue number;
+		return type == ObjectType::Number && parseNumber(getValue(), number) == Result::OK && number.integer;
+	}
+
+	int64_t LazyValue::asInt() const
+	{
+		NumberValue number;
+		if (type != ObjectType::Number || parseNumber(getValue(), number) != Result::OK) { return 0; }
+		return number.integer ? number.intValue : doubleToInt(number.doubleValue);
+	}
+
+	double LazyValue::asDouble() const
+	{
+		NumberValue number;
+		if (type != ObjectType::Number || parseNumber(getValue(), number) != Result::OK) { return 0.0; }
+		return number.integer ? static_cast<double>(number.intValue) : number.doubleValue;
+	}
+
+	LazyValue::Iterator LazyValue::begin() const
+	{
+		if (!isContainer()) { return Iterator(document, 0, 0, false); }
+		return Iterator(document, slot + 1, document->matches[slot], type == ObjectType::Object);
+	}
+
+	LazyValue::Iterator LazyValue::end() const
+	{
+		if (!isContainer()) { return Iterator(document, 0, 0, false); }
+		const uint32_t close = document->matches[slot];
+		return Iterator(document, close, close, type == ObjectType::Object);
+	}
+
+	LazyValue LazyValue::operator[](size_t i) const
+	{
+		Iterator it = begin();
+		const Iterator last = end();
+		for (; it != last && i; ++it) { i--; }
+		return (it != last) ? *it : LazyValue();
+	}
+
+	LazyValue LazyValue::operator[](str_view key) const
+	{
+		if (type != ObjectType::Object) { return LazyValue(); }
+		str_t decoded;
+		for (Iterator it = begin(), last = end(); it != last; ++it)
+		{
+			const LazyValue member = *it;
+			if (member.name == key) { return member; }
+			// names with escapes are compared decoded, decoding only makes them shorter
+			if (member.name.size() > key.size() && hasEscapes(member.name) &&
+				unescapeString(member.name, decoded) == Result::OK && decoded == key) { return member; }
+		}
+		return LazyValue();
+	}
+
+	Result LazyValue::toObject(Object& objectOut) const
+	{
+		return load(raw(), objectOut);
+	}
+
+	LazyValue LazyValue::Iterator::operator*() const
+	{
+		if (!inObject) { return LazyValue(document, slot, str_view()); }
+		// key, colon and value, anything else is malformed and reads as undefined
+		if (slot + 3 >= end || document->at(slot) != STR_DELIM || document->at(slot + 2) != STC_CL) { return LazyValue(); }
+		const size_t pos = document->index[slot];
+		const str_view key = document->text.substr(pos + 1, document->index[slot + 1] - pos - 1);
+		return LazyValue(document, slot + 3, key);
+	}
+
+	LazyValue::Iterator& LazyValue::Iterator::operator++()
+	{
+		slot = document->nextMember(slot, end, inObject);
+		return *this;
+	}
+
+	uint32_t LazyDocument::valueEnd(uint32_t slot) const
+	{
+		const char_t c = at(slot);
+		if (isOpening(c)) { return matches[slot] + 1; } // the whole subtree is skipped in one step
+		return (c == STR_DELIM) ? slot + 2 : slot + 1;
+	}
+
+	uint32_t LazyDocument::nextMember(uint32_t slot, uint32_t end, bool inObject) const
+	{
+		if (inObject)
+		{
+			if (slot + 3 >= end || at(slot) != STR_DELIM || at(slot + 2) != STC_CL) { return end; }
+			slot += 3;
+		}
+		const uint32_t after = valueEnd(slot);
+		return (after < end && at(after) == STC_CM) ? after + 1 : end;
+	}
+
+	LazyValue LazyDocument::root() const
+	{
+		return index.empty() ? LazyValue() : LazyValue(this, 0, str_view());
+	}
+
+	Result LazyDocument::validate() const
+	{
+		JSONReader::IndexedTokenizer tokenizer(text, index);
+		NullHandler handler;
+		return JSONReader::read(tokenizer, handler);
+	}
+
+	void LazyDocument::clear()
+	{
+		text = str_view();
+		index.clear();
+		matches.clear();
+	}
+
+	Result load(str_view text, LazyDocument& documentOut)
+	{
+		documentOut.clear();
+		RETURN_ERROR_IF(text.size() >= UINT32_MAX, Error_Parser_TextTooLarge);
+		std::vector<uint32_t>& index = documentOut.index;
+		Result result = buildStructuralIndex(text, index);
+		if (result != Result::OK)
+		{
+			documentOut.clear();
+			return result;
+		}
+		RETURN_ERROR_IF(index.empty(), Error_Parser_NoTokens);
+
+		// match up the brackets, the only pass over the whole index
+		std::vector<uint32_t>& matches = documentOut.matches;
+		matches.assign(index.size(), 0);
+		std::vector<uint32_t> open;
+		const auto count = static_cast<uint32_t>(index.size());
+		for (uint32_t s = 0; s < count && result == Result::OK; s++)
+		{
+			const char_t c = text[index[s]];
+			if (c == STR_DELIM) { s++; } // the closing quote is the next entry
+			else if (isOpening(c)) { open.push_back(s); }
+			else if (isClosing(c))
+			{
+				// } closes { and ] closes [, their codes are two apart
+				if (open.empty() || text[index[open.back()]] + 2 != c) { result = Result::Error_Parser_IllegalClosingToken; }
+				else
+				{
+					matches[open.back()] = s;
+					open.pop_back();
+				}
+			}
+		}
+		if (result == Result::OK && !open.empty()) { result = Result::Error_Parser_IllegalClosingToken; } // container left open
+		if (result == Result::OK)
+		{
+			documentOut.text = text;
+			if (documentOut.valueEnd(0) != count) { result = Result::Error_Parser_InvalidRoot; }
+		}
+		if (result != Result::OK) { documentOut.clear(); }
+		return result;
+	}
+
+	Result loadFromFile(str_view filePath, LazyDocument& documentOut)
+	{
+		if (!documentOut.file.open(filePath)) { return Result::Error_File; }
+		return load(documentOut.file.view(), documentOut);
+	}
+
+}
@@ -0,0 +1,109 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include "Parser.h"
+#include "MappedFile.h"
+
+namespace JSON
+{
+	class LazyDocument;
+
+	/* value inside a LazyDocument, decoded only when asked for, cheap to copy and valid as long as the document is
+	stepping over a container member is O(1) through the matched bracket offsets, whatever its size */
+	class LazyValue
+	{
+	public:
+		class Iterator
+		{
+		public:
+			Iterator(const LazyDocument* document, uint32_t slot, uint32_t end, bool inObject)
+				: document{ document }, slot{ slot }, end{ end }, inObject{ inObject } {};
+			LazyValue operator*() const;
+			Iterator& operator++();
+			bool operator!=(const Iterator& other) const { return slot != other.slot; }
+
+		private:
+			const LazyDocument* document;
+			uint32_t slot; // index entry of the member (its key in objects)
+			uint32_t end; // index entry of the closing bracket
+			bool inObject;
+		};
+
+		LazyValue() = default;
+		LazyValue(const LazyDocument* document, uint32_t slot, str_view name);
+
+		bool isNamed() const { return !name.empty(); }
+		bool isValue() const { return !isContainer() && type != ObjectType::Undefined; }
+		bool isContainer() const { return type == ObjectType::Array || type == ObjectType::Object; }
+		// string contents as they appear in the text (escapes are not decoded) or the literal text of other values, empty for containers
+		str_view getValue() const;
+		// string contents with escapes decoded, empty for other types and strings with invalid escapes
+		str_t getString() const;
+		// the value as it appears in the text, including quotes and brackets
+		str_view raw() const;
+		// number of members for containers (counted by stepping over them), length of the value text otherwise
+		size_t size() const;
+
+		// numbers are decoded on every call, invalid numbers read as 0
+		bool isInteger() const;
+		int64_t asInt() const;
+		double asDouble() const;
+
+		// members are found by stepping over the ones before, O(i) for the i:th member
+		LazyValue operator[](size_t i) const;
+		Iterator begin() const;
+		Iterator end() const;
+		// first member of an object with the given name (compared decoded), an undefined value if missing (or not an object)
+		LazyValue operator[](str_view key) const;
+
+		// fully parses (and validates) this value into a tree, like load()
+		Result toObject(Object& objectOut) const;
+
+		ObjectType type = ObjectType::Undefined;
+		str_view name; // as it appears in the text, like getValue()
+
+	private:
+		const LazyDocument* document = nullptr;
+		uint32_t slot = 0; // index entry where the value starts
+	};
+
+	/* on-demand document, loading only builds the structural index and matches up the brackets
+	strings, numbers and literals are read when visited, so subtrees that are never visited cost one index pass
+	only bracket nesting and string termination (and UTF-8) are checked when loading, see validate() */
+	class LazyDocument
+	{
+	public:
+		LazyDocument() = default;
+		LazyDocument(const LazyDocument&) = delete;
+		LazyDocument& operator=(const LazyDocument&) = delete;
+		LazyDocument(LazyDocument&&) noexcept = default;
+		LazyDocument& operator=(LazyDocument&&) noexcept = default;
+
+		// the top-level value, the text must outlive the document unless it was loaded from file
+		LazyValue root() const;
+		// runs the full grammar over the whole text, the same checks as load() into an Object
+		Result validate() const;
+		void clear();
+
+	private:
+		friend class LazyValue;
+		friend Result load(str_view text, LazyDocument& documentOut);
+		friend Result loadFromFile(str_view filePath, LazyDocument& documentOut);
+
+		// index entry just past the value starting at slot
+		uint32_t valueEnd(uint32_t slot) const;
+		// the member after the one at slot, or end
+		uint32_t nextMember(uint32_t slot, uint32_t end, bool inObject) const;
+		char_t at(uint32_t slot) const { return text[index[slot]]; }
+
+		str_view text;
+		std::vector<uint32_t> index; // structural index of the text
+		std::vector<uint32_t> matches; // for opening brackets, the index entry of the closing one
+		MappedFile file;
+	};
+
+	// builds the structural index only, values are decoded later as they are visited
+	Result load(str_view text, LazyDocument& documentOut);
+	// maps the file, the document keeps the mapping alive
+	Result loadFromFile(str_view filePath, LazyDocument& documentOut);
+
+}
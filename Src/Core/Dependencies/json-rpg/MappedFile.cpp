@@ -0,0 +1,122 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#include "MappedFile.h"
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace JSON
+{
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this == &other) { return *this; }
+		close();
+		mappedData = other.mappedData;
+		mappedSize = other.mappedSize;
+		mapped = other.mapped;
+		buffer = std::move(other.buffer);
+		other.mappedData = nullptr;
+		other.mappedSize = 0;
+		other.mapped = false;
+		return *this;
+	}
+
+	bool MappedFile::open(str_view filePath)
+	{
+		close();
+		return map(filePath) || readBuffered(filePath);
+	}
+
+	void MappedFile::close()
+	{
+		if (mapped)
+		{
+		#ifdef _WIN32
+			UnmapViewOfFile(mappedData);
+		#else
+			munmap(const_cast<JSONTextUtils::char_t*>(mappedData), mappedSize);
+		#endif
+		}
+		mappedData = nullptr;
+		mappedSize = 0;
+		mapped = false;
+		buffer = std::vector<JSONTextUtils::char_t>();
+	}
+
+	bool MappedFile::map(str_view filePath)
+	{
+	#ifdef _WIN32
+		const std::filesystem::path path(filePath);
+		HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) { return false; }
+
+		LARGE_INTEGER fileSize{};
+		HANDLE mapping = nullptr;
+		// zero-length files cannot be mapped
+		if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+		{
+			mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		}
+		CloseHandle(file);
+		if (!mapping) { return false; }
+
+		// the view keeps the mapping object alive, so both handles can be closed right away
+		const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (!view) { return false; }
+
+		mappedData = static_cast<const JSONTextUtils::char_t*>(view);
+		mappedSize = static_cast<size_t>(fileSize.QuadPart);
+	#else
+		const str_t path(filePath);
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) { return false; }
+
+		struct stat info{};
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0)
+		{
+			::close(fd);
+			return false;
+		}
+		void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd); // the mapping holds its own reference to the file
+		if (view == MAP_FAILED) { return false; }
+		madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+
+		mappedData = static_cast<const JSONTextUtils::char_t*>(view);
+		mappedSize = static_cast<size_t>(info.st_size);
+	#endif
+		mapped = true;
+		return true;
+	}
+
+	bool MappedFile::readBuffered(str_view filePath)
+	{
+		std::ifstream fs(std::filesystem::path(filePath), std::ios_base::binary | std::ios_base::ate);
+		if (!fs) { return false; }
+		const auto fileSize = fs.tellg();
+		if (fileSize < 0) { return false; }
+		fs.seekg(0);
+		buffer.resize(static_cast<size_t>(fileSize));
+		fs.read(buffer.data(), buffer.size());
+		if (static_cast<size_t>(fs.gcount()) != buffer.size())
+		{
+			buffer = std::vector<JSONTextUtils::char_t>();
+			return false;
+		}
+		return true;
+	}
+
+}
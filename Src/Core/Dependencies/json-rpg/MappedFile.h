@@ -0,0 +1,39 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include "Parser.h"
+
+namespace JSON
+{
+	/* read-only view of a whole file, the pages are memory mapped when possible so nothing is copied
+	falls back to reading the file into an owned buffer when mapping fails (or the file is empty) */
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile() { close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		// returns false if the file could neither be mapped nor read, any previously opened file is closed first
+		bool open(str_view filePath);
+		void close();
+
+		// valid until the file is closed
+		str_view view() const { return mapped ? str_view(mappedData, mappedSize) : str_view(buffer.data(), buffer.size()); }
+		size_t size() const { return view().size(); }
+		bool isMapped() const { return mapped; }
+
+	private:
+		bool map(str_view filePath);
+		bool readBuffered(str_view filePath);
+
+		const JSONTextUtils::char_t* mappedData = nullptr;
+		size_t mappedSize = 0;
+		bool mapped = false;
+		std::vector<JSONTextUtils::char_t> buffer; // fallback storage, on the heap so views into it survive moving the file
+	};
+
+}
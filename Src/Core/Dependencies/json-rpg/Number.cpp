@@ -0,0 +1,157 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#include "Number.h"
+
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	constexpr bool isDigit(char c) { return static_cast<unsigned char>(c - '0') <= 9; }
+
+	// SWAR digit parsing, eight ASCII digits are checked and converted with a few 64-bit operations
+	inline uint64_t load8(const char* p)
+	{
+		uint64_t v = 0;
+		if constexpr (std::endian::native == std::endian::little) { std::memcpy(&v, p, sizeof(v)); }
+		else { for (int i = 0; i < 8; i++) { v |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (8 * i); } }
+		return v;
+	}
+
+	inline bool isEightDigits(uint64_t v)
+	{
+		return (((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+	}
+
+	inline uint64_t parseEightDigits(uint64_t v)
+	{
+		constexpr uint64_t mask = 0x000000FF000000FFULL;
+		constexpr uint64_t mul1 = 100 + (1000000ULL << 32);
+		constexpr uint64_t mul2 = 1 + (10000ULL << 32);
+		v -= 0x3030303030303030ULL;
+		v = (v * 10) + (v >> 8); // pairs of digits
+		return (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+	}
+
+	// accumulates a run of digits into mantissa (wrapping is fine, callers check the digit count)
+	inline const char* parseDigits(const char* p, const char* end, uint64_t& mantissa)
+	{
+		while (end - p >= 8)
+		{
+			const uint64_t v = load8(p);
+			if (!isEightDigits(v)) { break; }
+			mantissa = mantissa * 100000000ULL + parseEightDigits(v);
+			p += 8;
+		}
+		while (p < end && isDigit(*p))
+		{
+			mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+			p++;
+		}
+		return p;
+	}
+
+	// powers of ten that are exact in a double
+	constexpr double exactPowersOf10[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+}
+
+namespace JSON
+{
+	Result parseNumber(str_view text, NumberValue& numberOut)
+	{
+		const char* p = text.data();
+		const char* const end = p + text.size();
+
+		const bool negative = (p < end && *p == '-');
+		if (negative) { p++; }
+		RETURN_ERROR_IF(p == end || !isDigit(*p), Error_Lexer_InvalidNumber); // fail: no integer part
+
+		// integer part, a leading zero must stand alone
+		uint64_t mantissa = 0;
+		const char* const intStart = p;
+		if (*p == '0')
+		{
+			p++;
+			RETURN_ERROR_IF(p < end && isDigit(*p), Error_Lexer_InvalidNumber); // fail: leading zero
+		}
+		else { p = parseDigits(p, end, mantissa); }
+		size_t numDigits = p - intStart;
+
+		bool integer = true;
+		int64_t exponent = 0;
+		if (p < end && *p == '.')
+		{
+			integer = false;
+			const char* const fracStart = ++p;
+			p = parseDigits(p, end, mantissa);
+			RETURN_ERROR_IF(p == fracStart, Error_Lexer_InvalidNumber); // fail: no digits after the dot
+			numDigits += p - fracStart;
+			exponent = -static_cast<int64_t>(p - fracStart);
+		}
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			integer = false;
+			p++;
+			const bool negativeExponent = (p < end && *p == '-');
+			if (p < end && (*p == '-' || *p == '+')) { p++; }
+			RETURN_ERROR_IF(p == end || !isDigit(*p), Error_Lexer_InvalidNumber); // fail: no exponent digits
+			int64_t e = 0;
+			for (; p < end && isDigit(*p); p++)
+			{
+				if (e < 100000) { e = e * 10 + (*p - '0'); } // anything larger is out of range anyway
+			}
+			exponent += negativeExponent ? -e : e;
+		}
+		RETURN_ERROR_IF(p != end, Error_Lexer_InvalidNumber); // fail: trailing characters
+
+		// at most 19 digits cannot have wrapped
+		const bool exactMantissa = numDigits <= 19;
+		if (integer && exactMantissa)
+		{
+			constexpr uint64_t maxPositive = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+			if (mantissa <= maxPositive + (negative ? 1 : 0))
+			{
+				numberOut.integer = true;
+				numberOut.intValue = negative ? static_cast<int64_t>(0 - mantissa) : static_cast<int64_t>(mantissa);
+				numberOut.doubleValue = static_cast<double>(numberOut.intValue);
+				return Result::OK;
+			}
+		}
+
+		numberOut.integer = false;
+		if (exactMantissa && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+		{
+			// both operands are exact, so a single rounding gives the correctly rounded result
+			double d = static_cast<double>(mantissa);
+			d = (exponent < 0) ? d / exactPowersOf10[-exponent] : d * exactPowersOf10[exponent];
+			numberOut.doubleValue = negative ? -d : d;
+		}
+		else
+		{
+			double d = 0.0;
+			const auto [last, ec] = std::from_chars(text.data(), end, d);
+			if (ec == std::errc::result_out_of_range)
+			{
+				d = (exponent > 0) ? std::numeric_limits<double>::infinity() : 0.0;
+				if (negative) { d = -d; }
+			}
+			numberOut.doubleValue = d;
+		}
+		numberOut.intValue = doubleToInt(numberOut.doubleValue);
+		return Result::OK;
+	}
+
+	int64_t doubleToInt(double d)
+	{
+		if (d != d) { return 0; } // NaN
+		if (d >= 9223372036854775808.0) { return std::numeric_limits<int64_t>::max(); }
+		if (d <= -9223372036854775808.0) { return std::numeric_limits<int64_t>::min(); }
+		return static_cast<int64_t>(d);
+	}
+
+}
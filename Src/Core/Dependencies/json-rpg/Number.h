@@ -0,0 +1,25 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include "Parser.h"
+
+#include <cstdint>
+
+namespace JSON
+{
+	// decoded number, integers that fit in 64 bits keep full precision and are also available as double
+	struct NumberValue
+	{
+		bool integer = false;
+		int64_t intValue = 0;
+		double doubleValue = 0.0;
+	};
+
+	/* validates text against the JSON number grammar (no leading zeros, no lone dot or exponent, no '+' sign)
+	and decodes it, integers up to 19 digits take an exact fast path, decimals use Clinger's fast path
+	when the result is exact and fall back to std::from_chars otherwise */
+	Result parseNumber(str_view text, NumberValue& numberOut);
+
+	// truncates toward zero, saturating at the int64 limits (NaN becomes 0)
+	int64_t doubleToInt(double d);
+
+}
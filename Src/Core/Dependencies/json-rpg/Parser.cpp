@@ -1,12 +1,163 @@
 ﻿// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
 #include "Parser.h"
+#include "Document.h"
+#include "Reader.h"
+#include "Unicode.h"
+#include "MappedFile.h"
+#include "KeyIndex.h"
+#include "Writer.h"
 
 #include <limits.h>
 #include <iostream>
 #include <format>
 #include <cassert>
 #include <iomanip>
-#include <stack>
+#include <utility>
+
+namespace
+{
+	// builds the legacy Object tree in place, containers are filled while open so subtrees are never copied
+	class ObjectBuilder
+	{
+	public:
+		ObjectBuilder(JSON::Object& objectOut) : out{ objectOut } { out.reset(); }
+
+		void beginContainer(JSON::ObjectType type)
+		{
+			if (open.empty())
+			{
+				// containers at the root are wrapped in an unnamed "root" object
+				out = JSON::Object(JSON::ObjectType::Object, "root");
+				open.push_back(&out);
+			}
+			// the parent is not modified while a child is open, so the pointer stays valid
+			open.back()->subobjects.emplace_back(type, name);
+			open.push_back(&open.back()->subobjects.back());
+			name = str_view();
+		}
+
+		void endContainer(JSON::ObjectType)
+		{
+			open.back()->rebuildKeyIndex();
+			open.pop_back();
+		}
+
+		void key(str_view k) { name = decode(k, nameBuffer); }
+
+		void value(JSON::ObjectType type, str_view v)
+		{
+			if (type == JSON::ObjectType::String) { v = decode(v, valueBuffer); }
+			if (open.empty()) { out.set(type, v); } // lone value
+			else { open.back()->subobjects.emplace_back(type, name, v); }
+			name = str_view();
+		}
+
+		void number(str_view text, const JSON::NumberValue& n)
+		{
+			JSON::Object& object = open.empty() ? out : open.back()->subobjects.emplace_back(JSON::ObjectType::Number, name);
+			object.set(JSON::ObjectType::Number, text);
+			object.intValue = n.intValue;
+			object.doubleValue = n.doubleValue;
+			object.integer = n.integer;
+			name = str_view();
+		}
+
+	private:
+		// strings with escape sequences are decoded into a buffer, the tokenizer has already checked them
+		static str_view decode(str_view raw, str_t& buffer)
+		{
+			if (!JSON::hasEscapes(raw)) { return raw; }
+			buffer.resize(raw.size());
+			return str_view(buffer.data(), JSON::unescapeString(raw, buffer.data()));
+		}
+
+		JSON::Object& out;
+		std::vector<JSON::Object*> open;
+		str_view name;
+		str_t nameBuffer;
+		str_t valueBuffer;
+	};
+
+	/* builds Document nodes, members of open containers are collected in a reused scratch array
+	and moved into the arena as one contiguous block when their container closes */
+	class NodeBuilder
+	{
+	public:
+		NodeBuilder(JSON::Arena& arena, JSON::Node& rootOut, std::vector<JSON::Node>& pending, std::vector<size_t>& frames)
+			: arena{ arena }, root{ rootOut }, pending{ pending }, frames{ frames } {};
+
+		void beginContainer(JSON::ObjectType type)
+		{
+			pending.emplace_back(type, name);
+			frames.push_back(pending.size()); // members start after the container node
+			name = str_view();
+		}
+
+		void endContainer(JSON::ObjectType)
+		{
+			const size_t first = frames.back();
+			const auto count = static_cast<uint32_t>(pending.size() - first);
+			const JSON::Node* members = JSON::allocateMembers(arena, pending[first - 1].type, pending.data() + first, count);
+			pending.resize(first);
+			frames.pop_back();
+
+			JSON::Node& container = pending.back();
+			container.children = members;
+			container.numChildren = static_cast<uint32_t>(count);
+			if (frames.empty())
+			{
+				root = container;
+				pending.clear();
+			}
+		}
+
+		void key(str_view k) { name = decode(k); }
+
+		void value(JSON::ObjectType type, str_view v)
+		{
+			if (type == JSON::ObjectType::String) { v = decode(v); }
+			if (frames.empty()) { root = JSON::Node(type, str_view(), v); } // lone value
+			else { pending.emplace_back(type, name, v); }
+			name = str_view();
+		}
+
+		void number(str_view text, const JSON::NumberValue& n)
+		{
+			JSON::Node node(JSON::ObjectType::Number, name, text);
+			node.integer = n.integer;
+			if (n.integer) { node.intValue = n.intValue; }
+			else { node.doubleValue = n.doubleValue; }
+
+			if (frames.empty()) { root = node; } // lone value, name is empty
+			else { pending.push_back(node); }
+			name = str_view();
+		}
+
+	private:
+		// strings with escape sequences are decoded into the arena, others stay views into the text
+		str_view decode(str_view raw)
+		{
+			if (!JSON::hasEscapes(raw)) { return raw; }
+			char_t* decoded = arena.allocateArray<char_t>(raw.size());
+			return str_view(decoded, JSON::unescapeString(raw, decoded));
+		}
+
+		JSON::Arena& arena;
+		JSON::Node& root;
+		std::vector<JSON::Node>& pending;
+		std::vector<size_t>& frames;
+		str_view name;
+	};
+
+	// scratch storage for parsing, reused between parses on the same thread
+	struct ParseScratch
+	{
+		std::vector<JSON::Node> pending; // members of open containers
+		std::vector<size_t> frames;
+		std::vector<uint32_t> structuralIndex;
+	};
+	thread_local ParseScratch scratch;
+}
 
 namespace JSONTextUtils
 {
@@ -117,21 +268,6 @@ namespace JSONTextUtils
 		return ((u & 0xFF) << 24) | ((u & 0xFF00) << 8) | ((u & 0xFF0000) >> 8) | ((u & 0xFF000000) >> 24);
 	}
 
-	std::u32string utf8to32str(str_view s, bool littleEndian)
-	{
-		std::u32string s32;
-		size_t i = 0;
-		if (!littleEndian)
-		{
-			while (i < s.size()) { s32 += utf8to32be(s, i); }
-		}
-		else
-		{
-			while (i < s.size()) { s32 += swapEndian32(utf8to32be(s, i)); }
-		}
-		return s32;
-	}
-
 	/*void test_utf8to32()
 	{
 		str_t vec("\xE0\xA4\xB9");
@@ -187,54 +323,54 @@ namespace JSON
 
 	Result load(str_view text, Object& objectOut)
 	{
-		std::vector<Token> tokens;
-		Result result = lex(text, tokens);
-		if (result != Result::OK) { return result; }
-		return parse(tokens, objectOut);
+		ObjectBuilder builder(objectOut);
+		return JSONReader::read(text, builder, scratch.structuralIndex);
+	}
+
+	Result load(str_view text, Document& documentOut)
+	{
+		documentOut.clear();
+		scratch.pending.clear();
+		scratch.frames.clear();
+		NodeBuilder builder(documentOut.arena, documentOut.rootNode, scratch.pending, scratch.frames);
+		const Result result = JSONReader::read(text, builder, scratch.structuralIndex);
+		if (result != Result::OK) { documentOut.clear(); }
+		return result;
 	}
 
 	Result loadFromFile(str_view filePath, Object& objectOut)
 	{
-		std::ifstream fs;
-		size_t fileSize;
-		if (!openFile(filePath, fs, fileSize)) { return Result::Error_File; }
-		str_t file;
-		file.resize(fileSize);
-		fs.read(&file[0], file.length());
+		// the Object tree copies its strings, so the mapping is only needed while parsing
+		MappedFile file;
+		if (!file.open(filePath)) { return Result::Error_File; }
+		return load(file.view(), objectOut);
+	}
 
-		return load(file, objectOut);
+	Result loadFromFile(str_view filePath, Document& documentOut)
+	{
+		// nodes reference the mapped pages directly, the document keeps the mapping alive
+		if (!documentOut.file.open(filePath)) { return Result::Error_File; }
+		return load(documentOut.file.view(), documentOut);
 	}
 	
 		
 	void testLexer(str_view filePath)
 	{
-		std::ifstream fs;
-		size_t fileSize;
-		if (!openFile(filePath, fs, fileSize)) { return; }
-		str_t file;
-		file.resize(fileSize);
-		fs.read(&file[0], file.length());
+		MappedFile file;
+		if (!file.open(filePath)) { return; }
 
-		std::vector<Token> tokens;
-		Result r = lex(file, tokens);
-		for (auto& token : tokens) 
+		using JSONReader::TokenKind;
+		JSONReader::Tokenizer tokenizer(file.view());
+		TokenKind kind;
+		str_view data;
+		while (tokenizer.next(kind, data) == Result::OK && kind != TokenKind::End)
 		{
-			if (token.type == TokenType::String)
-			{
-				std::cout << " \"" << token.data << "\" ";
-			}
-			else if (token.type == TokenType::Structural)
-			{
-				std::cout << token.data << " \n ";
-			}
-			else
-			{
-				std::cout << "  " << token.data;
-			}
+			if (kind == TokenKind::String) { std::cout << " \"" << data << "\""; }
+			else { std::cout << "  " << data; }
+			std::cout << "=" << JSONReader::tokenKindToString(kind);
+			if (kind < TokenKind::String) { std::cout << " \n"; } // structural
 		}
 		std::cout << "\n\n";
-
-		for (auto& token : tokens) { std::cout << "  " << token.data << "=" << tokenTypeToString(token.type); }
 	}
 
 	bool Object::isNamed() const
@@ -277,279 +413,101 @@ namespace JSON
 		type = ObjectType::Undefined;
 		subobjects.clear();
 		name = value = str_t();
+		keyIndex.clear();
+		intValue = 0;
+		doubleValue = 0.0;
+		integer = false;
 	}
 
-	str_t Object::toString(bool readable) const
+	const Object* Object::find(str_view key) const
 	{
-		if (subobjects.empty()) { return str_t(); }
-		size_t recursionDepth = -1;
-		return subobjects[0].getSubobjectsAsStringInternal(recursionDepth, readable);
-	}
-
-    str_t Object::getSubobjectsAsStringInternal(size_t& depth, bool readable) const
-    {
-		const str_t nl = (readable) ? "\n" : "";
-
-		depth++;
-		str_t indent;
-		if (readable) { for (size_t i = 0; i < depth; i++) { indent += "\t"; } }
-		str_t s = indent;
-
-		if (!name.empty()) { s += nl + indent + "\""+name+"\"" + ":"; }
-
-		if (type == ObjectType::Object)
-			s += nl + indent + "{";
-		else if (type == ObjectType::Array)
-			s += nl + indent + "[";
-
-		for (size_t i = 0; i < subobjects.size(); i++)
+		if (type != ObjectType::Object) { return nullptr; }
+		// the index is only trusted while it still matches the member count
+		if (!keyIndex.empty() && keyIndex.size() == keyIndexCapacity(static_cast<uint32_t>(subobjects.size())))
 		{
-			s += indent + subobjects[i].getSubobjectsAsStringInternal(depth, readable);
-			if (i < subobjects.size()-1) s += ",";
+			const uint32_t i = findKey(keyIndex.data(), static_cast<uint32_t>(keyIndex.size()), key, [this](uint32_t m)
+			{
+				return (m < subobjects.size()) ? str_view(subobjects[m].name) : str_view();
+			});
+			return (i == KEY_NOT_FOUND) ? nullptr : &subobjects[i];
 		}
-
-		if (type == ObjectType::Object)
-			s += nl + indent + "}";
-		else if (type == ObjectType::Array)
-			s += nl + indent + "]";
-
-		else if (type == ObjectType::String)
+		for (const Object& member : subobjects)
 		{
-			s += name.empty() ? nl + indent + "\"" + value + "\""  :  "\"" + value + "\"";
-			//if (!name.empty())
-			//	s += "\"" + value + "\"";
-			//else
-			//	s += nl + indent + "\"" + value + "\"";
+			if (member.name == key) { return &member; }
 		}
-		else
-			s += name.empty() ? nl + indent + value  :  value;
-			
-
-		depth--;
-        return s;
-    }
-	
-}
-
-namespace
-{
-
-	JSON::Result lex(str_view text, std::vector<Token>& tokens)
-	{
-		static_assert(CHAR_BIT == 8);
-		Token token;
-		bool inString = false;
-		bool inNumber = false;
-		bool inLiteral = false;
-
-		for (size_t i = 0; i < text.length(); i++)
-		{
-			const auto c = ctu8(text[i]);
-			auto numBytes = numBytesChar(c);
-			if (!numBytes) { return JSON::Result::Error_Lexer_InvalidEncoding; }
-
-			if (!inString) // structural
-			{
-				if (inNumber && !isNumerical(c))
-				{
-					tokens.push_back(token);
-					token.reset();
-					inNumber = false;
-				}
-				if (isNumerical(c))
-				{
-					if (inNumber) { token.data.push_back(c); } // digit or symbol (found next digit)
-					else { token.data.push_back(c); token.type = TokenType::Number; inNumber = true; } // start of number
-				} 
-				else if (isWhitespaceChar(c)) { continue; }
-				else if (isStructuralChar(c)) { tokens.push_back(Token(TokenType::Structural, str_t(1, c))); }
-				else if (c == STR_DELIM) { token.type = TokenType::String; inString = true; }
-
-				else if (isliteralBooleanStr(i, text)) { tokens.push_back(Token(TokenType::Boolean, literalBooleanValue(i, text))); }
-				else if (isLiteralNullStr(i, text)) { tokens.push_back(Token(TokenType::Null, literalNullValue(i))); }
-
-				else if (numBytes > 1) { return JSON::Result::Error_Lexer_IllegalTokenMultiByte; }
-				else { return JSON::Result::Error_Lexer_IllegalToken; }
-			}
-			else // string	
-			{
-				if (numBytes == 1)
-				{
-					if (c != STR_DELIM) { token.data.push_back(c); } // string constituent ASCII
-					else // end of string
-					{
-						tokens.push_back(token);
-						token.reset();
-						inString = false;
-					}
-				}
-				else
-				{
-					// start of multi-byte UTF-8 codepoint
-				}
-			}
-		}
-		return JSON::Result::OK;
+		return nullptr;
 	}
 
-
-	bool getFileSize(str_view filePath, size_t& fileSizeOut)
+	Object* Object::find(str_view key)
 	{
-		if (!std::filesystem::exists(filePath)) { return false; }
-		fileSizeOut = static_cast<size_t>(std::filesystem::file_size(filePath));
-		return true;
+		return const_cast<Object*>(std::as_const(*this).find(key));
 	}
 
-	bool openFile(str_view filePath, std::ifstream& fileStreamOut, size_t& fileSizeOut)
+	const Object& Object::operator[](str_view key) const
 	{
-		if (!getFileSize(filePath, fileSizeOut)) { return false; }
-		fileStreamOut.open(filePath, std::ios_base::binary);
-		return static_cast<bool>(fileStreamOut);
+		static const Object undefinedObject;
+		const Object* member = find(key);
+		return member ? *member : undefinedObject;
 	}
 
-	str_view tokenTypeToString(TokenType t)
+	void Object::rebuildKeyIndex()
 	{
-		switch (t)
+		const auto count = static_cast<uint32_t>(subobjects.size());
+		if (type != ObjectType::Object || count < KEY_INDEX_MIN_MEMBERS)
 		{
-		case TokenType::Undefined: return str_view("Undefined");
-		case TokenType::Structural: return str_view("Structural");
-		case TokenType::String: return str_view("String");
-		case TokenType::Number: return str_view("Number");
-		case TokenType::Boolean: return str_view("Boolean");
-		case TokenType::Null: return str_view("Null");
-		default: return str_view("UnknownTokenType");
+			keyIndex.clear();
+			return;
 		}
+		keyIndex.resize(keyIndexCapacity(count));
+		buildKeyIndex(keyIndex.data(), static_cast<uint32_t>(keyIndex.size()), count, [this](uint32_t m) { return str_view(subobjects[m].name); });
 	}
 
-	StructuralTokenType structuralTokenToObjType(const Token& token)
+	bool Object::isInteger() const
 	{
-		if (token.type != TokenType::Structural) { return StructuralTokenType::NotStructural; }
-		switch (token.data[0])
-		{
-			case STC_CBR_L: return StructuralTokenType::ObjectBegin;
-			case STC_CBR_R: return StructuralTokenType::ObjectEnd;
-			case STC_SBR_L: return StructuralTokenType::ArrayBegin;
-			case STC_SBR_R: return StructuralTokenType::ArrayEnd;
-			case STC_CL:	return StructuralTokenType::KeyValueDelim;
-			case STC_CM:	return StructuralTokenType::MemberDelim;
-			default:		return StructuralTokenType::NotStructural;
-		}
+		return type == ObjectType::Number && integer;
 	}
 
-	JSON::ObjectType valueTokenToObjType(const Token& token)
+	int64_t Object::asInt() const
 	{
-		switch (token.type)
-		{
-			case TokenType::String: return JSON::ObjectType::String;
-			case TokenType::Number: return JSON::ObjectType::Number;
-			case TokenType::Boolean: return JSON::ObjectType::Boolean;
-			case TokenType::Null: return JSON::ObjectType::Null;
-			default: return JSON::ObjectType::Undefined;
-		}
+		if (type != ObjectType::Number) { return 0; }
+		return integer ? intValue : doubleToInt(doubleValue);
 	}
-	
-	JSON::Result parse(const std::vector<Token>& tokens, JSON::Object& objectOut)
+
+	double Object::asDouble() const
 	{
-		objectOut.reset();
-		auto numTokens = tokens.size();
-		RETURN_ERROR_IF(!numTokens, Error_Parser_NoTokens); // fail: no tokens passed to parser
+		if (type != ObjectType::Number) { return 0.0; }
+		return doubleValue;
+	}
 
-		if (valueTokenToObjType(tokens[0]) != JSON::ObjectType::Undefined)
-		{
-			// string, number, bool, or null at start
-			RETURN_ERROR_IF(numTokens > 1, Error_Parser_InvalidRoot); // fail: text root must be a lone value, an unnamed object, or an unnamed array
-			objectOut.set(valueTokenToObjType(tokens[0]), tokens[0].data);
-			return JSON::Result::OK; // lone value is ok
-		}
-		RETURN_ERROR_IF(tokens[0].data[0] != STC_SBR_L && tokens[0].data[0] != STC_CBR_L, Error_Parser_IllegalTokenAtStart); // fail: incorrect structural character at start
+	str_t Object::toString(bool readable) const
+	{
+		if (subobjects.empty()) { return str_t(); }
+		Writer writer(readable ? WriteMode::Pretty : WriteMode::Compact);
+		writer.value(subobjects[0]);
+		return writer.release();
+	}
 
-		std::stack<JSON::Object> objects;
-		objects.push(JSON::Object(JSON::ObjectType::Object, "root"));
-		str_view name;
-		const Token* lastToken = nullptr;
+}
 
-		for (size_t i = 0; i < numTokens; i++)
+namespace JSONReader
+{
+	str_view tokenKindToString(TokenKind k)
+	{
+		switch (k)
 		{
-			const TokenType type = tokens[i].type;
-			const str_view data = tokens[i].data;
-
-			if (i > 0) { lastToken = &tokens[i-1]; }
-			RETURN_ERROR_IF(type == TokenType::Undefined, Error_Parser_UndefinedToken); // fail: token with undefined type passed to parser
-			RETURN_ERROR_IF(data.empty(), Error_Parser_EmptyToken); // fail: empty token passed to parser
-
-			const JSON::ObjectType valueType = valueTokenToObjType(tokens[i]);
-			const StructuralTokenType strucType = structuralTokenToObjType(tokens[i]);
-			const bool isArrayToken = (strucType == StructuralTokenType::ArrayBegin || strucType == StructuralTokenType::ArrayEnd);
-			const bool isInArray = objects.top().type == JSON::ObjectType::Array;
-
-			if (strucType != StructuralTokenType::NotStructural)
-			{
-				// structural  [ ] { } , :
-				if (strucType == StructuralTokenType::ObjectBegin || strucType == StructuralTokenType::ArrayBegin)
-				{
-					// begin container
-					RETURN_ERROR_IF(isInArray && !name.empty(), Error_Parser_NamedValueInArray); // fail: named object inside array
-					RETURN_ERROR_IF(!isInArray && name.empty() && i != 0, Error_Parser_LoneValue); // fail: unnamed object not allowed outside arrays
-					if (i > 0)
-					{
-						const StructuralTokenType prevStrucType = structuralTokenToObjType(tokens[name.empty() ? i - 1 : i - 3]);
-						RETURN_ERROR_IF(prevStrucType != StructuralTokenType::MemberDelim &&
-										prevStrucType != StructuralTokenType::ObjectBegin &&
-										prevStrucType != StructuralTokenType::ArrayBegin, 
-										Error_Parser_MissingSeparator); // fail: unexpected token  
-					}
-					objects.push(JSON::Object(isArrayToken ? JSON::ObjectType::Array : JSON::ObjectType::Object, name));
-					name = str_view(); // clear name
-				}
-				else if (strucType == StructuralTokenType::ObjectEnd || strucType == StructuralTokenType::ArrayEnd)
-				{
-					// end container
-					JSON::Object top = objects.top();
-					RETURN_ERROR_IF((top.type == JSON::ObjectType::Array) != isArrayToken, Error_Parser_IllegalClosingToken); // fail: incorrect token at end of container
-					objects.pop();
-					objects.top().subobjects.push_back(top);
-				}
-				else if (strucType == StructuralTokenType::KeyValueDelim)
-				{
-					// fail: delimiter not following a string is illegal (pairs are properly handled when a name string is encountered)
-					RETURN_ERROR(Error_Parser_InvalidKeyValuePair);
-				}
-				// commas are ignored at first, handled in the next iteration
-				else if (strucType != StructuralTokenType::MemberDelim)
-				{
-					RETURN_ERROR(Error_Parser_UndefinedToken);
-				}
-			}
-			
-			else if (valueType != JSON::ObjectType::Undefined)
-			{
-				// string, number, bool, or null
-				if (i + 1 >= numTokens) { RETURN_ERROR(Error_Parser_ExpectedTokenAfterValue); } // fail: expected additional tokens following value
-				
-				if (valueType == JSON::ObjectType::String && structuralTokenToObjType(tokens[i+1]) == StructuralTokenType::KeyValueDelim)
-				{
-					// key-value pair (handled in two iterations)
-					const auto nextStrucType = structuralTokenToObjType(tokens[i+2]);
-					if (valueTokenToObjType(tokens[i+2]) == JSON::ObjectType::Undefined && 
-						nextStrucType != StructuralTokenType::ArrayBegin && 
-						nextStrucType != StructuralTokenType::ObjectBegin) 
-					{
-						RETURN_ERROR(Error_Parser_InvalidKeyValuePair); // fail: expected a named value or object
-					} 
-					if (isInArray) { RETURN_ERROR(Error_Parser_NamedValueInArray); } // fail: named value inside array
-					name = data;
-					i++; // skip the ":"
-					continue;
-				}
-				else if (name.empty() && objects.top().type != JSON::ObjectType::Array) { RETURN_ERROR(Error_Parser_LoneValue); } // fail: unnamed value not allowed outside arrays
-
-				objects.top().subobjects.push_back(JSON::Object(valueType, name, data));
-				name = str_view(); // clear name
-			}
-
+		case TokenKind::ObjectBegin: return str_view("ObjectBegin");
+		case TokenKind::ObjectEnd: return str_view("ObjectEnd");
+		case TokenKind::ArrayBegin: return str_view("ArrayBegin");
+		case TokenKind::ArrayEnd: return str_view("ArrayEnd");
+		case TokenKind::KeyValueDelim: return str_view("KeyValueDelim");
+		case TokenKind::MemberDelim: return str_view("MemberDelim");
+		case TokenKind::String: return str_view("String");
+		case TokenKind::Number: return str_view("Number");
+		case TokenKind::Boolean: return str_view("Boolean");
+		case TokenKind::Null: return str_view("Null");
+		case TokenKind::End: return str_view("End");
+		default: return str_view("UnknownTokenKind");
 		}
-		objectOut = objects.top();
-		return JSON::Result::OK;
 	}
 }
 
@@ -43,8 +43,11 @@ namespace JSONTextUtils
 	uint32_t utf8to32be(str_view fullString, size_t& startIndexInOut);
 	// swaps the endianness of a 32-bit number (e.g. a UTF-32 codepoint)
 	uint32_t swapEndian32(uint32_t u);
-	// converts a whole string from UTF-8 to UTF-32
+	/* converts a whole string from UTF-8 to UTF-32, invalid sequences become U+FFFD (see Unicode.cpp)
+	ASCII runs are widened 16 or 32 bytes at a time depending on the SIMD level, multi-byte sequences are decoded one by one */
 	std::u32string utf8to32str(str_view s, bool littleEndian = false);
+	// same as above into an existing string, whose capacity is reused (e.g. for text transcoded every frame)
+	void utf8to32str(str_view s, std::u32string& out, bool littleEndian = false);
 	void test_utf8to32();
 
 }
@@ -73,20 +76,37 @@ namespace JSON
 		size_t size() const noexcept;
 		void set(ObjectType t, JSONTextUtils::str_view v);
 
+		// numbers are decoded while parsing, integers that fit in 64 bits are exact
+		bool isInteger() const;
+		// non-integers are truncated, non-numbers return 0
+		int64_t asInt() const;
+		double asDouble() const;
+
 	public:
+		// serializes the top-level value (the first subobject of the root), tab-indented if readable
 		JSONTextUtils::str_t toString(bool readable = true) const;
-	private:
-		JSONTextUtils::str_t getSubobjectsAsStringInternal(size_t& depth, bool readable) const;
-	public:
 
 		Object& operator[](int i) { return subobjects[i]; }
 		const Object& operator[](int i) const { return subobjects[i]; }
+		std::vector<Object>::const_iterator begin() const { return subobjects.begin(); }
+		std::vector<Object>::const_iterator end() const { return subobjects.end(); }
+
+		// first member with the given name, nullptr if missing (or not an object)
+		Object* find(JSONTextUtils::str_view key);
+		const Object* find(JSONTextUtils::str_view key) const;
+		// like find(), but returns an undefined object if the key is missing
+		const Object& operator[](JSONTextUtils::str_view key) const;
+		// large objects get a hash index when parsed, call this after adding or renaming members by hand
+		void rebuildKeyIndex();
 
 		JSONTextUtils::str_t name;
 		std::vector<Object> subobjects;
 		ObjectType type;
 		JSONTextUtils::str_t value;
-
+		int64_t intValue = 0;
+		double doubleValue = 0.0;
+		bool integer = false;
+		std::vector<uint32_t> keyIndex; // see rebuildKeyIndex()
 
 	};
 
@@ -108,7 +128,16 @@ namespace JSON
 		Error_Parser_NamedValueInArray			= 13,	// key-value pair inside array
 		Error_Parser_LoneValue					= 14,	// unnamed value not allowed outside arrays
 		Error_Parser_InvalidKeyValuePair		= 15,	// invalid name or value
-		Error_Parser_MissingSeparator			= 16	// expected comma before token
+		Error_Parser_MissingSeparator			= 16,	// expected comma before token
+		Error_Parser_UnexpectedSeparator		= 17,	// comma without a preceding or following member
+		Error_Lexer_UnterminatedString			= 18,	// text ended inside a string
+		Error_Lexer_InvalidNumber				= 19,	// number does not follow the JSON number grammar
+		Error_Binary_InvalidFormat				= 20,	// binary data has the wrong header, version or size
+		Error_Binary_TooLarge					= 21,	// tree does not fit the 32-bit offsets of the binary format
+		Error_Bind_TypeMismatch					= 22,	// value does not fit the type of the bound field
+		Error_Bind_UnknownEnumName				= 23,	// string is not one of the names of the bound enum
+		Error_Parser_TextTooLarge				= 24,	// text does not fit the 32-bit offsets of the structural index
+		Error_Lexer_InvalidEscape				= 25	// unknown escape sequence, or \u not followed by 4 hex digits
 	};
 	#define RETURN_ERROR(err) return JSON::Result::err
 	#define RETURN_ERROR_IF(condition, err) if (condition) { RETURN_ERROR(err); }
@@ -123,34 +152,4 @@ namespace
 {
 	using namespace JSONTextUtils;
 
-	enum class TokenType { Undefined, Structural, String, Number, Boolean, Null };
-	enum class StructuralTokenType { NotStructural, ObjectBegin, ObjectEnd, ArrayBegin, ArrayEnd, KeyValueDelim, MemberDelim };
-	class Token 
-	{ 
-	public:
-		TokenType type; 
-		str_t data;
-		Token() { reset(); }
-		Token(TokenType t, str_view d) : type{ t }, data{ d } {};
-		void reset() { data.clear(); type = TokenType::Undefined; }
-	};
-
-	JSON::Result lex(str_view text, std::vector<Token>& tokens);
-	JSON::Result parse(const std::vector<Token>& tokens, JSON::Object& obj);
-	
-	bool getFileSize(str_view filePath, size_t& fileSizeOut);
-	bool openFile(str_view filePath, std::ifstream& fileStreamOut, size_t& fileSizeOut);
-
-	str_view tokenTypeToString(TokenType t);
-	StructuralTokenType tokenToStructuralType(const Token& token);
-	JSON::ObjectType valueTokenToObjType(const Token& token);
-
-
-	
-
-
-}
-
-
-
-
+}
\ No newline at end of file
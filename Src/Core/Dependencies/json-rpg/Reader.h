@@ -0,0 +1,476 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include "Parser.h"
+#include "StructuralIndex.h"
+#include "Unicode.h"
+#include "Number.h"
+
+#include <array>
+#include <climits>
+
+// internal single-pass reader shared by the DOM builders, not part of the public json-rpg interface
+namespace JSONReader
+{
+	using namespace JSONTextUtils;
+	using JSON::Result;
+	using JSON::ObjectType;
+
+	enum class TokenKind : uint8_t
+	{
+		ObjectBegin, ObjectEnd, ArrayBegin, ArrayEnd, KeyValueDelim, MemberDelim,
+		String, Number, Boolean, Null, End
+	};
+
+	inline bool isValueToken(TokenKind k) { return k >= TokenKind::String && k <= TokenKind::Null; }
+
+	inline ObjectType tokenToObjType(TokenKind k)
+	{
+		switch (k)
+		{
+			case TokenKind::String: return ObjectType::String;
+			case TokenKind::Number: return ObjectType::Number;
+			case TokenKind::Boolean: return ObjectType::Boolean;
+			case TokenKind::Null: return ObjectType::Null;
+			default: return ObjectType::Undefined;
+		}
+	}
+
+	inline TokenKind structuralCharToToken(char_t c)
+	{
+		switch (c)
+		{
+			case STC_CBR_L: return TokenKind::ObjectBegin;
+			case STC_CBR_R: return TokenKind::ObjectEnd;
+			case STC_SBR_L: return TokenKind::ArrayBegin;
+			case STC_SBR_R: return TokenKind::ArrayEnd;
+			case STC_CL:	return TokenKind::KeyValueDelim;
+			default:		return TokenKind::MemberDelim;
+		}
+	}
+
+	str_view tokenKindToString(TokenKind k);
+
+	// per-byte character classes for the hot loops, same sets as the JSONTextUtils predicates but inlined
+	enum CharClass : uint8_t { CC_Whitespace = 1, CC_Structural = 2, CC_Numerical = 4, CC_Quote = 8, CC_Backslash = 16 };
+
+	inline constexpr auto charClasses = []
+	{
+		std::array<uint8_t, 256> table{};
+		for (uint8_t c : { ' ', '\t', '\n', '\r' }) { table[c] = CC_Whitespace; }
+		for (uint8_t c : { STC_SBR_L, STC_SBR_R, STC_CBR_L, STC_CBR_R, STC_CL, STC_CM }) { table[c] = CC_Structural; }
+		for (uint8_t c : { '+', '-', '.', 'e', 'E' }) { table[c] = CC_Numerical; }
+		for (uint8_t c = '0'; c <= '9'; c++) { table[c] = CC_Numerical; }
+		table[static_cast<uint8_t>(STR_DELIM)] = CC_Quote;
+		table[static_cast<uint8_t>('\\')] = CC_Backslash;
+		return table;
+	}();
+
+	inline bool hasCharClass(char_t c, uint8_t classes) { return charClasses[static_cast<uint8_t>(c)] & classes; }
+
+	// error for a byte that cannot start a token
+	inline Result illegalCharError(char_t c)
+	{
+		const auto numBytes = numBytesChar(c);
+		RETURN_ERROR_IF(!numBytes, Error_Lexer_InvalidEncoding);
+		RETURN_ERROR_IF(numBytes > 1, Error_Lexer_IllegalTokenMultiByte);
+		RETURN_ERROR(Error_Lexer_IllegalToken);
+	}
+
+	// anything glued to a number or literal (e.g. truefalse) is an error on both token sources
+	inline Result checkScalarEnd(str_view text, size_t end)
+	{
+		if (end >= text.size() || hasCharClass(text[end], CC_Whitespace | CC_Structural | CC_Quote)) { return Result::OK; }
+		return illegalCharError(text[end]);
+	}
+
+	/* scans one token at a time straight from the source text, token data are views into the text
+	string tokens exclude the quotes, escape sequences are checked but left as-is (see unescapeString) */
+	class Tokenizer
+	{
+	public:
+		Tokenizer(str_view text) : text{ text } {};
+
+		Result next(TokenKind& kindOut, str_view& dataOut)
+		{
+			while (pos < text.size() && hasCharClass(text[pos], CC_Whitespace)) { pos++; }
+			tokenBegin = pos;
+			if (pos >= text.size()) { kindOut = TokenKind::End; return Result::OK; }
+
+			const char_t c = text[pos];
+			const auto numBytes = numBytesChar(c);
+			RETURN_ERROR_IF(!numBytes, Error_Lexer_InvalidEncoding);
+
+			if (hasCharClass(c, CC_Structural))
+			{
+				kindOut = structuralCharToToken(c);
+				dataOut = text.substr(pos++, 1);
+				return Result::OK;
+			}
+			if (c == STR_DELIM)
+			{
+				kindOut = TokenKind::String;
+				return scanString(dataOut);
+			}
+			if (hasCharClass(c, CC_Numerical))
+			{
+				const size_t start = pos;
+				while (pos < text.size() && hasCharClass(text[pos], CC_Numerical)) { pos++; }
+				kindOut = TokenKind::Number;
+				dataOut = text.substr(start, pos - start);
+				return checkScalarEnd(text, pos);
+			}
+			if (isliteralBooleanStr(pos, text))
+			{
+				const size_t len = (c == 't') ? 4 : 5;
+				kindOut = TokenKind::Boolean;
+				dataOut = text.substr(pos, len);
+				pos += len;
+				return checkScalarEnd(text, pos);
+			}
+			if (isLiteralNullStr(pos, text))
+			{
+				kindOut = TokenKind::Null;
+				dataOut = text.substr(pos, 4);
+				pos += 4;
+				return checkScalarEnd(text, pos);
+			}
+			return illegalCharError(c);
+		}
+
+		size_t position() const { return pos; }
+		// offset of the last token returned (or the one that failed)
+		size_t tokenStart() const { return tokenBegin; }
+
+	private:
+		Result scanString(str_view& dataOut)
+		{
+			const size_t start = ++pos; // skip opening quote
+			while (pos < text.size())
+			{
+				const char_t c = text[pos];
+				if (c == STR_DELIM)
+				{
+					dataOut = text.substr(start, pos - start);
+					pos++;
+					return Result::OK;
+				}
+				if (c == '\\')
+				{
+					const Result result = scanEscape();
+					if (result != Result::OK) { return result; }
+					continue;
+				}
+				if (!(c & 0x80)) { pos++; continue; } // ASCII
+
+				const auto numBytes = numBytesChar(c);
+				RETURN_ERROR_IF(!numBytes, Error_Lexer_InvalidEncoding);
+				if (numBytes > 1)
+				{
+					// multi-byte UTF-8 codepoint, kept as-is in the string
+					RETURN_ERROR_IF(pos + numBytes > text.size(), Error_Lexer_UnterminatedString); // text ended inside the codepoint
+					RETURN_ERROR_IF(!JSON::isValidUTF8Sequence(text.data() + pos, numBytes), Error_Lexer_IncompleteUnicodeInString);
+				}
+				pos += numBytes;
+			}
+			RETURN_ERROR(Error_Lexer_UnterminatedString);
+		}
+
+		// text ending inside the escape is reported as an unterminated string, so chunked input can be resumed
+		Result scanEscape()
+		{
+			RETURN_ERROR_IF(pos + 1 >= text.size(), Error_Lexer_UnterminatedString);
+			if (text[pos + 1] != 'u')
+			{
+				RETURN_ERROR_IF(!JSON::isSimpleEscape(text[pos + 1]), Error_Lexer_InvalidEscape);
+				pos += 2;
+				return Result::OK;
+			}
+			for (size_t k = pos + 2; k < pos + 6; k++)
+			{
+				RETURN_ERROR_IF(k >= text.size(), Error_Lexer_UnterminatedString);
+				RETURN_ERROR_IF(JSON::hexDigitValue(text[k]) < 0, Error_Lexer_InvalidEscape);
+			}
+			pos += 6;
+			return Result::OK;
+		}
+
+		str_view text;
+		size_t pos = 0;
+		size_t tokenBegin = 0;
+	};
+
+	/* walks a structural index (see JSON::buildStructuralIndex), only the bytes at indexed positions and
+	the scalars starting there are looked at, string contents and whitespace are skipped over entirely
+	produces the same tokens as Tokenizer, string contents were already validated as UTF-8 by stage 1 */
+	class IndexedTokenizer
+	{
+	public:
+		IndexedTokenizer(str_view text, const std::vector<uint32_t>& index) : text{ text }, index{ index } {};
+
+		Result next(TokenKind& kindOut, str_view& dataOut)
+		{
+			if (i >= index.size()) { kindOut = TokenKind::End; return Result::OK; }
+
+			const size_t pos = index[i++];
+			const char_t c = text[pos];
+			if (c == STR_DELIM)
+			{
+				// the closing quote is always the next entry, unterminated strings fail in stage 1
+				const size_t close = index[i++];
+				kindOut = TokenKind::String;
+				dataOut = text.substr(pos + 1, close - pos - 1);
+				return JSON::hasEscapes(dataOut) ? JSON::validateEscapes(dataOut) : Result::OK;
+			}
+			if (hasCharClass(c, CC_Structural))
+			{
+				kindOut = structuralCharToToken(c);
+				dataOut = text.substr(pos, 1);
+				return Result::OK;
+			}
+
+			size_t end = pos;
+			if (hasCharClass(c, CC_Numerical))
+			{
+				while (end < text.size() && hasCharClass(text[end], CC_Numerical)) { end++; }
+				kindOut = TokenKind::Number;
+			}
+			else if (isliteralBooleanStr(pos, text))
+			{
+				end = pos + ((c == 't') ? 4 : 5);
+				kindOut = TokenKind::Boolean;
+			}
+			else if (isLiteralNullStr(pos, text))
+			{
+				end = pos + 4;
+				kindOut = TokenKind::Null;
+			}
+			else { return illegalCharError(c); }
+
+			// the rest of a scalar is not indexed, so anything glued to it has to be caught here
+			dataOut = text.substr(pos, end - pos);
+			return checkScalarEnd(text, end);
+		}
+
+	private:
+		str_view text;
+		const std::vector<uint32_t>& index;
+		size_t i = 0;
+	};
+
+	/* validates the token sequence and forwards it as events to a handler with the members
+	beginContainer(ObjectType), endContainer(ObjectType), key(str_view), value(ObjectType, str_view),
+	and number(str_view, const NumberValue&) for numbers, which are validated and decoded here
+	keys always arrive as a separate event directly before their value or container */
+	class Grammar
+	{
+	public:
+		template<typename Handler>
+		Result accept(TokenKind kind, str_view data, Handler& handler)
+		{
+			const bool isValue = isValueToken(kind);
+			const bool isBegin = (kind == TokenKind::ObjectBegin || kind == TokenKind::ArrayBegin);
+			const bool isEnd = (kind == TokenKind::ObjectEnd || kind == TokenKind::ArrayEnd);
+
+			switch (state)
+			{
+			case State::Start:
+				if (isValue)
+				{
+					const Result result = emitValue(kind, data, handler);
+					state = State::Done; // lone value
+					return result;
+				}
+				RETURN_ERROR_IF(!isBegin, Error_Parser_IllegalTokenAtStart); // fail: incorrect structural character at start
+				return openContainer(kind, handler);
+
+			case State::Done:
+				RETURN_ERROR(Error_Parser_InvalidRoot); // fail: text root must be a lone value, an unnamed object, or an unnamed array
+
+			case State::ObjectKeyOrEnd:
+			case State::ObjectKey:
+				if (kind == TokenKind::String)
+				{
+					handler.key(data);
+					state = State::ObjectColon;
+					return Result::OK;
+				}
+				if (kind == TokenKind::ObjectEnd)
+				{
+					RETURN_ERROR_IF(state == State::ObjectKey, Error_Parser_UnexpectedSeparator); // fail: trailing comma
+					return closeContainer(kind, handler);
+				}
+				RETURN_ERROR_IF(kind == TokenKind::ArrayEnd, Error_Parser_IllegalClosingToken); // fail: incorrect token at end of container
+				RETURN_ERROR_IF(kind == TokenKind::MemberDelim, Error_Parser_UnexpectedSeparator); // fail: comma without preceding member
+				RETURN_ERROR_IF(kind == TokenKind::KeyValueDelim, Error_Parser_InvalidKeyValuePair); // fail: delimiter not following a name
+				RETURN_ERROR(Error_Parser_LoneValue); // fail: unnamed value not allowed outside arrays
+
+			case State::ObjectColon:
+				RETURN_ERROR_IF(kind != TokenKind::KeyValueDelim, Error_Parser_LoneValue); // fail: unnamed value not allowed outside arrays
+				state = State::ObjectValue;
+				return Result::OK;
+
+			case State::ObjectValue:
+				if (isValue) { return acceptValue(kind, data, handler); }
+				if (isBegin) { return openContainer(kind, handler); }
+				RETURN_ERROR(Error_Parser_InvalidKeyValuePair); // fail: expected a named value or object
+
+			case State::ArrayValueOrEnd:
+			case State::ArrayValue:
+				if (isValue) { return acceptValue(kind, data, handler); }
+				if (isBegin) { return openContainer(kind, handler); }
+				if (kind == TokenKind::ArrayEnd)
+				{
+					RETURN_ERROR_IF(state == State::ArrayValue, Error_Parser_UnexpectedSeparator); // fail: trailing comma
+					return closeContainer(kind, handler);
+				}
+				RETURN_ERROR_IF(kind == TokenKind::ObjectEnd, Error_Parser_IllegalClosingToken); // fail: incorrect token at end of container
+				RETURN_ERROR_IF(kind == TokenKind::MemberDelim, Error_Parser_UnexpectedSeparator); // fail: comma without preceding member
+				RETURN_ERROR(Error_Parser_InvalidKeyValuePair); // fail: delimiter not following a name
+
+			case State::AfterMember:
+				if (kind == TokenKind::MemberDelim)
+				{
+					state = (containers.back() == ObjectType::Object) ? State::ObjectKey : State::ArrayValue;
+					return Result::OK;
+				}
+				if (isEnd) { return closeContainer(kind, handler); }
+				if (kind == TokenKind::KeyValueDelim)
+				{
+					RETURN_ERROR_IF(lastWasString && containers.back() == ObjectType::Array, Error_Parser_NamedValueInArray); // fail: key-value pair inside array
+					RETURN_ERROR(Error_Parser_InvalidKeyValuePair); // fail: delimiter not following a name
+				}
+				RETURN_ERROR(Error_Parser_MissingSeparator); // fail: expected comma before token
+			}
+			RETURN_ERROR(Error_Parser_UndefinedToken);
+		}
+
+		// checks that the text ended in a valid place
+		Result finish() const
+		{
+			switch (state)
+			{
+				case State::Start: RETURN_ERROR(Error_Parser_NoTokens); // fail: empty or whitespace-only text
+				case State::Done: return Result::OK;
+				case State::AfterMember:
+				case State::ObjectColon: RETURN_ERROR(Error_Parser_ExpectedTokenAfterValue); // fail: expected additional tokens following value
+				case State::ObjectValue: RETURN_ERROR(Error_Parser_InvalidKeyValuePair); // fail: name without value
+				default: RETURN_ERROR(Error_Parser_IllegalClosingToken); // fail: container left open at end of text
+			}
+		}
+
+		void reset()
+		{
+			containers.clear();
+			state = State::Start;
+			lastWasString = false;
+		}
+
+		size_t depth() const { return containers.size(); }
+		bool isComplete() const { return state == State::Done; }
+
+	private:
+		enum class State : uint8_t
+		{
+			Start, Done, ObjectKeyOrEnd, ObjectKey, ObjectColon, ObjectValue, ArrayValueOrEnd, ArrayValue, AfterMember
+		};
+
+		template<typename Handler>
+		Result emitValue(TokenKind kind, str_view data, Handler& handler)
+		{
+			if (kind != TokenKind::Number)
+			{
+				handler.value(tokenToObjType(kind), data);
+				return Result::OK;
+			}
+			JSON::NumberValue number;
+			const Result result = JSON::parseNumber(data, number);
+			if (result != Result::OK) { return result; }
+			handler.number(data, number);
+			return Result::OK;
+		}
+
+		template<typename Handler>
+		Result acceptValue(TokenKind kind, str_view data, Handler& handler)
+		{
+			const Result result = emitValue(kind, data, handler);
+			if (result != Result::OK) { return result; }
+			lastWasString = (kind == TokenKind::String);
+			state = State::AfterMember;
+			return Result::OK;
+		}
+
+		template<typename Handler>
+		Result openContainer(TokenKind kind, Handler& handler)
+		{
+			const bool isArray = (kind == TokenKind::ArrayBegin);
+			const ObjectType type = isArray ? ObjectType::Array : ObjectType::Object;
+			containers.push_back(type);
+			handler.beginContainer(type);
+			state = isArray ? State::ArrayValueOrEnd : State::ObjectKeyOrEnd;
+			return Result::OK;
+		}
+
+		// the closing bracket has to match the innermost open container
+		template<typename Handler>
+		Result closeContainer(TokenKind kind, Handler& handler)
+		{
+			const ObjectType type = containers.back();
+			const bool closesArray = (kind == TokenKind::ArrayEnd);
+			RETURN_ERROR_IF(closesArray != (type == ObjectType::Array), Error_Parser_IllegalClosingToken); // fail: incorrect token at end of container
+			containers.pop_back();
+			handler.endContainer(type);
+			lastWasString = false;
+			state = containers.empty() ? State::Done : State::AfterMember;
+			return Result::OK;
+		}
+
+		std::vector<ObjectType> containers; // types of the open containers
+		State state = State::Start;
+		bool lastWasString = false;
+	};
+
+	// tokenizes and parses in a single pass, no intermediate token storage
+	template<typename TokenSource, typename Handler>
+	Result read(TokenSource& tokenizer, Handler& handler)
+	{
+		Grammar grammar;
+		TokenKind kind;
+		str_view data;
+		while (true)
+		{
+			Result result = tokenizer.next(kind, data);
+			if (result != Result::OK) { return result; }
+			if (kind == TokenKind::End) { return grammar.finish(); }
+			result = grammar.accept(kind, data, handler);
+			if (result != Result::OK) { return result; }
+		}
+	}
+
+	/* stage 1 reports an unterminated string or invalid UTF-8 before any token is looked at, the tokenizer
+	finds errors in text order instead. if the tokenizer failed, the text is run through stage 1 and its error
+	is returned in place of the tokenizer's, the cost is only paid on the error path */
+	inline Result preferStage1Error(str_view text, Result result, std::vector<uint32_t>& scratch)
+	{
+		if (result == Result::OK || text.size() >= UINT32_MAX) { return result; }
+		const Result stage1 = JSON::buildStructuralIndex(text, scratch);
+		return (stage1 != Result::OK) ? stage1 : result;
+	}
+
+	/* builds the structural index into scratch and reads from it, the byte-at-a-time tokenizer is used as the
+	scalar fallback (it is faster than a scalar stage 1) and for texts too large for 32-bit offsets
+	error codes do not depend on the SIMD level, both token sources return the same error for the same text */
+	template<typename Handler>
+	Result read(str_view text, Handler& handler, std::vector<uint32_t>& scratch)
+	{
+		if (JSON::getSimdLevel() == JSON::SimdLevel::Scalar || text.size() >= UINT32_MAX)
+		{
+			Tokenizer tokenizer(text);
+			return preferStage1Error(text, read(tokenizer, handler), scratch);
+		}
+		const Result result = JSON::buildStructuralIndex(text, scratch);
+		if (result != Result::OK) { return result; }
+		IndexedTokenizer tokenizer(text, scratch);
+		return read(tokenizer, handler);
+	}
+
+}
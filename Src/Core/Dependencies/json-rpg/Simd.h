@@ -0,0 +1,17 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+
+// internal, platform switches for the vectorized code paths, the level to use is chosen at runtime (see StructuralIndex.h)
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+	#define JSON_RPG_X86 1
+	#include <immintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+		#define JSON_RPG_TARGET(isa)
+	#else
+		#include <cpuid.h>
+		#define JSON_RPG_TARGET(isa) __attribute__((target(isa)))
+	#endif
+#else
+	#define JSON_RPG_X86 0
+#endif
@@ -0,0 +1,244 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#include "Stream.h"
+
+#include <memory>
+
+namespace
+{
+	using JSON::ObjectType;
+
+	// forwards Grammar events to the virtual SAX interface
+	struct HandlerAdapter
+	{
+		JSON::Handler& handler;
+
+		void beginContainer(ObjectType type) { (type == ObjectType::Object) ? handler.beginObject() : handler.beginArray(); }
+		void endContainer(ObjectType type) { (type == ObjectType::Object) ? handler.endObject() : handler.endArray(); }
+		void key(str_view k) { handler.key(k); }
+		void value(ObjectType type, str_view v) { handler.value(type, v); }
+		void number(str_view text, const JSON::NumberValue& n) { handler.number(text, n); }
+	};
+
+	// stores the Grammar event produced by one token, delimiter tokens produce none
+	struct EventCapture
+	{
+		JSON::Event& event;
+		bool produced = false;
+
+		void set(JSON::EventType type, ObjectType valueType = ObjectType::Undefined, str_view data = str_view())
+		{
+			event = JSON::Event{ type, valueType, data, JSON::NumberValue() };
+			produced = true;
+		}
+		void beginContainer(ObjectType type) { set((type == ObjectType::Object) ? JSON::EventType::BeginObject : JSON::EventType::BeginArray); }
+		void endContainer(ObjectType type) { set((type == ObjectType::Object) ? JSON::EventType::EndObject : JSON::EventType::EndArray); }
+		void key(str_view k) { set(JSON::EventType::Key, ObjectType::Undefined, k); }
+		void value(ObjectType type, str_view v) { set(JSON::EventType::Value, type, v); }
+		void number(str_view text, const JSON::NumberValue& n)
+		{
+			set(JSON::EventType::Value, ObjectType::Number, text);
+			event.number = n;
+		}
+	};
+
+	bool isLiteralPrefix(str_view s)
+	{
+		return s.size() < 5 && (str_view("true").starts_with(s) || str_view("false").starts_with(s) || str_view("null").starts_with(s));
+	}
+}
+
+namespace JSONReader
+{
+	void ChunkedTokenizer::feed(str_view newChunk)
+	{
+		chunk = newChunk;
+		pos = 0;
+	}
+
+	void ChunkedTokenizer::reset()
+	{
+		chunk = str_view();
+		pos = 0;
+		carry.clear();
+		carryReturned = false;
+		final = false;
+	}
+
+	/* true if the token may continue past the end of text, numbers and literals touching the end are carried too,
+	the byte after them decides whether they are complete or glued to something illegal (e.g. true-0) */
+	bool ChunkedTokenizer::isIncomplete(Result result, TokenKind kind, str_view text, const Tokenizer& tokenizer) const
+	{
+		if (result == Result::Error_Lexer_UnterminatedString) { return true; }
+		if (result == Result::Error_Lexer_IllegalToken) { return isLiteralPrefix(text.substr(tokenizer.tokenStart())); }
+		const bool isScalar = (kind == TokenKind::Number || kind == TokenKind::Boolean || kind == TokenKind::Null);
+		return result == Result::OK && isScalar && tokenizer.position() == text.size();
+	}
+
+	Result ChunkedTokenizer::next(TokenKind& kindOut, str_view& dataOut, bool& needInputOut)
+	{
+		needInputOut = false;
+		if (carryReturned)
+		{
+			carry.clear();
+			carryReturned = false;
+		}
+		if (!carry.empty()) { return nextFromCarry(kindOut, dataOut, needInputOut); }
+
+		const str_view rest = chunk.substr(pos);
+		Tokenizer tokenizer(rest);
+		const Result result = tokenizer.next(kindOut, dataOut);
+		if (!final && isIncomplete(result, kindOut, rest, tokenizer))
+		{
+			carry.assign(rest.substr(tokenizer.tokenStart()));
+			pos = chunk.size();
+			kindOut = TokenKind::End;
+			needInputOut = true;
+			return Result::OK;
+		}
+		if (result != Result::OK) { return result; }
+
+		if (kindOut == TokenKind::End)
+		{
+			pos = chunk.size();
+			needInputOut = !final;
+			return Result::OK;
+		}
+		pos += tokenizer.position();
+		return Result::OK;
+	}
+
+	Result ChunkedTokenizer::nextFromCarry(TokenKind& kindOut, str_view& dataOut, bool& needInputOut)
+	{
+		while (true)
+		{
+			Tokenizer tokenizer(carry);
+			const Result result = tokenizer.next(kindOut, dataOut);
+			if (isIncomplete(result, kindOut, carry, tokenizer))
+			{
+				if (pos < chunk.size())
+				{
+					// take bytes up to and including the next byte that could end the token, then retry
+					size_t cut = pos;
+					if (carry[0] == STR_DELIM) { cut = chunk.find(STR_DELIM, pos); }
+					else { while (cut < chunk.size() && !hasCharClass(chunk[cut], CC_Whitespace | CC_Structural | CC_Quote)) { cut++; } }
+					cut = (cut >= chunk.size()) ? chunk.size() : cut + 1;
+					carry.append(chunk.substr(pos, cut - pos));
+					pos = cut;
+					continue;
+				}
+				if (!final)
+				{
+					kindOut = TokenKind::End;
+					needInputOut = true;
+					return Result::OK;
+				}
+				// end of input, the token is as complete as it gets
+			}
+			if (result != Result::OK) { return result; }
+
+			// the bytes taken past the end of the token are given back to the chunk
+			const size_t end = tokenizer.position();
+			pos -= carry.size() - end;
+			carry.resize(end);
+			carryReturned = true;
+			return Result::OK;
+		}
+	}
+}
+
+namespace JSON
+{
+	Result StreamParser::feed(str_view chunk)
+	{
+		HandlerAdapter adapter{ handler };
+		tokenizer.feed(chunk);
+		JSONReader::TokenKind kind;
+		str_view data;
+		bool needInput;
+		while (true)
+		{
+			Result result = tokenizer.next(kind, data, needInput);
+			if (result != Result::OK) { return result; }
+			if (kind == JSONReader::TokenKind::End) { return Result::OK; } // the rest is checked in finish()
+			result = grammar.accept(kind, data, adapter);
+			if (result != Result::OK) { return result; }
+		}
+	}
+
+	Result StreamParser::finish()
+	{
+		HandlerAdapter adapter{ handler };
+		tokenizer.finish();
+		JSONReader::TokenKind kind;
+		str_view data;
+		bool needInput;
+		while (true)
+		{
+			Result result = tokenizer.next(kind, data, needInput);
+			if (result != Result::OK) { return result; }
+			if (kind == JSONReader::TokenKind::End) { return grammar.finish(); }
+			result = grammar.accept(kind, data, adapter);
+			if (result != Result::OK) { return result; }
+		}
+	}
+
+	void StreamParser::reset()
+	{
+		tokenizer.reset();
+		grammar.reset();
+	}
+
+	Result PullParser::next(Event& eventOut)
+	{
+		JSONReader::TokenKind kind;
+		str_view data;
+		bool needInput;
+		while (true)
+		{
+			Result result = tokenizer.next(kind, data, needInput);
+			if (result != Result::OK) { return result; }
+			if (needInput)
+			{
+				eventOut = Event{ EventType::NeedInput };
+				return Result::OK;
+			}
+			if (kind == JSONReader::TokenKind::End)
+			{
+				result = grammar.finish();
+				eventOut = Event{ EventType::End };
+				return result;
+			}
+
+			EventCapture capture{ eventOut };
+			result = grammar.accept(kind, data, capture);
+			if (result != Result::OK) { return result; }
+			if (capture.produced) { return Result::OK; }
+		}
+	}
+
+	void PullParser::reset()
+	{
+		tokenizer.reset();
+		grammar.reset();
+	}
+
+	Result streamFromFile(str_view filePath, Handler& handler, size_t chunkSize)
+	{
+		std::ifstream fs(std::filesystem::path(filePath), std::ios_base::binary);
+		if (!fs) { return Result::Error_File; }
+
+		StreamParser parser(handler);
+		const auto buffer = std::make_unique<char_t[]>(chunkSize);
+		while (fs)
+		{
+			fs.read(buffer.get(), chunkSize);
+			const auto numRead = static_cast<size_t>(fs.gcount());
+			if (!numRead) { break; }
+			const Result result = parser.feed(str_view(buffer.get(), numRead));
+			if (result != Result::OK) { return result; }
+		}
+		RETURN_ERROR_IF(fs.bad(), Error_File);
+		return parser.finish();
+	}
+
+}
@@ -0,0 +1,111 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include "Parser.h"
+#include "Reader.h"
+
+namespace JSONReader
+{
+	/* tokenizer over input that arrives in chunks split at arbitrary bytes
+	a token cut off at the end of a chunk is moved into a small carry buffer and completed from the next chunk,
+	so memory use is bounded by the longest single token rather than the size of the input */
+	class ChunkedTokenizer
+	{
+	public:
+		// the chunk must stay alive until next() asks for more input
+		void feed(str_view chunk);
+		// no more input will follow, tokens at the end of the last chunk are complete
+		void finish() { final = true; }
+		void reset();
+
+		// needInputOut is set (with kind End) when the current chunk is used up but finish() has not been called
+		Result next(TokenKind& kindOut, str_view& dataOut, bool& needInputOut);
+
+	private:
+		bool isIncomplete(Result result, TokenKind kind, str_view text, const Tokenizer& tokenizer) const;
+		Result nextFromCarry(TokenKind& kindOut, str_view& dataOut, bool& needInputOut);
+
+		str_view chunk;
+		size_t pos = 0;
+		str_t carry; // start of a token that continues in the next chunk
+		bool carryReturned = false; // the last token was returned from the carry, cleared on the next call
+		bool final = false;
+	};
+}
+
+namespace JSON
+{
+	/* SAX callbacks for StreamParser, override the ones you need
+	views passed to the callbacks are only valid for the duration of the call */
+	class Handler
+	{
+	public:
+		virtual ~Handler() = default;
+
+		virtual void beginObject() {}
+		virtual void endObject() {}
+		virtual void beginArray() {}
+		virtual void endArray() {}
+		// name of the next value, object or array
+		virtual void key(str_view /*name*/) {}
+		virtual void value(ObjectType /*type*/, str_view /*value*/) {}
+		// numbers arrive decoded, by default they are passed on to value() as text
+		virtual void number(str_view text, const NumberValue& /*decoded*/) { value(ObjectType::Number, text); }
+	};
+
+	/* push parser, takes text in chunks of any size and emits events to a handler as soon as they are complete
+	string values are passed as they appear in the text, escape sequences are checked but not decoded (see unescapeString)
+	errors are reported in text order as soon as they are found, the events and the result do not depend on where the text is split
+	load() looks for unterminated strings and invalid UTF-8 in the whole text before anything else, which a stream can't do without
+	holding all of it, so when load() returns one of those errors a stream may return an error found earlier in the text instead
+	the same texts are accepted either way. PullParser behaves the same */
+	class StreamParser
+	{
+	public:
+		explicit StreamParser(Handler& handler) : handler{ handler } {};
+
+		// parses as much of the chunk as possible, the chunk does not need to outlive the call
+		Result feed(str_view chunk);
+		// signals the end of input and checks that the text ended in a valid place
+		Result finish();
+		void reset();
+
+		size_t depth() const { return grammar.depth(); }
+
+	private:
+		Handler& handler;
+		JSONReader::ChunkedTokenizer tokenizer;
+		JSONReader::Grammar grammar;
+	};
+
+	enum class EventType { BeginObject, EndObject, BeginArray, EndArray, Key, Value, NeedInput, End };
+
+	struct Event
+	{
+		EventType type = EventType::End;
+		ObjectType valueType = ObjectType::Undefined; // for Value events
+		str_view data{}; // key name or value text
+		NumberValue number{}; // decoded value for numbers
+	};
+
+	/* pull parser, the caller feeds a chunk and calls next() until it returns a NeedInput event
+	the chunk must stay alive until then, event data stays valid until the next call to next() */
+	class PullParser
+	{
+	public:
+		void feed(str_view chunk) { tokenizer.feed(chunk); }
+		// no more input will follow, next() returns an End event once the remaining events are read
+		void finish() { tokenizer.finish(); }
+		Result next(Event& eventOut);
+		void reset();
+
+		size_t depth() const { return grammar.depth(); }
+
+	private:
+		JSONReader::ChunkedTokenizer tokenizer;
+		JSONReader::Grammar grammar;
+	};
+
+	// reads the file in chunks of chunkSize bytes and streams it through the handler, memory use does not grow with file size
+	Result streamFromFile(str_view filePath, Handler& handler, size_t chunkSize = 64 * 1024);
+
+}
@@ -0,0 +1,335 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#include "StructuralIndex.h"
+#include "Reader.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <climits>
+#include <cstring>
+
+namespace
+{
+	using namespace JSONTextUtils;
+	using JSON::Result;
+
+	constexpr size_t BLOCK_SIZE = 64;
+
+	// one bit per byte of a 64-byte block
+	struct BlockMasks
+	{
+		uint64_t quote = 0;
+		uint64_t backslash = 0;
+		uint64_t op = 0; // {}[]:,
+		uint64_t whitespace = 0;
+		uint64_t nonAscii = 0;
+	};
+
+	// carried from one block to the next
+	struct ScanState
+	{
+		uint64_t prevEscaped = 0;	// first byte of the next block is escaped
+		uint64_t prevInString = 0;	// all ones if the previous block ended inside a string
+		uint64_t prevScalar = 0;	// last byte of the previous block was part of a scalar
+		uint64_t nonAscii = 0;
+	};
+
+	// bit i of the result is the xor of bits 0..i of x, turns quote bits into string regions
+	inline uint64_t prefixXor(uint64_t x)
+	{
+		x ^= x << 1;
+		x ^= x << 2;
+		x ^= x << 4;
+		x ^= x << 8;
+		x ^= x << 16;
+		x ^= x << 32;
+		return x;
+	}
+
+	// characters preceded by an odd number of consecutive backslashes
+	inline uint64_t findEscaped(uint64_t backslash, ScanState& state)
+	{
+		constexpr uint64_t evenBits = 0x5555555555555555ULL;
+		backslash &= ~state.prevEscaped; // an escaped backslash does not start a new escape
+		const uint64_t followsEscape = (backslash << 1) | state.prevEscaped;
+
+		// runs starting on odd bits are offset by adding them to the backslashes, the carry moves to the next block
+		const uint64_t oddStarts = backslash & ~evenBits & ~followsEscape;
+		const uint64_t sequencesOnEvenBits = oddStarts + backslash;
+		state.prevEscaped = (sequencesOnEvenBits < oddStarts) ? 1 : 0;
+		const uint64_t invertMask = sequencesOnEvenBits << 1;
+		return (evenBits ^ invertMask) & followsEscape;
+	}
+
+	// turns the classified bytes of one block into index bits
+	inline uint64_t structuralBits(const BlockMasks& m, ScanState& state)
+	{
+		const uint64_t quote = m.quote & ~findEscaped(m.backslash, state);
+
+		// opening quote and string contents are set, closing quote is not
+		const uint64_t inString = prefixXor(quote) ^ state.prevInString;
+		state.prevInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+
+		// numbers and literals are indexed by their first byte only
+		const uint64_t scalar = ~(m.op | m.whitespace | quote);
+		const uint64_t followsScalar = (scalar << 1) | state.prevScalar;
+		state.prevScalar = scalar >> 63;
+		const uint64_t scalarStart = scalar & ~followsScalar;
+
+		state.nonAscii |= m.nonAscii;
+		return ((m.op | scalarStart) & ~inString) | quote;
+	}
+
+	// appends the offsets of all set bits, the index always has room for a full block
+	inline void flatten(uint64_t bits, uint32_t blockOffset, uint32_t*& out)
+	{
+		while (bits)
+		{
+			*out++ = blockOffset + static_cast<uint32_t>(std::countr_zero(bits));
+			bits &= bits - 1;
+		}
+	}
+
+	/* grows the index so that it can take another block, returns the write position
+	the vector is sized (not just reserved) so the block functions can write through a raw pointer */
+	inline uint32_t* reserveBlock(std::vector<uint32_t>& index, size_t& count)
+	{
+		if (count + BLOCK_SIZE > index.size()) { index.resize(std::max(index.size() * 2, count + BLOCK_SIZE)); }
+		return index.data() + count;
+	}
+
+	void classifyScalar(const uint8_t* in, BlockMasks& m)
+	{
+		using namespace JSONReader;
+		m = BlockMasks();
+		for (size_t i = 0; i < BLOCK_SIZE; i++)
+		{
+			const uint8_t cls = charClasses[in[i]];
+			m.quote |= static_cast<uint64_t>((cls & CC_Quote) != 0) << i;
+			m.backslash |= static_cast<uint64_t>((cls & CC_Backslash) != 0) << i;
+			m.op |= static_cast<uint64_t>((cls & CC_Structural) != 0) << i;
+			m.whitespace |= static_cast<uint64_t>((cls & CC_Whitespace) != 0) << i;
+			m.nonAscii |= static_cast<uint64_t>(in[i] >> 7) << i;
+		}
+	}
+
+	// the last partial block is copied into a buffer padded with whitespace
+	template<typename BlockFunction>
+	void scanBlocks(str_view text, std::vector<uint32_t>& index, size_t& count, ScanState& state, BlockFunction block)
+	{
+		const auto* data = reinterpret_cast<const uint8_t*>(text.data());
+		const size_t fullBlocks = text.size() / BLOCK_SIZE;
+		for (size_t b = 0; b < fullBlocks; b++)
+		{
+			uint32_t* out = reserveBlock(index, count);
+			uint32_t* end = out;
+			block(data + b * BLOCK_SIZE, static_cast<uint32_t>(b * BLOCK_SIZE), state, end);
+			count += end - out;
+		}
+
+		const size_t tail = text.size() % BLOCK_SIZE;
+		if (tail)
+		{
+			uint8_t padded[BLOCK_SIZE];
+			std::memset(padded, ' ', BLOCK_SIZE);
+			std::memcpy(padded, data + fullBlocks * BLOCK_SIZE, tail);
+			uint32_t* out = reserveBlock(index, count);
+			uint32_t* end = out;
+			block(padded, static_cast<uint32_t>(fullBlocks * BLOCK_SIZE), state, end);
+			count += end - out;
+		}
+	}
+
+	void scanBlockScalar(const uint8_t* in, uint32_t blockOffset, ScanState& state, uint32_t*& out)
+	{
+		BlockMasks m;
+		classifyScalar(in, m);
+		flatten(structuralBits(m, state), blockOffset, out);
+	}
+
+#if JSON_RPG_X86
+	/* whitespace is matched with a nibble lookup, a byte is whitespace if it equals the table entry at its low nibble
+	ops are matched the same way after OR-ing 0x20, which maps [ and ] onto { and }
+	(0x0C and 0x1A also pass as ops, they are illegal outside strings and rejected when the index is walked) */
+	#define JSON_RPG_WHITESPACE_TABLE ' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100, '\r', 100, 100
+	#define JSON_RPG_OP_TABLE 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0
+
+	JSON_RPG_TARGET("sse4.2")
+	inline uint64_t maskSSE(__m128i a, __m128i b, __m128i c, __m128i d)
+	{
+		return static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(a))) |
+			(static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(b))) << 16) |
+			(static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(c))) << 32) |
+			(static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(d))) << 48);
+	}
+
+	JSON_RPG_TARGET("sse4.2")
+	void scanBlockSSE42(const uint8_t* in, uint32_t blockOffset, ScanState& state, uint32_t*& out)
+	{
+		__m128i c[4];
+		for (int i = 0; i < 4; i++) { c[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 16)); }
+
+		const __m128i quote = _mm_set1_epi8(STR_DELIM);
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i curlify = _mm_set1_epi8(0x20);
+		const __m128i whitespaceTable = _mm_setr_epi8(JSON_RPG_WHITESPACE_TABLE);
+		const __m128i opTable = _mm_setr_epi8(JSON_RPG_OP_TABLE);
+
+		__m128i q[4], bs[4], ws[4], op[4];
+		for (int i = 0; i < 4; i++)
+		{
+			q[i] = _mm_cmpeq_epi8(c[i], quote);
+			bs[i] = _mm_cmpeq_epi8(c[i], backslash);
+			ws[i] = _mm_cmpeq_epi8(c[i], _mm_shuffle_epi8(whitespaceTable, c[i]));
+			op[i] = _mm_cmpeq_epi8(_mm_or_si128(c[i], curlify), _mm_shuffle_epi8(opTable, c[i]));
+		}
+
+		BlockMasks m;
+		m.quote = maskSSE(q[0], q[1], q[2], q[3]);
+		m.backslash = maskSSE(bs[0], bs[1], bs[2], bs[3]);
+		m.whitespace = maskSSE(ws[0], ws[1], ws[2], ws[3]);
+		m.op = maskSSE(op[0], op[1], op[2], op[3]);
+		m.nonAscii = maskSSE(c[0], c[1], c[2], c[3]); // movemask takes the high bits
+
+		flatten(structuralBits(m, state), blockOffset, out);
+	}
+
+	JSON_RPG_TARGET("avx2")
+	inline uint64_t maskAVX2(__m256i lo, __m256i hi)
+	{
+		return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(lo))) |
+			(static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(hi))) << 32);
+	}
+
+	JSON_RPG_TARGET("avx2")
+	void scanBlockAVX2(const uint8_t* in, uint32_t blockOffset, ScanState& state, uint32_t*& out)
+	{
+		const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+		const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 32));
+
+		const __m256i quote = _mm256_set1_epi8(STR_DELIM);
+		const __m256i backslash = _mm256_set1_epi8('\\');
+		const __m256i curlify = _mm256_set1_epi8(0x20);
+		// vpshufb looks up within each 128-bit lane, so the tables are repeated
+		const __m256i whitespaceTable = _mm256_setr_epi8(JSON_RPG_WHITESPACE_TABLE, JSON_RPG_WHITESPACE_TABLE);
+		const __m256i opTable = _mm256_setr_epi8(JSON_RPG_OP_TABLE, JSON_RPG_OP_TABLE);
+
+		BlockMasks m;
+		m.quote = maskAVX2(_mm256_cmpeq_epi8(lo, quote), _mm256_cmpeq_epi8(hi, quote));
+		m.backslash = maskAVX2(_mm256_cmpeq_epi8(lo, backslash), _mm256_cmpeq_epi8(hi, backslash));
+		m.whitespace = maskAVX2(
+			_mm256_cmpeq_epi8(lo, _mm256_shuffle_epi8(whitespaceTable, lo)),
+			_mm256_cmpeq_epi8(hi, _mm256_shuffle_epi8(whitespaceTable, hi)));
+		m.op = maskAVX2(
+			_mm256_cmpeq_epi8(_mm256_or_si256(lo, curlify), _mm256_shuffle_epi8(opTable, lo)),
+			_mm256_cmpeq_epi8(_mm256_or_si256(hi, curlify), _mm256_shuffle_epi8(opTable, hi)));
+		m.nonAscii = maskAVX2(lo, hi);
+
+		flatten(structuralBits(m, state), blockOffset, out);
+	}
+
+	#undef JSON_RPG_WHITESPACE_TABLE
+	#undef JSON_RPG_OP_TABLE
+
+	void cpuid(int leaf, int subleaf, uint32_t (&regs)[4])
+	{
+	#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuidex(info, leaf, subleaf);
+		for (int i = 0; i < 4; i++) { regs[i] = static_cast<uint32_t>(info[i]); }
+	#else
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+	#endif
+	}
+
+	uint64_t xgetbv()
+	{
+	#if defined(_MSC_VER) && !defined(__clang__)
+		return _xgetbv(0);
+	#else
+		uint32_t eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (static_cast<uint64_t>(edx) << 32) | eax;
+	#endif
+	}
+#endif
+
+	JSON::SimdLevel detectSimdLevelInternal()
+	{
+	#if JSON_RPG_X86
+		uint32_t regs[4];
+		cpuid(0, 0, regs);
+		const uint32_t maxLeaf = regs[0];
+		if (maxLeaf < 1) { return JSON::SimdLevel::Scalar; }
+
+		cpuid(1, 0, regs);
+		const bool sse42 = regs[2] & (1u << 20);
+		const bool osxsave = regs[2] & (1u << 27);
+		if (!sse42) { return JSON::SimdLevel::Scalar; }
+
+		// AVX2 also needs the OS to save the upper halves of the ymm registers
+		if (maxLeaf >= 7 && osxsave && (xgetbv() & 0x6) == 0x6)
+		{
+			cpuid(7, 0, regs);
+			if (regs[1] & (1u << 5)) { return JSON::SimdLevel::AVX2; }
+		}
+		return JSON::SimdLevel::SSE42;
+	#else
+		return JSON::SimdLevel::Scalar;
+	#endif
+	}
+
+	const JSON::SimdLevel supportedLevel = detectSimdLevelInternal();
+	std::atomic<JSON::SimdLevel> activeLevel{ supportedLevel };
+}
+
+namespace JSON
+{
+	SimdLevel detectSimdLevel()
+	{
+		return supportedLevel;
+	}
+
+	void setSimdLevel(SimdLevel level)
+	{
+		activeLevel = std::min(level, supportedLevel);
+	}
+
+	SimdLevel getSimdLevel()
+	{
+		return activeLevel;
+	}
+
+	str_view simdLevelToString(SimdLevel level)
+	{
+		switch (level)
+		{
+			case SimdLevel::SSE42: return "SSE4.2";
+			case SimdLevel::AVX2: return "AVX2";
+			default: return "Scalar";
+		}
+	}
+
+	Result buildStructuralIndex(str_view text, std::vector<uint32_t>& indexOut)
+	{
+		assert(text.size() < UINT32_MAX && "structural index offsets are 32-bit");
+		ScanState state;
+		size_t count = 0;
+		switch (getSimdLevel())
+		{
+		#if JSON_RPG_X86
+			case SimdLevel::AVX2: scanBlocks(text, indexOut, count, state, scanBlockAVX2); break;
+			case SimdLevel::SSE42: scanBlocks(text, indexOut, count, state, scanBlockSSE42); break;
+		#endif
+			default: scanBlocks(text, indexOut, count, state, scanBlockScalar); break;
+		}
+		indexOut.resize(count);
+
+		RETURN_ERROR_IF(state.prevInString, Error_Lexer_UnterminatedString); // fail: text ended inside a string
+		if (state.nonAscii) { return validateUTF8(text); }
+		return Result::OK;
+	}
+
+}
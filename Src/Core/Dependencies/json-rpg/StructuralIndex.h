@@ -0,0 +1,28 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include "Parser.h"
+#include "Unicode.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace JSON
+{
+	// instruction set used by the vectorized stages of the parser
+	enum class SimdLevel { Scalar, SSE42, AVX2 };
+
+	// highest level supported by the CPU (and OS) we are running on
+	SimdLevel detectSimdLevel();
+	// selects the implementation used from now on, levels above what the CPU supports are clamped
+	void setSimdLevel(SimdLevel level);
+	SimdLevel getSimdLevel();
+	JSONTextUtils::str_view simdLevelToString(SimdLevel level);
+
+	/* stage 1 of the parser, scans the text 64 bytes at a time and records the offsets of all structural
+	characters and scalar (number/literal) starts outside strings, as well as every unescaped quote
+	the opening and closing quote of a string are always adjacent in the index
+	also validates UTF-8 (see validateUTF8) when the text contains non-ASCII bytes
+	texts must be smaller than 4 GiB, since offsets are stored as 32-bit integers */
+	Result buildStructuralIndex(JSONTextUtils::str_view text, std::vector<uint32_t>& indexOut);
+
+}
@@ -0,0 +1,488 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#include "Unicode.h"
+#include "StructuralIndex.h"
+#include "Simd.h"
+
+#include <bit>
+#include <cstring>
+
+namespace
+{
+	using namespace JSONTextUtils;
+	using JSON::Result;
+
+	constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+
+	// exact error for invalid text, also used to classify what the vectorized check found
+	Result validateUTF8Scalar(str_view text)
+	{
+		const char_t* p = text.data();
+		const size_t size = text.size();
+		size_t i = 0;
+		while (i < size)
+		{
+			// ASCII runs are skipped a word at a time
+			if (i + 8 <= size)
+			{
+				uint64_t word;
+				std::memcpy(&word, p + i, 8);
+				if (!(word & HIGH_BITS))
+				{
+					i += 8;
+					continue;
+				}
+			}
+			if (!(ctu8(p[i]) & 0x80))
+			{
+				i++;
+				continue;
+			}
+			const auto numBytes = numBytesChar(p[i]);
+			RETURN_ERROR_IF(numBytes < 2, Error_Lexer_InvalidEncoding);
+			RETURN_ERROR_IF(i + numBytes > size, Error_Lexer_IncompleteUnicodeInString);
+			RETURN_ERROR_IF(!JSON::isValidUTF8Sequence(p + i, numBytes), Error_Lexer_IncompleteUnicodeInString);
+			i += numBytes;
+		}
+		return Result::OK;
+	}
+
+#if JSON_RPG_X86
+	/* lookup-based validation (Keiser & Lemire, "Validating UTF-8 in less than one instruction per byte")
+	each byte is checked together with the one before it through three nibble tables whose bits name error classes,
+	an error needs all three lookups to agree, and the 3rd/4th bytes of long sequences are checked separately */
+	constexpr uint8_t TOO_SHORT = 1 << 0;	// lead byte followed by a lead byte or ASCII
+	constexpr uint8_t TOO_LONG = 1 << 1;	// ASCII followed by a continuation byte
+	constexpr uint8_t OVERLONG_3 = 1 << 2;
+	constexpr uint8_t TOO_LARGE = 1 << 3;
+	constexpr uint8_t SURROGATE = 1 << 4;
+	constexpr uint8_t OVERLONG_2 = 1 << 5;
+	constexpr uint8_t TOO_LARGE_1000 = 1 << 6;
+	constexpr uint8_t OVERLONG_4 = 1 << 6;
+	constexpr uint8_t TWO_CONTS = 1 << 7;	// continuation byte where none is expected, or a 3rd/4th byte
+	constexpr uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+	#define JSON_RPG_UTF8_BYTE1_HIGH \
+		TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, \
+		TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS, \
+		TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE, TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4
+	#define JSON_RPG_UTF8_BYTE1_LOW \
+		CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY, \
+		CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, \
+		CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, \
+		CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000
+	#define JSON_RPG_UTF8_BYTE2_HIGH \
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, \
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4, \
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE, \
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE, \
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE, \
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+	// a block may only end in a lead byte if the next block continues it, bytes above these need more bytes
+	#define JSON_RPG_UTF8_INCOMPLETE_16 \
+		static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF), \
+		static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF), \
+		static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF), \
+		static_cast<char>(0xFF), static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1)
+	#define JSON_RPG_UTF8_FF_16 \
+		static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF), \
+		static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF), \
+		static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF), \
+		static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF), static_cast<char>(0xFF)
+
+	struct UTF8StateSSE
+	{
+		__m128i error;
+		__m128i prevInput;
+		__m128i prevIncomplete;
+	};
+
+	JSON_RPG_TARGET("sse4.2")
+	inline void checkUTF8SSE(__m128i input, UTF8StateSSE& state)
+	{
+		const __m128i lowNibble = _mm_set1_epi8(0x0F);
+		const __m128i prev1 = _mm_alignr_epi8(input, state.prevInput, 15);
+		const __m128i byte1High = _mm_shuffle_epi8(_mm_setr_epi8(JSON_RPG_UTF8_BYTE1_HIGH), _mm_and_si128(_mm_srli_epi16(prev1, 4), lowNibble));
+		const __m128i byte1Low = _mm_shuffle_epi8(_mm_setr_epi8(JSON_RPG_UTF8_BYTE1_LOW), _mm_and_si128(prev1, lowNibble));
+		const __m128i byte2High = _mm_shuffle_epi8(_mm_setr_epi8(JSON_RPG_UTF8_BYTE2_HIGH), _mm_and_si128(_mm_srli_epi16(input, 4), lowNibble));
+		const __m128i special = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+
+		// bytes 2 and 3 after a 3- or 4-byte lead must be continuations, which TWO_CONTS marked as errors above
+		const __m128i prev2 = _mm_alignr_epi8(input, state.prevInput, 14);
+		const __m128i prev3 = _mm_alignr_epi8(input, state.prevInput, 13);
+		const __m128i isThird = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+		const __m128i isFourth = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+		const __m128i must23 = _mm_and_si128(_mm_or_si128(isThird, isFourth), _mm_set1_epi8(static_cast<char>(0x80)));
+		state.error = _mm_or_si128(state.error, _mm_xor_si128(must23, special));
+
+		state.prevIncomplete = _mm_subs_epu8(input, _mm_setr_epi8(JSON_RPG_UTF8_INCOMPLETE_16));
+		state.prevInput = input;
+	}
+
+	JSON_RPG_TARGET("sse4.2")
+	bool isValidUTF8SSE42(str_view text)
+	{
+		UTF8StateSSE state{ _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+		const auto* p = reinterpret_cast<const uint8_t*>(text.data());
+		const size_t size = text.size();
+		alignas(16) uint8_t tail[64];
+		for (size_t i = 0; i < size; i += 64)
+		{
+			const uint8_t* block = p + i;
+			if (size - i < 64)
+			{
+				// the last block is padded with ASCII
+				std::memset(tail, ' ', sizeof(tail));
+				std::memcpy(tail, block, size - i);
+				block = tail;
+			}
+			__m128i c[4];
+			for (int k = 0; k < 4; k++) { c[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + k * 16)); }
+			const __m128i any = _mm_or_si128(_mm_or_si128(c[0], c[1]), _mm_or_si128(c[2], c[3]));
+			if (!_mm_movemask_epi8(any))
+			{
+				// all ASCII, only a sequence left open by the previous block can be wrong
+				state.error = _mm_or_si128(state.error, state.prevIncomplete);
+				continue;
+			}
+			for (int k = 0; k < 4; k++) { checkUTF8SSE(c[k], state); }
+		}
+		state.error = _mm_or_si128(state.error, state.prevIncomplete);
+		return _mm_testz_si128(state.error, state.error);
+	}
+
+	struct UTF8StateAVX2
+	{
+		__m256i error;
+		__m256i prevInput;
+		__m256i prevIncomplete;
+	};
+
+	// input shifted by n bytes across the lane boundary, with the last bytes of prev shifted in
+	#define JSON_RPG_PREV_AVX2(input, prev, n) _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - (n))
+
+	JSON_RPG_TARGET("avx2")
+	inline void checkUTF8AVX2(__m256i input, UTF8StateAVX2& state)
+	{
+		const __m256i lowNibble = _mm256_set1_epi8(0x0F);
+		const __m256i prev1 = JSON_RPG_PREV_AVX2(input, state.prevInput, 1);
+		const __m256i byte1High = _mm256_shuffle_epi8(_mm256_setr_epi8(JSON_RPG_UTF8_BYTE1_HIGH, JSON_RPG_UTF8_BYTE1_HIGH),
+			_mm256_and_si256(_mm256_srli_epi16(prev1, 4), lowNibble));
+		const __m256i byte1Low = _mm256_shuffle_epi8(_mm256_setr_epi8(JSON_RPG_UTF8_BYTE1_LOW, JSON_RPG_UTF8_BYTE1_LOW),
+			_mm256_and_si256(prev1, lowNibble));
+		const __m256i byte2High = _mm256_shuffle_epi8(_mm256_setr_epi8(JSON_RPG_UTF8_BYTE2_HIGH, JSON_RPG_UTF8_BYTE2_HIGH),
+			_mm256_and_si256(_mm256_srli_epi16(input, 4), lowNibble));
+		const __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+		const __m256i prev2 = JSON_RPG_PREV_AVX2(input, state.prevInput, 2);
+		const __m256i prev3 = JSON_RPG_PREV_AVX2(input, state.prevInput, 3);
+		const __m256i isThird = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+		const __m256i isFourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+		const __m256i must23 = _mm256_and_si256(_mm256_or_si256(isThird, isFourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+		state.error = _mm256_or_si256(state.error, _mm256_xor_si256(must23, special));
+
+		state.prevIncomplete = _mm256_subs_epu8(input, _mm256_setr_epi8(JSON_RPG_UTF8_FF_16, JSON_RPG_UTF8_INCOMPLETE_16));
+		state.prevInput = input;
+	}
+
+	JSON_RPG_TARGET("avx2")
+	bool isValidUTF8AVX2(str_view text)
+	{
+		UTF8StateAVX2 state{ _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256() };
+		const auto* p = reinterpret_cast<const uint8_t*>(text.data());
+		const size_t size = text.size();
+		alignas(32) uint8_t tail[64];
+		for (size_t i = 0; i < size; i += 64)
+		{
+			const uint8_t* block = p + i;
+			if (size - i < 64)
+			{
+				std::memset(tail, ' ', sizeof(tail));
+				std::memcpy(tail, block, size - i);
+				block = tail;
+			}
+			const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+			const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+			if (!_mm256_movemask_epi8(_mm256_or_si256(lo, hi)))
+			{
+				state.error = _mm256_or_si256(state.error, state.prevIncomplete);
+				continue;
+			}
+			checkUTF8AVX2(lo, state);
+			checkUTF8AVX2(hi, state);
+		}
+		state.error = _mm256_or_si256(state.error, state.prevIncomplete);
+		return _mm256_testz_si256(state.error, state.error);
+	}
+
+	#undef JSON_RPG_PREV_AVX2
+	#undef JSON_RPG_UTF8_BYTE1_HIGH
+	#undef JSON_RPG_UTF8_BYTE1_LOW
+	#undef JSON_RPG_UTF8_BYTE2_HIGH
+	#undef JSON_RPG_UTF8_INCOMPLETE_16
+	#undef JSON_RPG_UTF8_FF_16
+#endif
+
+	uint32_t hex4(const char_t* p)
+	{
+		return static_cast<uint32_t>((JSON::hexDigitValue(p[0]) << 12) | (JSON::hexDigitValue(p[1]) << 8) |
+			(JSON::hexDigitValue(p[2]) << 4) | JSON::hexDigitValue(p[3]));
+	}
+
+	bool isHighSurrogate(uint32_t c) { return c >= 0xD800 && c <= 0xDBFF; }
+	bool isLowSurrogate(uint32_t c) { return c >= 0xDC00 && c <= 0xDFFF; }
+
+	// transcodes the character starting at s[i], invalid or truncated sequences become U+FFFD one byte at a time
+	inline void transcodeChar(str_view s, char32_t* out, size_t& i, size_t& o)
+	{
+		const char_t* p = s.data() + i;
+		if (!(static_cast<uint8_t>(p[0]) & 0x80))
+		{
+			out[o++] = static_cast<uint8_t>(p[0]);
+			i++;
+			return;
+		}
+		const auto numBytes = numBytesChar(p[0]);
+		if (numBytes < 2 || i + numBytes > s.size() || !JSON::isValidUTF8Sequence(p, numBytes))
+		{
+			out[o++] = 0xFFFD;
+			i++;
+			return;
+		}
+		uint32_t c = ctu8(p[0]) & (0x7F >> numBytes);
+		for (uint32_t b = 1; b < numBytes; b++) { c = (c << 6) | (ctu8(p[b]) & 0x3F); }
+		out[o++] = c;
+		i += numBytes;
+	}
+
+	// ASCII runs are copied a word at a time
+	void transcodeScalar(str_view s, char32_t* out, size_t& i, size_t& o)
+	{
+		const char_t* p = s.data();
+		while (i + 8 <= s.size())
+		{
+			uint64_t word;
+			std::memcpy(&word, p + i, 8);
+			if (word & HIGH_BITS)
+			{
+				transcodeChar(s, out, i, o);
+				continue;
+			}
+			for (size_t k = 0; k < 8; k++) { out[o + k] = static_cast<uint8_t>(p[i + k]); }
+			i += 8;
+			o += 8;
+		}
+	}
+
+#if JSON_RPG_X86
+	/* whole blocks are widened to 32 bits and stored, then only the ASCII prefix is kept
+	the stores never overrun, the output has room for one codepoint per input byte and never gets ahead of the input */
+	JSON_RPG_TARGET("sse4.2")
+	void transcodeSSE42(str_view s, char32_t* out, size_t& i, size_t& o)
+	{
+		const auto* p = reinterpret_cast<const uint8_t*>(s.data());
+		while (i + 16 <= s.size())
+		{
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+			auto* dst = reinterpret_cast<__m128i*>(out + o);
+			_mm_storeu_si128(dst + 0, _mm_cvtepu8_epi32(bytes));
+			_mm_storeu_si128(dst + 1, _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 4)));
+			_mm_storeu_si128(dst + 2, _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+			_mm_storeu_si128(dst + 3, _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 12)));
+			const auto nonAscii = static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+			if (!nonAscii)
+			{
+				i += 16;
+				o += 16;
+				continue;
+			}
+			const auto ascii = static_cast<size_t>(std::countr_zero(nonAscii));
+			i += ascii;
+			o += ascii;
+			transcodeChar(s, out, i, o);
+		}
+	}
+
+	JSON_RPG_TARGET("avx2")
+	void transcodeAVX2(str_view s, char32_t* out, size_t& i, size_t& o)
+	{
+		const auto* p = reinterpret_cast<const uint8_t*>(s.data());
+		while (i + 32 <= s.size())
+		{
+			const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+			const __m128i lo = _mm256_castsi256_si128(bytes);
+			const __m128i hi = _mm256_extracti128_si256(bytes, 1);
+			auto* dst = reinterpret_cast<__m256i*>(out + o);
+			_mm256_storeu_si256(dst + 0, _mm256_cvtepu8_epi32(lo));
+			_mm256_storeu_si256(dst + 1, _mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)));
+			_mm256_storeu_si256(dst + 2, _mm256_cvtepu8_epi32(hi));
+			_mm256_storeu_si256(dst + 3, _mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)));
+			const auto nonAscii = static_cast<uint32_t>(_mm256_movemask_epi8(bytes));
+			if (!nonAscii)
+			{
+				i += 32;
+				o += 32;
+				continue;
+			}
+			const auto ascii = static_cast<size_t>(std::countr_zero(nonAscii));
+			i += ascii;
+			o += ascii;
+			transcodeChar(s, out, i, o);
+		}
+	}
+#endif
+}
+
+namespace JSON
+{
+	Result validateUTF8(str_view text)
+	{
+		// the vectorized checks only tell whether the text is valid, the scalar pass finds out what is wrong
+		switch (getSimdLevel())
+		{
+		#if JSON_RPG_X86
+			case SimdLevel::AVX2: return isValidUTF8AVX2(text) ? Result::OK : validateUTF8Scalar(text);
+			case SimdLevel::SSE42: return isValidUTF8SSE42(text) ? Result::OK : validateUTF8Scalar(text);
+		#endif
+			default: return validateUTF8Scalar(text);
+		}
+	}
+
+	Result validateEscapes(str_view s)
+	{
+		size_t i = s.find('\\');
+		while (i != str_view::npos)
+		{
+			RETURN_ERROR_IF(i + 1 >= s.size(), Error_Lexer_InvalidEscape);
+			if (s[i + 1] == 'u')
+			{
+				RETURN_ERROR_IF(i + 6 > s.size(), Error_Lexer_InvalidEscape);
+				for (size_t k = i + 2; k < i + 6; k++) { RETURN_ERROR_IF(hexDigitValue(s[k]) < 0, Error_Lexer_InvalidEscape); }
+				i = s.find('\\', i + 6);
+			}
+			else
+			{
+				RETURN_ERROR_IF(!isSimpleEscape(s[i + 1]), Error_Lexer_InvalidEscape);
+				i = s.find('\\', i + 2);
+			}
+		}
+		return Result::OK;
+	}
+
+	size_t encodeUTF8(uint32_t c, char_t* out)
+	{
+		if (c < 0x80)
+		{
+			out[0] = static_cast<char_t>(c);
+			return 1;
+		}
+		if (c < 0x800)
+		{
+			out[0] = static_cast<char_t>(0xC0 | (c >> 6));
+			out[1] = static_cast<char_t>(0x80 | (c & 0x3F));
+			return 2;
+		}
+		if (c < 0x10000)
+		{
+			out[0] = static_cast<char_t>(0xE0 | (c >> 12));
+			out[1] = static_cast<char_t>(0x80 | ((c >> 6) & 0x3F));
+			out[2] = static_cast<char_t>(0x80 | (c & 0x3F));
+			return 3;
+		}
+		out[0] = static_cast<char_t>(0xF0 | (c >> 18));
+		out[1] = static_cast<char_t>(0x80 | ((c >> 12) & 0x3F));
+		out[2] = static_cast<char_t>(0x80 | ((c >> 6) & 0x3F));
+		out[3] = static_cast<char_t>(0x80 | (c & 0x3F));
+		return 4;
+	}
+
+	size_t unescapeString(str_view s, char_t* out)
+	{
+		const char_t* p = s.data();
+		const char_t* const end = p + s.size();
+		char_t* o = out;
+		while (p != end)
+		{
+			// everything up to the next backslash is copied as one block
+			const auto* found = static_cast<const char_t*>(std::memchr(p, '\\', static_cast<size_t>(end - p)));
+			const char_t* runEnd = found ? found : end;
+			std::memcpy(o, p, static_cast<size_t>(runEnd - p));
+			o += runEnd - p;
+			p = runEnd;
+			if (p == end) { break; }
+
+			const char_t e = p[1];
+			p += 2;
+			switch (e)
+			{
+				case 'b': *o++ = '\b'; break;
+				case 'f': *o++ = '\f'; break;
+				case 'n': *o++ = '\n'; break;
+				case 'r': *o++ = '\r'; break;
+				case 't': *o++ = '\t'; break;
+				case 'u':
+				{
+					uint32_t c = hex4(p);
+					p += 4;
+					// characters outside the BMP are written as a surrogate pair
+					if (isHighSurrogate(c) && end - p >= 6 && p[0] == '\\' && p[1] == 'u')
+					{
+						const uint32_t low = hex4(p + 2);
+						if (isLowSurrogate(low))
+						{
+							c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+							p += 6;
+						}
+					}
+					if (isHighSurrogate(c) || isLowSurrogate(c)) { c = 0xFFFD; } // unpaired, not encodable in UTF-8
+					o += encodeUTF8(c, o);
+					break;
+				}
+				default: *o++ = e; break; // " \ /
+			}
+		}
+		return static_cast<size_t>(o - out);
+	}
+
+	Result unescapeString(str_view s, str_t& out)
+	{
+		const Result result = validateEscapes(s);
+		if (result != Result::OK) { return result; }
+		out.resize(s.size());
+		out.resize(unescapeString(s, out.data()));
+		return Result::OK;
+	}
+
+}
+
+namespace JSONTextUtils
+{
+	std::u32string utf8to32str(str_view s, bool littleEndian)
+	{
+		std::u32string s32;
+		utf8to32str(s, s32, littleEndian);
+		return s32;
+	}
+
+	void utf8to32str(str_view s, std::u32string& out, bool littleEndian)
+	{
+		// sized for the worst case (all ASCII) and trimmed once the length is known
+		out.resize(s.size());
+		size_t i = 0, o = 0;
+		switch (JSON::getSimdLevel())
+		{
+		#if JSON_RPG_X86
+			case JSON::SimdLevel::AVX2: transcodeAVX2(s, out.data(), i, o); break;
+			case JSON::SimdLevel::SSE42: transcodeSSE42(s, out.data(), i, o); break;
+		#endif
+			default: transcodeScalar(s, out.data(), i, o); break;
+		}
+		while (i < s.size()) { transcodeChar(s, out.data(), i, o); }
+		out.resize(o);
+
+		if (littleEndian)
+		{
+			for (char32_t& c : out) { c = swapEndian32(c); }
+		}
+	}
+
+}
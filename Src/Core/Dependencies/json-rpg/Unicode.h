@@ -0,0 +1,66 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include "Parser.h"
+
+#include <cstdint>
+
+namespace JSON
+{
+	/* validates that text is well-formed UTF-8, overlong forms, surrogates and codepoints above U+10FFFF are rejected
+	checks 64 bytes per step with SSE4.2 or AVX2 (see setSimdLevel), pure ASCII runs are skipped 8 bytes at a time otherwise */
+	Result validateUTF8(str_view text);
+
+	// checks the escape sequences in string contents (the text between the quotes)
+	Result validateEscapes(str_view s);
+	/* decodes the escape sequences of string contents that passed validateEscapes, unpaired surrogates become U+FFFD
+	out must have room for s.size() bytes (decoding never makes a string longer), returns the decoded length */
+	size_t unescapeString(str_view s, JSONTextUtils::char_t* out);
+	// validates and decodes string contents, out is replaced
+	Result unescapeString(str_view s, str_t& out);
+
+	// writes the UTF-8 encoding of a codepoint (at most 4 bytes), returns the number of bytes written
+	size_t encodeUTF8(uint32_t codepoint, JSONTextUtils::char_t* out);
+
+	// true if string contents contain escape sequences, strings without them can be used as-is
+	inline bool hasEscapes(str_view s) { return s.find('\\') != str_view::npos; }
+
+	// value of a hex digit, -1 for other characters
+	inline int hexDigitValue(JSONTextUtils::char_t c)
+	{
+		if (c >= '0' && c <= '9') { return c - '0'; }
+		if (c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+		if (c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+		return -1;
+	}
+
+	// the character after a backslash, other than u, that forms a valid escape
+	inline bool isSimpleEscape(JSONTextUtils::char_t c)
+	{
+		return c == '"' || c == '\\' || c == '/' || c == 'b' || c == 'f' || c == 'n' || c == 'r' || c == 't';
+	}
+
+	/* true if the numBytes bytes at p (numBytes from numBytesChar of the lead byte) are a valid sequence,
+	following table 3-7 of the Unicode standard, the second byte range depends on the lead byte */
+	inline bool isValidUTF8Sequence(const JSONTextUtils::char_t* p, uint32_t numBytes)
+	{
+		const auto b0 = static_cast<uint8_t>(p[0]);
+		const auto b1 = static_cast<uint8_t>(p[1]);
+		uint8_t lo = 0x80, hi = 0xBF;
+		switch (b0)
+		{
+			case 0xE0: lo = 0xA0; break; // overlong
+			case 0xED: hi = 0x9F; break; // surrogates
+			case 0xF0: lo = 0x90; break; // overlong
+			case 0xF4: hi = 0x8F; break; // above U+10FFFF
+			default:
+				if (b0 < 0xC2 || b0 > 0xF4) { return false; } // overlong 2-byte forms and leads above U+10FFFF
+		}
+		if (b1 < lo || b1 > hi) { return false; }
+		for (uint32_t i = 2; i < numBytes; i++)
+		{
+			if ((static_cast<uint8_t>(p[i]) & 0xC0) != 0x80) { return false; }
+		}
+		return true;
+	}
+
+}
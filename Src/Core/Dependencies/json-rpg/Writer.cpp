@@ -0,0 +1,324 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#include "Writer.h"
+#include "Document.h"
+#include "Binary.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define JSON_RPG_SSE2 1
+	#include <emmintrin.h>
+#else
+	#define JSON_RPG_SSE2 0
+#endif
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+namespace
+{
+	using namespace JSONTextUtils;
+
+	// bytes that have to be escaped inside strings
+	constexpr auto needsEscape = []
+	{
+		std::array<bool, 256> table{};
+		for (int c = 0; c < 0x20; c++) { table[c] = true; }
+		table['"'] = true;
+		table['\\'] = true;
+		return table;
+	}();
+
+	// length of the run of bytes at the start of s that can be copied unchanged
+	size_t plainPrefix(const char_t* s, size_t size)
+	{
+		size_t i = 0;
+	#if JSON_RPG_SSE2
+		const __m128i quote = _mm_set1_epi8('"');
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i controlMax = _mm_set1_epi8(0x1F);
+		for (; i + 16 <= size; i += 16)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+			// unsigned v <= 0x1F is max(v, 0x1F) == 0x1F
+			const __m128i special = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+				_mm_cmpeq_epi8(_mm_max_epu8(v, controlMax), controlMax));
+			const int mask = _mm_movemask_epi8(special);
+			if (mask) { return i + std::countr_zero(static_cast<unsigned>(mask)); }
+		}
+	#endif
+		while (i < size && !needsEscape[static_cast<uint8_t>(s[i])]) { i++; }
+		return i;
+	}
+}
+
+namespace JSON
+{
+	void FileSink::write(const char_t* data, size_t size)
+	{
+		while (size && !failed)
+		{
+		#ifdef _WIN32
+			const int chunk = static_cast<int>(std::min<size_t>(size, 1u << 30));
+			const int written = _write(fd, data, static_cast<unsigned int>(chunk));
+		#else
+			const ssize_t written = ::write(fd, data, size);
+		#endif
+			if (written <= 0) { failed = true; break; }
+			data += written;
+			size -= static_cast<size_t>(written);
+		}
+	}
+
+	Writer::Writer(Sink& sink, WriteMode mode, size_t bufferSize) : sink{ &sink }, mode{ mode }, flushSize{ std::max<size_t>(bufferSize, 64) }
+	{
+		buffer.resize(flushSize);
+	}
+
+	char_t* Writer::grow(size_t n)
+	{
+		flush();
+		// without a sink, or for pieces larger than the whole buffer, the buffer grows instead
+		if (used + n > buffer.size()) { buffer.resize(std::max(buffer.size() * 2, used + n)); }
+		return buffer.data() + used;
+	}
+
+	void Writer::putLarge(str_view s)
+	{
+		if (sink && s.size() > flushSize)
+		{
+			// large pieces bypass the buffer
+			flush();
+			sink->write(s.data(), s.size());
+			return;
+		}
+		std::memcpy(reserve(s.size()), s.data(), s.size());
+		used += s.size();
+	}
+
+	void Writer::flush()
+	{
+		if (!sink || !used) { return; }
+		sink->write(buffer.data(), used);
+		used = 0;
+	}
+
+	str_t Writer::release()
+	{
+		flush();
+		buffer.resize(used);
+		str_t out = std::move(buffer);
+		clear();
+		if (sink) { buffer.resize(flushSize); }
+		return out;
+	}
+
+	void Writer::clear()
+	{
+		used = 0;
+		hasMembers.clear();
+		afterKey = false;
+	}
+
+	void Writer::newline()
+	{
+		const size_t depth = hasMembers.size();
+		char_t* out = reserve(depth + 1);
+		out[0] = '\n';
+		std::memset(out + 1, '\t', depth);
+		used += depth + 1;
+	}
+
+	// separates the value from the previous member and indents it
+	void Writer::beforeValue()
+	{
+		if (afterKey)
+		{
+			afterKey = false;
+			return;
+		}
+		if (hasMembers.empty()) { return; }
+		if (hasMembers.back()) { put(','); }
+		hasMembers.back() = true;
+		if (mode == WriteMode::Pretty) { newline(); }
+	}
+
+	void Writer::beginObject()
+	{
+		beforeValue();
+		put('{');
+		hasMembers.push_back(false);
+	}
+
+	void Writer::endObject()
+	{
+		const bool empty = !hasMembers.back();
+		hasMembers.pop_back();
+		if (!empty && mode == WriteMode::Pretty) { newline(); }
+		put('}');
+	}
+
+	void Writer::beginArray()
+	{
+		beforeValue();
+		put('[');
+		hasMembers.push_back(false);
+	}
+
+	void Writer::endArray()
+	{
+		const bool empty = !hasMembers.back();
+		hasMembers.pop_back();
+		if (!empty && mode == WriteMode::Pretty) { newline(); }
+		put(']');
+	}
+
+	void Writer::key(str_view name)
+	{
+		beforeValue();
+		put('"');
+		escape(name);
+		put((mode == WriteMode::Pretty) ? str_view("\": ") : str_view("\":"));
+		afterKey = true;
+	}
+
+	void Writer::string(str_view s)
+	{
+		beforeValue();
+		put('"');
+		escape(s);
+		put('"');
+	}
+
+	void Writer::rawString(str_view s)
+	{
+		beforeValue();
+		put('"');
+		put(s);
+		put('"');
+	}
+
+	void Writer::number(int64_t n)
+	{
+		beforeValue();
+		char_t* out = reserve(20);
+		used += std::to_chars(out, out + 20, n).ptr - out;
+	}
+
+	void Writer::number(double n)
+	{
+		if (!std::isfinite(n))
+		{
+			null();
+			return;
+		}
+		beforeValue();
+		char_t* out = reserve(32);
+		used += std::to_chars(out, out + 32, n).ptr - out; // shortest text that round-trips
+	}
+
+	void Writer::numberText(str_view text)
+	{
+		beforeValue();
+		put(text);
+	}
+
+	void Writer::boolean(bool b)
+	{
+		beforeValue();
+		put(b ? str_view("true") : str_view("false"));
+	}
+
+	void Writer::null()
+	{
+		beforeValue();
+		put(str_view("null"));
+	}
+
+	// copies plain runs in bulk and escapes the bytes in between
+	void Writer::escape(str_view s)
+	{
+		static constexpr char_t hex[] = "0123456789abcdef";
+		const char_t* p = s.data();
+		size_t size = s.size();
+		while (size)
+		{
+			const size_t plain = plainPrefix(p, size);
+			put(str_view(p, plain));
+			p += plain;
+			size -= plain;
+			if (!size) { break; }
+
+			const auto c = static_cast<uint8_t>(*p++);
+			size--;
+			char_t* out = reserve(6);
+			out[0] = '\\';
+			switch (c)
+			{
+				case '"': out[1] = '"'; used += 2; break;
+				case '\\': out[1] = '\\'; used += 2; break;
+				case '\b': out[1] = 'b'; used += 2; break;
+				case '\f': out[1] = 'f'; used += 2; break;
+				case '\n': out[1] = 'n'; used += 2; break;
+				case '\r': out[1] = 'r'; used += 2; break;
+				case '\t': out[1] = 't'; used += 2; break;
+				default:
+					out[1] = 'u'; out[2] = '0'; out[3] = '0';
+					out[4] = hex[c >> 4]; out[5] = hex[c & 0xF];
+					used += 6;
+			}
+		}
+	}
+
+	template<typename T>
+	void Writer::writeTree(const T& tree)
+	{
+		switch (tree.type)
+		{
+			case ObjectType::Object:
+				beginObject();
+				for (const T& member : tree)
+				{
+					key(member.name);
+					writeTree(member);
+				}
+				endObject();
+				break;
+			case ObjectType::Array:
+				beginArray();
+				for (const T& member : tree) { writeTree(member); }
+				endArray();
+				break;
+			case ObjectType::String: string(tree.getValue()); break; // stored decoded
+			case ObjectType::Number:
+			case ObjectType::Boolean:
+			case ObjectType::Null: numberText(tree.getValue()); break; // kept as the literal text
+			default: null(); break;
+		}
+	}
+
+	void Writer::value(const Object& object)
+	{
+		writeTree(object);
+	}
+
+	void Writer::value(const Node& node)
+	{
+		writeTree(node);
+	}
+
+	void Writer::value(const BinaryValue& binaryValue)
+	{
+		writeTree(binaryValue);
+	}
+
+}
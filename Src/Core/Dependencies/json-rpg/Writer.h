@@ -0,0 +1,121 @@
+// Copyright 2024 Simon Liimatainen, Europa Software. All rights reserved.
+#pragma once
+#include "Parser.h"
+
+#include <cstring>
+#include <ostream>
+
+namespace JSON
+{
+	class Node;
+	class BinaryValue;
+
+	// destination for serialized text, receives the writer's buffer in large pieces
+	class Sink
+	{
+	public:
+		virtual ~Sink() = default;
+		virtual void write(const JSONTextUtils::char_t* data, size_t size) = 0;
+	};
+
+	class StreamSink : public Sink
+	{
+	public:
+		explicit StreamSink(std::ostream& stream) : stream{ stream } {};
+		void write(const JSONTextUtils::char_t* data, size_t size) override { stream.write(data, static_cast<std::streamsize>(size)); }
+
+	private:
+		std::ostream& stream;
+	};
+
+	// writes to an open file descriptor (e.g. from open() or _open()), the descriptor is not closed
+	class FileSink : public Sink
+	{
+	public:
+		explicit FileSink(int fd) : fd{ fd } {};
+		void write(const JSONTextUtils::char_t* data, size_t size) override;
+		// false if any write failed
+		bool good() const { return !failed; }
+
+	private:
+		int fd;
+		bool failed = false;
+	};
+
+	enum class WriteMode { Compact, Pretty };
+
+	/* streaming JSON writer, output is appended to an internal buffer that is flushed to the sink when full
+	without a sink the buffer simply grows, and can be read with view() or moved out with release()
+	commas, colons and (in pretty mode) newlines and tab indentation are inserted automatically */
+	class Writer
+	{
+	public:
+		static constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+		explicit Writer(WriteMode mode = WriteMode::Compact) : mode{ mode } {};
+		explicit Writer(Sink& sink, WriteMode mode = WriteMode::Compact, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+		~Writer() { flush(); }
+
+		Writer(const Writer&) = delete;
+		Writer& operator=(const Writer&) = delete;
+
+		void beginObject();
+		void endObject();
+		void beginArray();
+		void endArray();
+
+		// member name inside an object, escaped
+		void key(str_view name);
+		// escapes quotes, backslashes and control characters
+		void string(str_view s);
+		// string contents that are already escaped, e.g. string tokens passed on from a StreamParser
+		void rawString(str_view s);
+		void number(int64_t n);
+		// non-finite values are written as null, since JSON has no representation for them
+		void number(double n);
+		// number text that is already valid JSON
+		void numberText(str_view text);
+		void boolean(bool b);
+		void null();
+
+		// writes a whole tree, member names and string values are escaped (trees store them decoded)
+		void value(const Object& object);
+		void value(const Node& node);
+		void value(const BinaryValue& binaryValue);
+
+		// passes buffered output to the sink, does nothing without a sink
+		void flush();
+		// output so far, only meaningful without a sink
+		str_view view() const { return str_view(buffer.data(), used); }
+		// moves the output out and resets the writer for reuse
+		str_t release();
+		// discards the output and resets the writer, the buffer is kept
+		void clear();
+
+	private:
+		void beforeValue();
+		void newline();
+		// fast paths stay inline, growing and flushing do not
+		char_t* reserve(size_t n) { return (used + n <= buffer.size()) ? buffer.data() + used : grow(n); }
+		char_t* grow(size_t n);
+		void put(char_t c) { *reserve(1) = c; used++; }
+		void put(str_view s)
+		{
+			if (used + s.size() > buffer.size()) { putLarge(s); return; }
+			std::memcpy(buffer.data() + used, s.data(), s.size());
+			used += s.size();
+		}
+		void putLarge(str_view s);
+		void escape(str_view s);
+		template<typename T> void writeTree(const T& tree);
+
+		Sink* sink = nullptr;
+		WriteMode mode;
+		size_t flushSize = DEFAULT_BUFFER_SIZE;
+		str_t buffer; // sized to capacity, only the first used bytes are output
+		size_t used = 0;
+		std::vector<uint8_t> hasMembers; // one entry per open container
+		bool afterKey = false;
+	};
+
+}
@@ -0,0 +1,44 @@
+#version 450
+#extension GL_EXT_scalar_block_layout: require
+// vertex inputs, CompactVertex (see Core/Mesh/VertexFormat.h)
+layout(location = 0) in vec4 position; // relative to the mesh extent, push.transform scales it back
+layout(location = 2) in vec2 normalOctahedral;
+layout(location = 3) in vec2 uv;
+// outputs to fragment shader
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPositionWS;
+layout(location = 2) out vec3 fragNormalWS;
+layout(location = 3) out vec2 fragUV;
+
+layout(std430, set = 0, binding = 0) uniform UBO1 
+{
+	mat4 projectionViewMatrix;
+} ubo1;
+
+layout(set = 0, binding = 1) uniform texture2D textures[2];
+layout(set = 0, binding = 2) uniform sampler _sampler;
+
+layout(push_constant) uniform Push
+{
+	mat4 transform;
+	mat4 normalMatrix;
+} push;
+
+// inverse of octahedralEncode, unfolds the lower hemisphere
+vec3 octahedralDecode(vec2 e)
+{
+  vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
+void main()
+{
+  gl_Position = ubo1.projectionViewMatrix * push.transform * position;
+  fragNormalWS = normalize(mat3(push.normalMatrix) * octahedralDecode(normalOctahedral));
+  fragPositionWS = vec4(push.transform * position).xyz;
+  fragUV = uv;
+  fragColor = vec3(0.0); // compact vertices have no color, meshes loaded from files have none either
+}
@@ -1,5 +1,6 @@
 #include "Core/Draw/FxDrawer.h"
 #include "Core/Primitive.h"
+#include "Core/Mesh/MeshCache.h"
 #include "Core/Types/CommonTypes.h"
 #include "Core/GPU/Descriptors.h"
 #include "Core/GPU/Material.h"
@@ -38,9 +39,9 @@ namespace EngineCore
 		fullscreenMaterial = std::make_unique<Material>(fullscreenInfo, device);
 
 		// setup mesh and material
-		Primitive::MeshBuilder builder{};
-		builder.loadFromFile(makePath("Meshes/teapot.obj"));
-		mesh = std::make_unique<Primitive>(device, builder);
+		MeshCache meshCache{};
+		meshCache.load(makePath("Meshes/teapot.obj"));
+		mesh = std::make_unique<Primitive>(device, meshCache.getView());
 		ShaderFilePaths shader(makePath("Shaders/fx_test.vert.spv"), makePath("Shaders/fx_test.frag.spv"));
 		mesh->setMaterial(MaterialCreateInfo(shader, layouts, VK_SAMPLE_COUNT_1_BIT, renderpass, sizeof(ShaderPushConstants::MeshPushConstants)));
 		mesh->getTransform().scale = 5.f;
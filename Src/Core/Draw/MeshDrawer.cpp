@@ -5,6 +5,7 @@
 #include "Core/WorldSystem/World.h"
 
 #include <stdexcept>
+#include <algorithm>
 #include <array>
 #include <limits>
 #include <iostream> // temporary
@@ -99,29 +100,115 @@ namespace EngineCore
 				0, sizeof(SimplePushConstantData), &push);*/
 
 				//FakeScaleTest082
+				bool cullMeshlets = false;
+				glm::mat4 modelMatrix{ 1.f };
 				if (mesh->useFakeScale) 
 				{
 					ShaderPushConstants::MeshPushConstants push{};
-					push.transform = fakeScaleOffsets.mat4();
+					push.transform = glm::scale(fakeScaleOffsets.mat4(), mesh->getPositionScale()); // compact positions are stored divided by the extent
 					material->writePushConstants(commandBuffer, push);
+					mesh->selectLod(0);
 				} 
 				else 
 				{
 					// NON-TEST CODE!
 					ShaderPushConstants::MeshPushConstants push{};
-					push.transform = mesh->getTransform().mat4();
+					modelMatrix = mesh->getTransform().mat4();
+					push.transform = modelMatrix;
 					push.normalMatrix = glm::transpose(glm::inverse(push.transform));
+					mesh->selectLod(selectLod(*mesh, push.transform, viewMatrix));
+					cullMeshlets = mesh->getMeshlets().size() > 1;
+					push.transform = glm::scale(push.transform, mesh->getPositionScale()); // after the normal matrix, normals are not scaled
 					material->writePushConstants(commandBuffer, push);
 				}
 
 				// record mesh draw command
 				mesh->bind(commandBuffer);
-				mesh->draw(commandBuffer);
+				if (cullMeshlets)
+				{
+					const bool cullBackFaces = (material->getShadingProperties().cullModeFlags & VK_CULL_MODE_BACK_BIT) != 0;
+					drawVisibleMeshlets(commandBuffer, *mesh, modelMatrix, viewMatrix, cullBackFaces);
+				}
+				else { mesh->draw(commandBuffer); }
 			}
 		}
 
 	}
 
+	uint32_t MeshDrawer::selectLod(const Primitive& mesh, const glm::mat4& modelMatrix, const glm::mat4& projectionView)
+	{
+		const uint32_t lodCount = mesh.getLodCount();
+		if (lodCount <= 1) { return 0; }
+
+		// bounding sphere around the mesh origin, in world space
+		const glm::vec3 center{ modelMatrix[3] };
+		const float scale = std::max({ glm::length(glm::vec3{ modelMatrix[0] }), glm::length(glm::vec3{ modelMatrix[1] }), glm::length(glm::vec3{ modelMatrix[2] }) });
+		const float radius = mesh.getBoundingRadius() * scale;
+
+		// the view is rigid, so clip w is the view depth and the length of the clip y row is the projection's vertical scale
+		const glm::vec4 clip = projectionView * glm::vec4{ center, 1.f };
+		if (clip.w <= radius) { return 0; } // the camera is inside or right next to the bounds
+		const float verticalScale = glm::length(glm::vec3{ projectionView[0][1], projectionView[1][1], projectionView[2][1] });
+		const float projectedRadius = radius * verticalScale / (2.f * clip.w); // fraction of the screen height
+
+		const auto screenError = [&](uint32_t lod) { return mesh.getLod(lod).error * projectedRadius; };
+		uint32_t lod = std::min(mesh.getSelectedLod(), lodCount - 1);
+		while (lod > 0 && screenError(lod) > LOD_MAX_SCREEN_ERROR * (1.f + LOD_HYSTERESIS)) { lod--; }
+		while (lod + 1 < lodCount && screenError(lod + 1) < LOD_MAX_SCREEN_ERROR * (1.f - LOD_HYSTERESIS)) { lod++; }
+		return lod;
+	}
+
+	void MeshDrawer::drawVisibleMeshlets(VkCommandBuffer commandBuffer, Primitive& mesh, const glm::mat4& modelMatrix, const glm::mat4& projectionView,
+		bool cullBackFaces)
+	{
+		// the frustum and the camera are brought into mesh space, where the meshlet bounds are
+		const glm::mat4 meshToClip = projectionView * modelMatrix;
+		const auto row = [&](int r) { return glm::vec4{ meshToClip[0][r], meshToClip[1][r], meshToClip[2][r], meshToClip[3][r] }; };
+
+		// the clip volume is -w <= x <= w, -w <= y <= w, 0 <= z <= w
+		const std::array<glm::vec4, 6> planes{ row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(2), row(3) - row(2) };
+		std::array<float, 6> planeScales{};
+		for (size_t p = 0; p < planes.size(); p++) { planeScales[p] = glm::length(glm::vec3{ planes[p] }); }
+
+		// the camera is the point where clip x, y and w are all zero (none for orthographic projections)
+		// a mirroring model matrix turns back faces into front faces, those meshes are not cone culled
+		const glm::vec3 nx{ row(0) }, ny{ row(1) }, nw{ row(3) };
+		const float det = glm::dot(nx, glm::cross(ny, nw));
+		cullBackFaces = cullBackFaces && glm::determinant(glm::mat3{ modelMatrix }) > 0.f
+			&& std::abs(det) > 1e-6f * glm::length(nx) * glm::length(ny) * glm::length(nw);
+		const glm::vec3 camera = cullBackFaces ? -(row(0).w * glm::cross(ny, nw) + row(1).w * glm::cross(nw, nx) + row(3).w * glm::cross(nx, ny)) / det
+			: glm::vec3{ 0.f };
+
+		uint32_t runFirst = 0;
+		uint32_t runCount = 0;
+		for (const Primitive::Meshlet& meshlet : mesh.getMeshlets())
+		{
+			bool visible = true;
+			for (size_t p = 0; p < planes.size() && visible; p++)
+			{
+				visible = glm::dot(glm::vec3{ planes[p] }, meshlet.center) + planes[p].w >= -meshlet.radius * planeScales[p];
+			}
+			if (visible && cullBackFaces)
+			{
+				// every triangle faces away if the camera is outside the cone of their normals, widened by the bounding sphere
+				const glm::vec3 toMeshlet = meshlet.center - camera;
+				visible = glm::dot(toMeshlet, meshlet.coneAxis) < meshlet.coneCutoff * glm::length(toMeshlet) + meshlet.radius;
+			}
+			if (!visible) { continue; }
+
+			// meshlets are consecutive in the index buffer, neighbours that are both visible merge into one draw
+			if (runCount > 0 && runFirst + runCount == meshlet.firstIndex)
+			{
+				runCount += meshlet.indexCount;
+				continue;
+			}
+			if (runCount > 0) { mesh.drawIndexRange(commandBuffer, runFirst, runCount); }
+			runFirst = meshlet.firstIndex;
+			runCount = meshlet.indexCount;
+		}
+		if (runCount > 0) { mesh.drawIndexRange(commandBuffer, runFirst, runCount); }
+	}
+
 	glm::mat4 MeshDrawer::lerpMat4(float t, glm::mat4 matA, glm::mat4 matB) 
 	{
 		glm::mat4 matOut{};
@@ -34,6 +34,18 @@ namespace EngineCore
 	private:
 		EngineDevice& device;
 
+		static constexpr float LOD_MAX_SCREEN_ERROR = 0.001f; // fraction of the screen height, about a pixel at 1080p
+		static constexpr float LOD_HYSTERESIS = 0.25f; // margin around the error limit, so a mesh at the limit does not switch every frame
+
+		/* coarsest level of detail whose error, projected with the mesh bounds (see Primitive::getBoundingRadius), stays under the limit
+		starts from the mesh's current level, which it leaves only once the error is past the limit by the hysteresis margin */
+		static uint32_t selectLod(const Primitive& mesh, const glm::mat4& modelMatrix, const glm::mat4& projectionView);
+
+		/* draws the meshlets of the mesh's selected level that can be visible (see Primitive::Meshlet), runs of them with a single draw call
+		meshlets outside the view frustum are skipped, as are those facing away from the camera if the material culls back faces anyway */
+		static void drawVisibleMeshlets(VkCommandBuffer commandBuffer, Primitive& mesh, const glm::mat4& modelMatrix, const glm::mat4& projectionView,
+			bool cullBackFaces);
+
 		static glm::mat4 orthographicMatrix(const float& n, const float& f)
 		{
 			float r = 1.f;
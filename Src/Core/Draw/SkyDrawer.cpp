@@ -1,5 +1,6 @@
 #include "Core/Draw/SkyDrawer.h"
 #include "Core/Primitive.h"
+#include "Core/Mesh/MeshCache.h"
 #include "Core/GPU/Device.h"
 #include "Core/Types/CommonTypes.h"
 #include "Core/GPU/Material.h"
@@ -13,9 +14,9 @@ namespace EngineCore
 		ShaderFilePaths skyShaders(makePath("Shaders/sky.vert.spv"), makePath("Shaders/sky.frag.spv"));
 
 		// prepare sky mesh
-		Primitive::MeshBuilder builder{};
-		builder.loadFromFile(meshPath);
-		skyMesh = std::make_unique<Primitive>(device, builder);
+		MeshCache meshCache{};
+		meshCache.load(meshPath);
+		skyMesh = std::make_unique<Primitive>(device, meshCache.getView());
 		skyMesh->getTransform().scale = 50.f;
 
 		// create unique material for sky, set to render backfaces, since it will be viewed from inside
@@ -3,6 +3,7 @@
 #include "Core/GPU/Material.h"
 #include "Core/GPU/Buffer.h"
 #include "Core/GPU/Image.h"
+#include "Core/GPU/UploadManager.h"
 
 #include <stdexcept>
 #include <array>
@@ -275,6 +276,7 @@ namespace EngineCore
 
 			fxDrawer->render(commandBuffer, renderer);
 
+			device.getUploadManager().flush(); // uploads made while recording (e.g. by loaded sectors) are submitted ahead of the frame using them
 			renderer.endFrame(); // submit command buffer
 			camera.setAspectRatio(renderer.getSwapchainAspectRatio());
 		}
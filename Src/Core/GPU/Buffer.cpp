@@ -22,30 +22,30 @@ namespace EngineCore
 	{
 		alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
 		bufferSize = alignmentSize * instanceCount;
-		device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+		// sub-allocated from a larger block instead of a vkAllocateMemory per buffer
+		device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation);
 	}
 
 	GBuffer::~GBuffer() 
 	{
 		unmap();
 		vkDestroyBuffer(device.device(), buffer, nullptr);
-		vkFreeMemory(device.device(), memory, nullptr);
+		device.getMemoryAllocator().free(allocation);
 	}
 
 	VkResult GBuffer::map(VkDeviceSize size, VkDeviceSize offset) 
 	{
-		// this maps the memory range to the host, making it CPU-accessible
-		assert(buffer && memory && "cannot map uninitialized buffer");
-		return vkMapMemory(device.device(), memory, offset, size, 0, &mapped);
+		// host visible blocks are mapped by the allocator for their whole lifetime (a memory object can only be mapped once)
+		assert(buffer && allocation.isValid() && "cannot map uninitialized buffer");
+		assert(offset <= bufferSize && (size == VK_WHOLE_SIZE || size <= bufferSize - offset) && "mapped range is outside the buffer");
+		if (!allocation.mapped) { return VK_ERROR_MEMORY_MAP_FAILED; }
+		mapped = static_cast<char*>(allocation.mapped) + offset;
+		return VK_SUCCESS;
 	}
 
-	// vkUnmapMemory can't fail
 	void GBuffer::unmap() 
 	{
-		if (mapped) {
-			vkUnmapMemory(device.device(), memory);
-			mapped = nullptr;
-		}
+		mapped = nullptr;
 	}
 
 	void GBuffer::writeToBuffer(void* data, VkDeviceSize size, VkDeviceSize offset) 
@@ -64,22 +64,13 @@ namespace EngineCore
 
 	VkResult GBuffer::flush(VkDeviceSize size, VkDeviceSize offset) 
 	{
-		VkMappedMemoryRange mappedRange = {};
-		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-		mappedRange.memory = memory;
-		mappedRange.offset = offset;
-		mappedRange.size = size; // bytes to flush, starting at offset
-		return vkFlushMappedMemoryRanges(device.device(), 1, &mappedRange);
+		// the range is relative to the buffer, the allocator offsets it into the block
+		return device.getMemoryAllocator().flush(allocation, size, offset);
 	}
 
 	VkResult GBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) 
 	{
-		VkMappedMemoryRange mappedRange = {};
-		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-		mappedRange.memory = memory;
-		mappedRange.offset = offset;
-		mappedRange.size = size;
-		return vkInvalidateMappedMemoryRanges(device.device(), 1, &mappedRange);
+		return device.getMemoryAllocator().invalidate(allocation, size, offset);
 	}
 
 	VkDescriptorBufferInfo GBuffer::descriptorInfo(VkDeviceSize size, VkDeviceSize offset) 
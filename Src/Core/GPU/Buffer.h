@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Core/GPU/Device.h"
+#include "Core/GPU/Memory/VMemAllocator.h"
 
 namespace EngineCore 
 {
@@ -14,7 +15,7 @@ namespace EngineCore
 		GBuffer(const GBuffer&) = delete;
 		GBuffer& operator=(const GBuffer&) = delete;
 
-		// calls vkMapMemory for this buffer, whole range by default, starting at 0 (bytes)
+		// maps the range to the host, whole range by default, starting at 0 (bytes). the memory block stays mapped, this only sets the pointer
 		VkResult map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
 		void unmap();
 
@@ -41,6 +42,7 @@ namespace EngineCore
 		VkBufferUsageFlags getUsageFlags() const { return usageFlags; }
 		VkMemoryPropertyFlags getMemoryPropertyFlags() const { return memoryPropertyFlags; }
 		VkDeviceSize getBufferSize() const { return bufferSize; }
+		const Allocation& getAllocation() const { return allocation; }
 
 	private:
 		// minimum instance size required to be compatible with device minOffsetAlignment
@@ -49,7 +51,7 @@ namespace EngineCore
 		EngineDevice& device;
 		void* mapped = nullptr;
 		VkBuffer buffer = VK_NULL_HANDLE;
-		VkDeviceMemory memory = VK_NULL_HANDLE;
+		Allocation allocation; // part of a memory block shared with other resources
 
 		VkDeviceSize bufferSize;
 		uint32_t instanceCount;
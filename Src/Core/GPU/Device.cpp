@@ -1,4 +1,6 @@
 #include "Core/GPU/Device.h"
+#include "Core/GPU/UploadManager.h"
+#include "Core/GPU/Memory/VMemAllocator.h"
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -51,10 +53,14 @@ namespace EngineCore
 		pickPhysicalDevice();
 		createLogicalDevice();
 		createCommandPool();
+		memoryAllocator = std::make_unique<DeviceMemoryAllocator>(*this);
+		uploadManager = std::make_unique<UploadManager>(*this);
 	}
 
 	EngineDevice::~EngineDevice() 
 	{
+		uploadManager.reset(); // waits for pending uploads
+		memoryAllocator.reset(); // after every resource allocated from it
 		vkDestroyCommandPool(device_, commandPool, nullptr);
 		vkDestroyDevice(device_, nullptr);
 
@@ -150,6 +156,7 @@ namespace EngineCore
 
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+		if (indices.transferFamilyHasValue) { uniqueQueueFamilies.insert(indices.transferFamily); }
 
 		float queuePriority = 1.0f;
 		for (uint32_t queueFamily : uniqueQueueFamilies) 
@@ -198,6 +205,8 @@ namespace EngineCore
 
 		vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
 		vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+		if (indices.transferFamilyHasValue) { vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_); }
+		else { transferQueue_ = graphicsQueue_; }
 	}
 
 	void EngineDevice::createCommandPool() 
@@ -378,6 +387,21 @@ namespace EngineCore
 			i++;
 		}
 
+		// a family for transfers only (usually a DMA engine), copies of whole texels at any offset (no granularity constraints)
+		for (uint32_t f = 0; f < queueFamilyCount; f++)
+		{
+			const VkQueueFamilyProperties& queueFamily = queueFamilies[f];
+			const VkExtent3D& granularity = queueFamily.minImageTransferGranularity;
+			if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT)
+				&& !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))
+				&& granularity.width == 1 && granularity.height == 1 && granularity.depth == 1)
+			{
+				indices.transferFamily = f;
+				indices.transferFamilyHasValue = true;
+				break;
+			}
+		}
+
 		return indices;
 	}
 
@@ -449,7 +473,7 @@ namespace EngineCore
 	}
 
 	void EngineDevice::createBuffer(VkDeviceSize size,VkBufferUsageFlags usage,
-						VkMemoryPropertyFlags properties,VkBuffer& buffer,VkDeviceMemory& bufferMemory) 
+						VkMemoryPropertyFlags properties,VkBuffer& buffer,Allocation& bufferAllocation) 
 	{
 		VkBufferCreateInfo bufferInfo{};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -462,18 +486,8 @@ namespace EngineCore
 			throw std::runtime_error("failed to create VkBuffer");
 		}
 
-		VkMemoryRequirements memRequirements;
-		vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) 
-		{ throw std::runtime_error("failed to allocate VkBuffer memory"); }
-
-		vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+		// through the allocator, so every vkAllocateMemory counts against maxMemoryAllocationCount
+		bufferAllocation = memoryAllocator->allocForBuffer(buffer, properties);
 	}
 
 	VkCommandBuffer EngineDevice::beginSingleTimeCommands() 
@@ -546,24 +560,12 @@ namespace EngineCore
 	}
 
 	void EngineDevice::createImageWithInfo(const VkImageCreateInfo& imageInfo,VkMemoryPropertyFlags properties,
-											VkImage& image,VkDeviceMemory& imageMemory) 
+											VkImage& image,Allocation& imageAllocation) 
 	{
 		if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) 
 		{ throw std::runtime_error("failed to create image!"); }
 
-		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements(device_, image, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) 
-		{ throw std::runtime_error("failed to allocate image memory!"); }
-
-		if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) 
-		{ throw std::runtime_error("failed to bind image memory!"); }
+		imageAllocation = memoryAllocator->allocForImage(image, properties, imageInfo.tiling);
 	}
 
 	/*void EngineDevice::importImageFromFile(const char* path)
@@ -3,6 +3,7 @@
 #include "Core/Window.h"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -22,11 +23,17 @@ namespace EngineCore
 	{
 		uint32_t graphicsFamily;
 		uint32_t presentFamily;
+		uint32_t transferFamily; // transfer-only family, copies on it run alongside rendering
 		bool graphicsFamilyHasValue = false;
 		bool presentFamilyHasValue = false;
+		bool transferFamilyHasValue = false; // optional, uploads go through the graphics queue without it
 		bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
 	};
 
+	class UploadManager;
+	class DeviceMemoryAllocator;
+	struct Allocation;
+
 	class EngineDevice 
 	{
 	public:
@@ -48,6 +55,11 @@ namespace EngineCore
 		VkSurfaceKHR surface() { return surface_; }
 		VkQueue graphicsQueue() { return graphicsQueue_; }
 		VkQueue presentQueue() { return presentQueue_; }
+		VkQueue transferQueue() { return transferQueue_; } // the graphics queue if there is no transfer-only family
+		// batched staging uploads into buffers and images, see UploadManager
+		UploadManager& getUploadManager() { return *uploadManager; }
+		// places buffers and images in shared memory blocks, see DeviceMemoryAllocator
+		DeviceMemoryAllocator& getMemoryAllocator() { return *memoryAllocator; }
 		VkInstance getVulkanInstance() { return instance; } // for imgui
 
 		SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
@@ -61,23 +73,24 @@ namespace EngineCore
 		VkSampleCountFlagBits getMaxSampleCount();
 
 		// Buffer Helper Functions
+		// the memory comes from the memory allocator, give it back with getMemoryAllocator().free()
 		void createBuffer(
 			VkDeviceSize size,
 			VkBufferUsageFlags usage,
 			VkMemoryPropertyFlags properties,
 			VkBuffer& buffer,
-			VkDeviceMemory& bufferMemory);
+			Allocation& bufferAllocation);
 		VkCommandBuffer beginSingleTimeCommands();
 		void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 		void copyBufferToImage(
 			VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
-		// creates a vulkan image object
+		// creates a vulkan image object, its memory comes from the memory allocator like in createBuffer
 		void createImageWithInfo(
 			const VkImageCreateInfo& imageInfo,
 			VkMemoryPropertyFlags properties,
 			VkImage& image,
-			VkDeviceMemory& imageMemory);
+			Allocation& imageAllocation);
 		// imports and initializes an image texture from disk
 		//void importImageFromFile(const char* path);
 		// takes a VkImage and transitions its layout
@@ -115,6 +128,9 @@ namespace EngineCore
 		VkSurfaceKHR surface_;
 		VkQueue graphicsQueue_;
 		VkQueue presentQueue_;
+		VkQueue transferQueue_;
+		std::unique_ptr<DeviceMemoryAllocator> memoryAllocator;
+		std::unique_ptr<UploadManager> uploadManager;
 
 		const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
 		const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
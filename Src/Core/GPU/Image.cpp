@@ -1,6 +1,6 @@
 #include "Core/GPU/Image.h"
 #include "Core/GPU/Device.h"
-#include "Core/GPU/Buffer.h"
+#include "Core/GPU/UploadManager.h"
 #include <cassert>
 #include <stdexcept>
 
@@ -30,10 +30,10 @@ namespace EngineCore
 	Image::~Image() 
 	{
 		destroyView();
-		if (imageMemory != VK_NULL_HANDLE) 
+		if (allocation.isValid()) 
 		{ 
 			destroyImage();
-			vkFreeMemory(device.device(), imageMemory, nullptr); 
+			device.getMemoryAllocator().free(allocation); 
 		}
 		if (sampler != VK_NULL_HANDLE) 
 		{ 
@@ -63,26 +63,14 @@ namespace EngineCore
 		VkDeviceSize imageSize = width * height * (uint32_t)4;
 		if (!pixels) { throw std::runtime_error("failed to load image"); }
 
-		// temporary image buffer
-		GBuffer stagingBuffer
-		{
-			device, imageSize, 1, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
-
-		// map buffer to host and copy to it
-		stagingBuffer.map(imageSize);
-		memcpy(stagingBuffer.getMappedMemory(), pixels, static_cast<size_t>(imageSize)); 
-		stagingBuffer.unmap();
-
-		stbi_image_free(pixels); // free importer memory
-
 		/*	allocate and prep the image for write, device local memory is fast but does not allow host access */
 		VkImageCreateInfo info = makeImageCreateInfo(width, height); // using defaults
 		create(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, info);
 
-		// transfer data from buffer to image
-		copyBufferToImage(stagingBuffer, static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1);
+		// staged and copied with the other uploads of the frame, the layout ends up shader readable (see GPU/UploadManager.h)
+		const VkExtent3D extent{ static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
+		device.getUploadManager().uploadImage(image, pixels, imageSize, extent);
+		stbi_image_free(pixels); // free importer memory, the pixels were copied to staging memory
 	}
 
 	VkImageCreateInfo Image::makeImageCreateInfo(uint32_t width, uint32_t height)
@@ -110,88 +98,8 @@ namespace EngineCore
 		if (vkCreateImage(device.device(), &info, nullptr, &image) != VK_SUCCESS)
 		{ throw std::runtime_error("failed to create image"); }
 
-		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements(device.device(), image, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = device.findMemoryType(memRequirements.memoryTypeBits, memProps);
-
-		if (vkAllocateMemory(device.device(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-		{ throw std::runtime_error("failed to allocate memory for image"); }
-
-		if (vkBindImageMemory(device.device(), image, imageMemory, 0) != VK_SUCCESS)
-		{ throw std::runtime_error("failed to bind memory for image"); }
-	}
-
-	void Image::transitionImageLayout(VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout)
-	{
-		VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
-
-		VkImageMemoryBarrier barrier{};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.oldLayout = oldLayout;
-		barrier.newLayout = newLayout;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.image = image;
-		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		barrier.subresourceRange.baseMipLevel = 0;
-		barrier.subresourceRange.levelCount = 1;
-		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
-
-		VkPipelineStageFlags sourceStage;
-		VkPipelineStageFlags destinationStage;
-
-		if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) 
-		{
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) 
-		{
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-			sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		}
-		else { throw std::invalid_argument("unsupported image layout transition"); }
-		
-		vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0,
-							nullptr, 0, nullptr, 1, &barrier);
-
-		device.endSingleTimeCommands(commandBuffer);
-	}
-
-	void Image::copyBufferToImage(const GBuffer& buffer, uint32_t width, uint32_t height, uint32_t layerCount)
-	{
-		// vkCmdCopyBufferToImage requires the right image layout, that is handled here
-		transitionImageLayout(VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-		VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
-
-		VkBufferImageCopy region{};
-		region.bufferOffset = 0;
-		region.bufferRowLength = 0;
-		region.bufferImageHeight = 0;
-
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.mipLevel = 0;
-		region.imageSubresource.baseArrayLayer = 0;
-		region.imageSubresource.layerCount = layerCount; // default = 1
-		region.imageOffset = { 0, 0, 0 };
-		region.imageExtent = { width, height, 1 };
-
-		vkCmdCopyBufferToImage(commandBuffer, buffer.getBuffer(), image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-		device.endSingleTimeCommands(commandBuffer);
-		// transition (again) to a more useful format
-		transitionImageLayout(VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		// sub-allocated from a larger block, kept apart from buffers if the device needs it (bufferImageGranularity)
+		allocation = device.getMemoryAllocator().allocForImage(image, memProps, info.tiling);
 	}
 
 	void Image::createView(VkImageView& view, VkFormat format, VkImageAspectFlags aspect, VkImageViewType viewType)
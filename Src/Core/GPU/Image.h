@@ -2,12 +2,12 @@
 #pragma warning(push, 0) // warning-ignore hack only works in header
 #include <vulkan/vulkan.h>
 #pragma warning(pop)
+#include "Core/GPU/Memory/VMemAllocator.h"
 #include <string>
 
 namespace EngineCore
 {
 	class EngineDevice;
-	class GBuffer;
 
 	/* Image is an abstraction for an image or texture in video memory (VkImage), as the name implies */
 	class Image
@@ -23,7 +23,8 @@ namespace EngineCore
 
 		VkImage getImage() { return image; }
 		VkImageView getView() { return imageView; }
-		VkDeviceMemory getMemory() { return imageMemory; }
+		VkDeviceMemory getMemory() { return allocation.memory; } // shared with other resources, see getAllocation()
+		const Allocation& getAllocation() const { return allocation; }
 
 		void updateView(VkFormat format, VkImageAspectFlags aspect, VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D);
 		// returns a new image view using the current image, does not update the default view
@@ -36,13 +37,11 @@ namespace EngineCore
 	private:
 		EngineDevice& device;
 		VkImage image = VK_NULL_HANDLE;
-		VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+		Allocation allocation; // invalid for images not owned by this object (e.g. swapchain images)
 		VkImageView imageView = VK_NULL_HANDLE; // default image view
 
 		void create(VkMemoryPropertyFlags memProps, VkImageCreateInfo info);
 		void loadFromDisk(const std::string& path);
-		void transitionImageLayout(VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
-		void copyBufferToImage(const GBuffer& buffer, uint32_t width, uint32_t height, uint32_t layerCount);
 		void destroyView();
 		void destroyImage();
 	};
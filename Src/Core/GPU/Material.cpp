@@ -193,8 +193,8 @@ namespace EngineCore
 
 		// these vertex bindings are to be used whenever rendering from a vertex buffer
 
-		auto vertexAttributes = Primitive::Vertex::getAttributeDescriptions();
-		auto vertexBindings = Primitive::Vertex::getBindingDescriptions();
+		auto vertexAttributes = Primitive::Vertex::getAttributeDescriptions(matInfo.shadingProperties.vertexFormat);
+		auto vertexBindings = Primitive::Vertex::getBindingDescriptions(matInfo.shadingProperties.vertexFormat);
 		if (matInfo.shadingProperties.useVertexInput)
 		{
 			cfg.vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttributes.size());
@@ -3,6 +3,7 @@
 #include "Core/GPU/Device.h"
 #include "Core/GPU/Descriptors.h"
 #include "Core/EngineSettings.h"
+#include "Core/Mesh/VertexFormat.h"
 
 #include <glm/glm.hpp>
 
@@ -50,6 +51,7 @@ namespace EngineCore
 		float lineWidth = 1.f;
 		bool useVertexInput = true; // enable when using vertex buffers
 		bool enableDepth = true; // enables reads and writes to the depth attachment
+		VertexFormat vertexFormat = VertexFormat::Float32; // must match the primitives drawn with the material
 	};
 
 	// holds all properties needed to create a material object (used to generate a pipeline config)
@@ -77,6 +79,7 @@ namespace EngineCore
 		Material& operator=(const Material&) = delete;
 
 		VkPipelineLayout getPipelineLayout() const { return pipelineLayout; }
+		const MaterialShadingProperties& getShadingProperties() const { return materialCreateInfo.shadingProperties; }
 
 		// binds this material's pipeline to the specified command buffer
 		void bindToCommandBuffer(VkCommandBuffer commandBuffer) const;
@@ -0,0 +1,488 @@
+#include "Core/GPU/Memory/VMemAllocator.h"
+#include "Core/GPU/Device.h"
+
+// std
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+namespace EngineCore
+{
+	// alignment is a power of two
+	static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+	static VkDeviceSize alignDown(VkDeviceSize value, VkDeviceSize alignment) { return value & ~(alignment - 1); }
+
+	DeviceMemoryAllocator::DeviceMemoryAllocator(EngineDevice& device, VkDeviceSize preferredBlockSize)
+		: device{ device }, preferredBlockSize{ preferredBlockSize }
+	{
+		// get properties and memory info about the physical device
+		const VkPhysicalDevice& gpu = device.getPhysicalDevice();
+		if (gpu == VK_NULL_HANDLE)
+		{
+			throw std::runtime_error("allocator error, invalid VkPhysicalDevice");
+		}
+
+		vkGetPhysicalDeviceMemoryProperties(gpu, &memoryProperties);
+		const VkPhysicalDeviceLimits& limits = device.properties.limits;
+		bufferImageGranularity = std::max<VkDeviceSize>(limits.bufferImageGranularity, 1);
+		nonCoherentAtomSize = std::max<VkDeviceSize>(limits.nonCoherentAtomSize, 1);
+		maxAllocationCount = limits.maxMemoryAllocationCount;
+
+		const uint32_t poolsPerType = bufferImageGranularity > 1 ? 2 : 1;
+		pools.resize(memoryProperties.memoryTypeCount * poolsPerType);
+		for (uint32_t i = 0; i < pools.size(); i++)
+		{
+			DeviceMemoryPool& pool = pools[i];
+			pool.memoryType = i / poolsPerType;
+			const VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[pool.memoryType].propertyFlags;
+			// non-coherent memory is flushed in whole atoms, resources never share one so a flush can't touch another resource
+			const bool nonCoherent = (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			pool.alignment = nonCoherent ? std::max<VkDeviceSize>(nonCoherentAtomSize, 16) : 16;
+			for (auto& level : pool.freeLists) { std::fill(std::begin(level), std::end(level), NONE); }
+		}
+	}
+
+	DeviceMemoryAllocator::~DeviceMemoryAllocator()
+	{
+		for (DeviceMemoryPool& pool : pools)
+		{
+			assert(pool.allocationCount == 0 && "allocator destroyed while resources still use its memory");
+			for (DeviceMemoryBlock& block : pool.blocks)
+			{
+				if (block.memory == VK_NULL_HANDLE) { continue; }
+				if (block.mapped) { vkUnmapMemory(device.device(), block.memory); }
+				vkFreeMemory(device.device(), block.memory, nullptr);
+			}
+		}
+	}
+
+	uint32_t DeviceMemoryAllocator::getPoolIndex(uint32_t memoryType, bool optimalTiling) const
+	{
+		// with a granularity of 1 linear and optimal resources can sit side by side
+		if (bufferImageGranularity == 1) { return memoryType; }
+		return memoryType * 2 + (optimalTiling ? 1 : 0);
+	}
+
+	VkDeviceSize DeviceMemoryAllocator::getBlockSize(uint32_t memoryType) const
+	{
+		// small heaps (e.g. the 256 MiB host visible device local heap) would be taken by a few blocks
+		const VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+		if (heapSize <= (1ull << 30)) { return std::min(preferredBlockSize, std::bit_floor(heapSize / 8)); }
+		return preferredBlockSize;
+	}
+
+	/* TLSF size classes, see "TLSF: a New Dynamic Memory Allocator for Real-Time Systems" (Masmano et al.)
+	mapping() is the class of a free span, mappingSearch() rounds up so every span in the class (or above) fits the size */
+	static void mapping(VkDeviceSize size, uint32_t slBits, uint32_t smallShift, uint32_t& fl, uint32_t& sl)
+	{
+		if (size < (1ull << smallShift))
+		{
+			fl = 0;
+			sl = static_cast<uint32_t>(size >> (smallShift - slBits));
+			return;
+		}
+		const uint32_t msb = static_cast<uint32_t>(std::bit_width(size)) - 1;
+		fl = msb - smallShift + 1;
+		sl = static_cast<uint32_t>(size >> (msb - slBits)) & ((1u << slBits) - 1);
+	}
+
+	static void mappingSearch(VkDeviceSize size, uint32_t slBits, uint32_t smallShift, uint32_t& fl, uint32_t& sl)
+	{
+		if (size < (1ull << smallShift)) { size += (1ull << (smallShift - slBits)) - 1; }
+		else { size += (1ull << (std::bit_width(size) - 1 - slBits)) - 1; }
+		mapping(size, slBits, smallShift, fl, sl);
+	}
+
+	uint32_t DeviceMemoryAllocator::newSpan(DeviceMemoryPool& pool)
+	{
+		if (pool.unusedSpans != NONE)
+		{
+			const uint32_t index = pool.unusedSpans;
+			pool.unusedSpans = pool.spans[index].nextFree;
+			pool.spans[index] = Span{};
+			return index;
+		}
+		pool.spans.emplace_back();
+		return static_cast<uint32_t>(pool.spans.size() - 1);
+	}
+
+	void DeviceMemoryAllocator::recycleSpan(DeviceMemoryPool& pool, uint32_t spanIndex)
+	{
+		pool.spans[spanIndex] = Span{};
+		pool.spans[spanIndex].nextFree = pool.unusedSpans;
+		pool.unusedSpans = spanIndex;
+	}
+
+	void DeviceMemoryAllocator::insertFreeSpan(DeviceMemoryPool& pool, uint32_t spanIndex)
+	{
+		Span& span = pool.spans[spanIndex];
+		uint32_t fl, sl;
+		mapping(span.size, SL_BITS, SMALL_SHIFT, fl, sl);
+		span.free = true;
+		span.prevFree = NONE;
+		span.nextFree = pool.freeLists[fl][sl];
+		if (span.nextFree != NONE) { pool.spans[span.nextFree].prevFree = spanIndex; }
+		pool.freeLists[fl][sl] = spanIndex;
+		pool.firstLevelMap |= 1ull << fl;
+		pool.secondLevelMap[fl] |= 1u << sl;
+	}
+
+	void DeviceMemoryAllocator::removeFreeSpan(DeviceMemoryPool& pool, uint32_t spanIndex)
+	{
+		Span& span = pool.spans[spanIndex];
+		uint32_t fl, sl;
+		mapping(span.size, SL_BITS, SMALL_SHIFT, fl, sl);
+		if (span.prevFree != NONE) { pool.spans[span.prevFree].nextFree = span.nextFree; }
+		else { pool.freeLists[fl][sl] = span.nextFree; }
+		if (span.nextFree != NONE) { pool.spans[span.nextFree].prevFree = span.prevFree; }
+		if (pool.freeLists[fl][sl] == NONE)
+		{
+			pool.secondLevelMap[fl] &= ~(1u << sl);
+			if (pool.secondLevelMap[fl] == 0) { pool.firstLevelMap &= ~(1ull << fl); }
+		}
+		span.free = false;
+		span.prevFree = span.nextFree = NONE;
+	}
+
+	uint32_t DeviceMemoryAllocator::findFreeSpan(DeviceMemoryPool& pool, VkDeviceSize size, VkDeviceSize alignment)
+	{
+		// first span of the first non-empty class at or above the class of searchSize, using the bitmaps
+		auto findSuitable = [&pool](VkDeviceSize searchSize) -> uint32_t
+		{
+			uint32_t fl, sl;
+			mappingSearch(searchSize, SL_BITS, SMALL_SHIFT, fl, sl);
+			if (fl >= FL_COUNT) { return NONE; }
+			uint32_t slMap = pool.secondLevelMap[fl] & (~0u << sl);
+			if (slMap == 0)
+			{
+				const uint64_t flMap = fl + 1 < 64 ? pool.firstLevelMap & (~0ull << (fl + 1)) : 0;
+				if (flMap == 0) { return NONE; }
+				fl = static_cast<uint32_t>(std::countr_zero(flMap));
+				slMap = pool.secondLevelMap[fl];
+			}
+			sl = static_cast<uint32_t>(std::countr_zero(slMap));
+			return pool.freeLists[fl][sl];
+		};
+
+		const uint32_t spanIndex = findSuitable(size);
+		if (spanIndex == NONE || alignment <= pool.alignment) { return spanIndex; }
+
+		// span offsets are multiples of the pool alignment, a larger alignment may need that much padding in front
+		const Span& span = pool.spans[spanIndex];
+		if (alignUp(span.offset, alignment) + size <= span.offset + span.size) { return spanIndex; }
+		return findSuitable(size + alignment - pool.alignment);
+	}
+
+	uint32_t DeviceMemoryAllocator::useSpan(DeviceMemoryPool& pool, uint32_t spanIndex, VkDeviceSize size, VkDeviceSize alignment)
+	{
+		removeFreeSpan(pool, spanIndex);
+
+		// padding in front stays free as a span of its own
+		const VkDeviceSize padding = alignUp(pool.spans[spanIndex].offset, alignment) - pool.spans[spanIndex].offset;
+		if (padding > 0)
+		{
+			const uint32_t front = newSpan(pool);
+			Span& span = pool.spans[spanIndex];
+			Span& frontSpan = pool.spans[front];
+			frontSpan.offset = span.offset;
+			frontSpan.size = padding;
+			frontSpan.block = span.block;
+			frontSpan.prevPhysical = span.prevPhysical;
+			frontSpan.nextPhysical = spanIndex;
+			if (span.prevPhysical != NONE) { pool.spans[span.prevPhysical].nextPhysical = front; }
+			span.prevPhysical = front;
+			span.offset += padding;
+			span.size -= padding;
+			insertFreeSpan(pool, front);
+		}
+
+		// so does the rest
+		assert(pool.spans[spanIndex].size >= size && "allocator error, free span is too small");
+		if (pool.spans[spanIndex].size > size)
+		{
+			const uint32_t back = newSpan(pool);
+			Span& span = pool.spans[spanIndex];
+			Span& backSpan = pool.spans[back];
+			backSpan.offset = span.offset + size;
+			backSpan.size = span.size - size;
+			backSpan.block = span.block;
+			backSpan.prevPhysical = spanIndex;
+			backSpan.nextPhysical = span.nextPhysical;
+			if (span.nextPhysical != NONE) { pool.spans[span.nextPhysical].prevPhysical = back; }
+			span.nextPhysical = back;
+			span.size = size;
+			insertFreeSpan(pool, back);
+		}
+		return spanIndex;
+	}
+
+	uint32_t DeviceMemoryAllocator::addBlockToPool(DeviceMemoryPool& pool, VkDeviceSize size, bool dedicated)
+	{
+		if (blockCountTotal >= maxAllocationCount)
+		{
+			throw std::runtime_error("allocation failed, limit exceeded");
+		}
+
+		VkMemoryAllocateInfo info{};
+		info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		info.allocationSize = size;
+		info.memoryTypeIndex = pool.memoryType;
+
+		DeviceMemoryBlock newBlock{};
+		VkResult res = vkAllocateMemory(device.device(), &info, nullptr, &newBlock.memory);
+		if (res == VK_ERROR_OUT_OF_DEVICE_MEMORY || res == VK_ERROR_OUT_OF_HOST_MEMORY) { return NONE; }
+		if (res == VK_ERROR_TOO_MANY_OBJECTS)
+		{
+			throw std::runtime_error("allocation failed, limit exceeded");
+		}
+		if (res != VK_SUCCESS)
+		{
+			throw std::runtime_error("allocation failed, unknown error");
+		}
+
+		// host visible blocks are mapped once, a memory object can't be mapped by each resource in it
+		if (memoryProperties.memoryTypes[pool.memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			if (vkMapMemory(device.device(), newBlock.memory, 0, VK_WHOLE_SIZE, 0, &newBlock.mapped) != VK_SUCCESS)
+			{
+				vkFreeMemory(device.device(), newBlock.memory, nullptr);
+				throw std::runtime_error("allocation failed, could not map memory block");
+			}
+		}
+		newBlock.size = size;
+		newBlock.dedicated = dedicated;
+		blockCountTotal++;
+
+		// reuse the slot of a released block
+		uint32_t blockIndex = 0;
+		while (blockIndex < pool.blocks.size() && pool.blocks[blockIndex].memory != VK_NULL_HANDLE) { blockIndex++; }
+		if (blockIndex == pool.blocks.size()) { pool.blocks.push_back(newBlock); }
+		else { pool.blocks[blockIndex] = newBlock; }
+
+		const uint32_t spanIndex = newSpan(pool);
+		pool.spans[spanIndex].offset = 0;
+		pool.spans[spanIndex].size = size;
+		pool.spans[spanIndex].block = blockIndex;
+		insertFreeSpan(pool, spanIndex);
+		return spanIndex;
+	}
+
+	void DeviceMemoryAllocator::releaseBlock(DeviceMemoryPool& pool, uint32_t blockIndex)
+	{
+		DeviceMemoryBlock& block = pool.blocks[blockIndex];
+		if (block.mapped) { vkUnmapMemory(device.device(), block.memory); }
+		vkFreeMemory(device.device(), block.memory, nullptr);
+		block = DeviceMemoryBlock{};
+		blockCountTotal--;
+	}
+
+	Allocation DeviceMemoryAllocator::alloc(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool optimalTiling)
+	{
+		const uint32_t memType = device.findMemoryType(requirements.memoryTypeBits, properties);
+		const uint32_t poolIndex = getPoolIndex(memType, optimalTiling);
+		DeviceMemoryPool& pool = pools[poolIndex];
+
+		const VkDeviceSize size = alignUp(std::max<VkDeviceSize>(requirements.size, 1), pool.alignment);
+		const VkDeviceSize alignment = std::max(requirements.alignment, pool.alignment);
+		const VkDeviceSize blockSize = getBlockSize(memType);
+
+		uint32_t spanIndex = NONE;
+		if (size > blockSize / 2)
+		{
+			// a block of its own, sharing it would waste most of the rest
+			spanIndex = addBlockToPool(pool, size, true);
+		}
+		else
+		{
+			spanIndex = findFreeSpan(pool, size, alignment);
+			// no room, a new block. smaller ones if the device runs low on memory
+			for (VkDeviceSize newBlockSize = blockSize; spanIndex == NONE && newBlockSize >= size; newBlockSize /= 2)
+			{
+				spanIndex = addBlockToPool(pool, newBlockSize, false);
+			}
+		}
+		if (spanIndex == NONE)
+		{
+			throw std::runtime_error("allocation failed, out of device memory");
+		}
+		spanIndex = useSpan(pool, spanIndex, size, alignment);
+
+		const Span& span = pool.spans[spanIndex];
+		DeviceMemoryBlock& block = pool.blocks[span.block];
+		block.allocationCount++;
+		pool.allocationCount++;
+		pool.usedBytes += span.size;
+
+		Allocation allocation{};
+		allocation.memory = block.memory;
+		allocation.offset = span.offset;
+		allocation.size = requirements.size;
+		allocation.memoryType = memType;
+		allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + span.offset : nullptr;
+		allocation.pool = poolIndex;
+		allocation.span = spanIndex;
+		return allocation;
+	}
+
+	Allocation DeviceMemoryAllocator::allocForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties)
+	{
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(device.device(), buffer, &memRequirements);
+		Allocation allocation = alloc(memRequirements, properties, false);
+		if (vkBindBufferMemory(device.device(), buffer, allocation.memory, allocation.offset) != VK_SUCCESS)
+		{
+			free(allocation);
+			throw std::runtime_error("failed to bind VkBuffer memory");
+		}
+		return allocation;
+	}
+
+	Allocation DeviceMemoryAllocator::allocForImage(VkImage image, VkMemoryPropertyFlags properties, VkImageTiling tiling)
+	{
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(device.device(), image, &memRequirements);
+		Allocation allocation = alloc(memRequirements, properties, tiling == VK_IMAGE_TILING_OPTIMAL);
+		if (vkBindImageMemory(device.device(), image, allocation.memory, allocation.offset) != VK_SUCCESS)
+		{
+			free(allocation);
+			throw std::runtime_error("failed to bind memory for image");
+		}
+		return allocation;
+	}
+
+	void DeviceMemoryAllocator::free(Allocation& allocation)
+	{
+		if (!allocation.isValid()) { return; }
+		DeviceMemoryPool& pool = pools[allocation.pool];
+		uint32_t spanIndex = allocation.span;
+		assert(!pool.spans[spanIndex].free && "allocator error, memory freed twice");
+
+		const uint32_t blockIndex = pool.spans[spanIndex].block;
+		DeviceMemoryBlock& block = pool.blocks[blockIndex];
+		block.allocationCount--;
+		pool.allocationCount--;
+		pool.usedBytes -= pool.spans[spanIndex].size;
+
+		// merge with the free neighbours, free spans never touch each other
+		const uint32_t prev = pool.spans[spanIndex].prevPhysical;
+		if (prev != NONE && pool.spans[prev].free)
+		{
+			removeFreeSpan(pool, prev);
+			pool.spans[prev].size += pool.spans[spanIndex].size;
+			pool.spans[prev].nextPhysical = pool.spans[spanIndex].nextPhysical;
+			if (pool.spans[prev].nextPhysical != NONE) { pool.spans[pool.spans[prev].nextPhysical].prevPhysical = prev; }
+			recycleSpan(pool, spanIndex);
+			spanIndex = prev;
+		}
+		const uint32_t next = pool.spans[spanIndex].nextPhysical;
+		if (next != NONE && pool.spans[next].free)
+		{
+			removeFreeSpan(pool, next);
+			pool.spans[spanIndex].size += pool.spans[next].size;
+			pool.spans[spanIndex].nextPhysical = pool.spans[next].nextPhysical;
+			if (pool.spans[spanIndex].nextPhysical != NONE) { pool.spans[pool.spans[spanIndex].nextPhysical].prevPhysical = spanIndex; }
+			recycleSpan(pool, next);
+		}
+		allocation = Allocation{};
+
+		// empty blocks go back to the device, except for one regular block per pool so alloc/free cycles don't hit vkAllocateMemory
+		bool releaseEmptyBlock = block.allocationCount == 0 && block.dedicated;
+		if (block.allocationCount == 0 && !block.dedicated)
+		{
+			for (uint32_t i = 0; i < pool.blocks.size(); i++)
+			{
+				const DeviceMemoryBlock& other = pool.blocks[i];
+				if (i != blockIndex && other.memory != VK_NULL_HANDLE && !other.dedicated) { releaseEmptyBlock = true; break; }
+			}
+		}
+		if (releaseEmptyBlock)
+		{
+			recycleSpan(pool, spanIndex);
+			releaseBlock(pool, blockIndex);
+			return;
+		}
+		insertFreeSpan(pool, spanIndex);
+	}
+
+	static VkResult syncMappedRange(VkDevice device, VkDeviceMemory memory, VkDeviceSize begin, VkDeviceSize end, bool flush)
+	{
+		VkMappedMemoryRange mappedRange{};
+		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		mappedRange.memory = memory;
+		mappedRange.offset = begin;
+		mappedRange.size = end - begin;
+		return flush ? vkFlushMappedMemoryRanges(device, 1, &mappedRange) : vkInvalidateMappedMemoryRanges(device, 1, &mappedRange);
+	}
+
+	VkResult DeviceMemoryAllocator::flush(const Allocation& allocation, VkDeviceSize size, VkDeviceSize offset)
+	{
+		if (!allocation.isValid()) { return VK_ERROR_MEMORY_MAP_FAILED; }
+		if (memoryProperties.memoryTypes[allocation.memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) { return VK_SUCCESS; }
+
+		// the allocation starts and ends on whole atoms in non-coherent pools (see the pool alignment)
+		const VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.size : offset + size;
+		return syncMappedRange(device.device(), allocation.memory, allocation.offset + alignDown(offset, nonCoherentAtomSize),
+			allocation.offset + alignUp(end, nonCoherentAtomSize), true);
+	}
+
+	VkResult DeviceMemoryAllocator::invalidate(const Allocation& allocation, VkDeviceSize size, VkDeviceSize offset)
+	{
+		if (!allocation.isValid()) { return VK_ERROR_MEMORY_MAP_FAILED; }
+		if (memoryProperties.memoryTypes[allocation.memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) { return VK_SUCCESS; }
+
+		const VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.size : offset + size;
+		return syncMappedRange(device.device(), allocation.memory, allocation.offset + alignDown(offset, nonCoherentAtomSize),
+			allocation.offset + alignUp(end, nonCoherentAtomSize), false);
+	}
+
+	void DeviceMemoryAllocator::addPoolStats(const DeviceMemoryPool& pool, DeviceMemoryStats& stats) const
+	{
+		for (const DeviceMemoryBlock& block : pool.blocks)
+		{
+			if (block.memory == VK_NULL_HANDLE) { continue; }
+			stats.blockCount++;
+			stats.blockBytes += block.size;
+		}
+		stats.allocationCount += pool.allocationCount;
+		stats.usedBytes += pool.usedBytes;
+		for (const Span& span : pool.spans)
+		{
+			if (!span.free) { continue; }
+			stats.freeRangeCount++;
+			stats.largestFreeRange = std::max(stats.largestFreeRange, span.size);
+		}
+	}
+
+	DeviceMemoryStats DeviceMemoryAllocator::getStats(uint32_t memoryType) const
+	{
+		DeviceMemoryStats stats{};
+		for (const DeviceMemoryPool& pool : pools)
+		{
+			if (pool.memoryType == memoryType) { addPoolStats(pool, stats); }
+		}
+		return stats;
+	}
+
+	DeviceMemoryStats DeviceMemoryAllocator::getStats() const
+	{
+		DeviceMemoryStats stats{};
+		for (const DeviceMemoryPool& pool : pools) { addPoolStats(pool, stats); }
+		return stats;
+	}
+
+	void DeviceMemoryAllocator::printStats() const
+	{
+		const double MiB = 1024.0 * 1024.0;
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		{
+			const DeviceMemoryStats stats = getStats(i);
+			if (stats.blockCount == 0) { continue; }
+			std::cout << "memory type " << i << ": " << stats.blockCount << " blocks (" << stats.blockBytes / MiB << " MiB), "
+				<< stats.allocationCount << " allocations (" << stats.usedBytes / MiB << " MiB used), "
+				<< stats.freeRangeCount << " free ranges, fragmentation " << stats.fragmentation() << "\n";
+		}
+	}
+
+} // namespace
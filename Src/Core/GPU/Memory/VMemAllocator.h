@@ -0,0 +1,165 @@
+#pragma once
+
+#pragma warning(push, 0) // warning-ignore hack only works in header
+#include <vulkan/vulkan.h>
+#pragma warning(pop)
+
+#include <cstdint>
+#include <vector>
+
+namespace EngineCore
+{
+	class EngineDevice;
+
+	// info about an individual resource and where it is in device memory
+	struct Allocation
+	{
+		// parent block, shared with the other resources in it
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		// offset within memory block
+		VkDeviceSize offset = 0;
+		// size of the resource (as requested)
+		VkDeviceSize size = 0;
+		// type of memory the resource resides in
+		uint32_t memoryType = 0;
+		// host address of the resource if the memory is host visible (blocks stay mapped), otherwise nullptr
+		void* mapped = nullptr;
+		// allocator bookkeeping
+		uint32_t pool = 0;
+		uint32_t span = UINT32_MAX;
+
+		bool isValid() const { return memory != VK_NULL_HANDLE; }
+	};
+
+	// usage of one memory type, or of all of them
+	struct DeviceMemoryStats
+	{
+		uint32_t blockCount = 0; // vkAllocateMemory calls alive
+		uint32_t allocationCount = 0; // resources placed in the blocks
+		VkDeviceSize blockBytes = 0; // memory taken from the device
+		VkDeviceSize usedBytes = 0; // memory taken by resources, sizes rounded up to the pool alignment
+		uint32_t freeRangeCount = 0;
+		VkDeviceSize largestFreeRange = 0;
+
+		// 0 when all free memory is one range, close to 1 when it is scattered in small pieces
+		float fragmentation() const
+		{
+			const VkDeviceSize freeBytes = blockBytes - usedBytes;
+			return freeBytes == 0 ? 0.f : 1.f - static_cast<float>(largestFreeRange) / static_cast<float>(freeBytes);
+		}
+	};
+
+	/* this allocator manages resources (e.g. textures) in device memory (vram)
+	instead of one vkAllocateMemory per resource (slow, and drivers cap the count, often at 4096) resources are placed in large blocks
+	there is a pool of blocks per memory type, free ranges are kept in TLSF (two-level segregated fit) lists, alloc and free are O(1)
+	buffers and linear images never share a bufferImageGranularity page with optimal images, they get separate pools if the granularity is above 1
+	resources larger than half a block get a block of their own. host visible blocks stay mapped for their whole lifetime
+	not thread safe, resources are created and destroyed from the main thread */
+	class DeviceMemoryAllocator
+	{
+	public:
+		static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull << 20; // bytes, smaller on small heaps
+
+		DeviceMemoryAllocator(EngineDevice& device, VkDeviceSize preferredBlockSize = DEFAULT_BLOCK_SIZE);
+		~DeviceMemoryAllocator();
+
+		DeviceMemoryAllocator(const DeviceMemoryAllocator&) = delete;
+		DeviceMemoryAllocator& operator=(const DeviceMemoryAllocator&) = delete;
+
+		// find space for a resource and assign it to a location in device memory, optimalTiling is true for images with VK_IMAGE_TILING_OPTIMAL
+		Allocation alloc(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool optimalTiling);
+		// allocates and binds memory for a buffer or an image
+		Allocation allocForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+		Allocation allocForImage(VkImage image, VkMemoryPropertyFlags properties, VkImageTiling tiling);
+		// gives the memory of a resource back, remember to stop using (and destroy) the associated resource. resets the allocation
+		void free(Allocation& allocation);
+
+		/* make host writes visible to the device and the other way around, only required for non-coherent memory
+		size and offset are relative to the allocation, the range is widened to nonCoherentAtomSize */
+		VkResult flush(const Allocation& allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+		VkResult invalidate(const Allocation& allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+		// usage of the specified memory type
+		DeviceMemoryStats getStats(uint32_t memoryType) const;
+		// usage across all memory types
+		DeviceMemoryStats getStats() const;
+		// prints the usage per memory type, e.g. to watch fragmentation
+		void printStats() const;
+
+	private:
+		static constexpr uint32_t NONE = UINT32_MAX;
+		// TLSF size classes: the first level is the power of two of the size, the second level splits it linearly in SL_COUNT classes
+		static constexpr uint32_t SL_BITS = 5;
+		static constexpr uint32_t SL_COUNT = 1u << SL_BITS;
+		static constexpr uint32_t SMALL_SHIFT = 8; // sizes below 256 bytes all share the first level 0
+		static constexpr uint32_t FL_COUNT = 64 - SMALL_SHIFT + 1;
+
+		// a range of a block, either in use by a resource or free. spans are kept in a list in address order per block
+		struct Span
+		{
+			VkDeviceSize offset = 0;
+			VkDeviceSize size = 0;
+			uint32_t block = NONE;
+			uint32_t prevPhysical = NONE;
+			uint32_t nextPhysical = NONE;
+			uint32_t prevFree = NONE; // links in the size class list while free, the span recycling list while unused
+			uint32_t nextFree = NONE;
+			bool free = false;
+		};
+
+		// an allocation block which may contain multiple individual allocations
+		struct DeviceMemoryBlock
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE; // VK_NULL_HANDLE once released, the slot is reused
+			VkDeviceSize size = 0;
+			void* mapped = nullptr;
+			uint32_t allocationCount = 0;
+			bool dedicated = false; // sized for one resource
+		};
+
+		// a collection of memory blocks of one memory type, with the free ranges of all of them
+		struct DeviceMemoryPool
+		{
+			uint32_t memoryType = 0;
+			VkDeviceSize alignment = 1; // minimum offset alignment of every resource in the pool
+			std::vector<DeviceMemoryBlock> blocks;
+			std::vector<Span> spans;
+			uint32_t unusedSpans = NONE; // recycled span slots
+			uint64_t firstLevelMap = 0; // bit per first level with a free span
+			uint32_t secondLevelMap[FL_COUNT] = {};
+			uint32_t freeLists[FL_COUNT][SL_COUNT];
+			VkDeviceSize usedBytes = 0;
+			uint32_t allocationCount = 0;
+		};
+
+		EngineDevice& device;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		VkDeviceSize preferredBlockSize;
+		VkDeviceSize bufferImageGranularity;
+		VkDeviceSize nonCoherentAtomSize;
+		uint32_t maxAllocationCount;
+		uint32_t blockCountTotal = 0; // across all pools, against maxAllocationCount (the engine allocates device memory nowhere else)
+
+		// two per memory type when linear and optimal resources are kept apart, otherwise one
+		std::vector<DeviceMemoryPool> pools;
+
+		uint32_t getPoolIndex(uint32_t memoryType, bool optimalTiling) const;
+		void addPoolStats(const DeviceMemoryPool& pool, DeviceMemoryStats& stats) const;
+		VkDeviceSize getBlockSize(uint32_t memoryType) const;
+
+		// adds a new block to the specified pool, returns the free span covering it or NONE if the device is out of memory
+		uint32_t addBlockToPool(DeviceMemoryPool& pool, VkDeviceSize size, bool dedicated);
+		void releaseBlock(DeviceMemoryPool& pool, uint32_t blockIndex);
+
+		// finds a free span that can fit the allocation with its alignment, or NONE
+		uint32_t findFreeSpan(DeviceMemoryPool& pool, VkDeviceSize size, VkDeviceSize alignment);
+		// takes size bytes at an aligned offset out of a free span, the rest of it stays free
+		uint32_t useSpan(DeviceMemoryPool& pool, uint32_t spanIndex, VkDeviceSize size, VkDeviceSize alignment);
+
+		uint32_t newSpan(DeviceMemoryPool& pool);
+		void recycleSpan(DeviceMemoryPool& pool, uint32_t spanIndex);
+		void insertFreeSpan(DeviceMemoryPool& pool, uint32_t spanIndex);
+		void removeFreeSpan(DeviceMemoryPool& pool, uint32_t spanIndex);
+	};
+
+} // namespace
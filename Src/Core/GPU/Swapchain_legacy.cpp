@@ -53,13 +53,13 @@ namespace EngineCore {
 		{
 			vkDestroyImageView(device.device(), multisampleImageViews[i], nullptr);
 			vkDestroyImage(device.device(), multisampleImages[i], nullptr);
-			vkFreeMemory(device.device(), multisampleImageMemorys[i], nullptr);
+			device.getMemoryAllocator().free(multisampleImageAllocations[i]);
 		}
 
 		for (int i = 0; i < depthImages.size(); i++) {
 			vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
 			vkDestroyImage(device.device(), depthImages[i], nullptr);
-			vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+			device.getMemoryAllocator().free(depthImageAllocations[i]);
 		}
 
 		for (auto framebuffer : swapChainFramebuffers) {
@@ -323,7 +323,7 @@ namespace EngineCore {
 		VkExtent2D swapChainExtent = getSwapChainExtent();
 
 		depthImages.resize(imageCount());
-		depthImageMemorys.resize(imageCount());
+		depthImageAllocations.resize(imageCount());
 		depthImageViews.resize(imageCount());
 
 		for (int i = 0; i < depthImages.size(); i++) {
@@ -347,7 +347,7 @@ namespace EngineCore {
 				imageInfo,
 				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 				depthImages[i],
-				depthImageMemorys[i]);
+				depthImageAllocations[i]);
 
 			VkImageViewCreateInfo viewInfo{};
 			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -370,7 +370,7 @@ namespace EngineCore {
 		VkExtent2D swapChainExtent = getSwapChainExtent();
 
 		multisampleImages.resize(imageCount());
-		multisampleImageMemorys.resize(imageCount());
+		multisampleImageAllocations.resize(imageCount());
 		multisampleImageViews.resize(imageCount());
 
 		for (int i = 0; i < multisampleImages.size(); i++) {
@@ -391,7 +391,7 @@ namespace EngineCore {
 			imageInfo.flags = 0;
 
 			device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-				multisampleImages[i], multisampleImageMemorys[i]);
+				multisampleImages[i], multisampleImageAllocations[i]);
 
 			VkImageViewCreateInfo viewInfo{};
 			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
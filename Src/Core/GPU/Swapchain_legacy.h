@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Core/GPU/Device.h"
+#include "Core/GPU/Memory/VMemAllocator.h"
 
 // warning-ignore hack only works in header
 #pragma warning(push, 0) 
@@ -72,10 +73,10 @@ namespace EngineCore {
 
 		// framebuffer attachments
 		std::vector<VkImage> depthImages;
-		std::vector<VkDeviceMemory> depthImageMemorys;
+		std::vector<Allocation> depthImageAllocations;
 		std::vector<VkImageView> depthImageViews;
 		std::vector<VkImage> multisampleImages;
-		std::vector<VkDeviceMemory> multisampleImageMemorys;
+		std::vector<Allocation> multisampleImageAllocations;
 		std::vector<VkImageView> multisampleImageViews;
 
 		std::vector<VkImage> swapChainImages;
@@ -0,0 +1,337 @@
+#include "Core/GPU/UploadManager.h"
+#include "Core/GPU/Buffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace EngineCore
+{
+	// alignment is a power of two
+	static uint64_t alignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+	UploadManager::UploadManager(EngineDevice& device, VkDeviceSize ringSize) : device{ device }, ringSize{ ringSize }
+	{
+		assert(ringSize > 0 && (ringSize & (ringSize - 1)) == 0 && "upload ring size must be a power of two");
+
+		QueueFamilyIndices families = device.findPhysicalQueueFamilies();
+		graphicsFamily = families.graphicsFamily;
+		dedicatedTransfer = families.transferFamilyHasValue;
+		transferFamily = dedicatedTransfer ? families.transferFamily : graphicsFamily;
+		transferQueue = dedicatedTransfer ? device.transferQueue() : device.graphicsQueue();
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; // command buffers are reused batch after batch
+		poolInfo.queueFamilyIndex = transferFamily;
+		if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &transferPool) != VK_SUCCESS)
+		{ throw std::runtime_error("failed to create upload command pool"); }
+		if (dedicatedTransfer)
+		{
+			poolInfo.queueFamilyIndex = graphicsFamily;
+			if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &graphicsPool) != VK_SUCCESS)
+			{ throw std::runtime_error("failed to create upload command pool"); }
+		}
+
+		// texel copies are faster from the device's preferred offset alignment
+		const VkDeviceSize optimalAlignment = device.properties.limits.optimalBufferCopyOffsetAlignment;
+		if ((optimalAlignment & (optimalAlignment - 1)) == 0 && optimalAlignment <= ringSize)
+		{ imageAlignment = std::max(imageAlignment, optimalAlignment); }
+
+		ring = std::make_unique<GBuffer>(device, ringSize, 1, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		if (ring->map() != VK_SUCCESS) { throw std::runtime_error("failed to map upload staging ring"); }
+	}
+
+	UploadManager::~UploadManager()
+	{
+		waitIdle();
+		for (UploadBatch& batch : freeBatches) { destroyBatch(batch); }
+		// the command buffers are freed with their pools
+		vkDestroyCommandPool(device.device(), transferPool, nullptr);
+		if (graphicsPool != VK_NULL_HANDLE) { vkDestroyCommandPool(device.device(), graphicsPool, nullptr); }
+	}
+
+	UploadManager::UploadBatch UploadManager::makeBatch()
+	{
+		if (!freeBatches.empty())
+		{
+			UploadBatch batch = std::move(freeBatches.back());
+			freeBatches.pop_back();
+			return batch;
+		}
+
+		UploadBatch batch{};
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = transferPool;
+		allocInfo.commandBufferCount = 1;
+		if (vkAllocateCommandBuffers(device.device(), &allocInfo, &batch.transferCommands) != VK_SUCCESS)
+		{ throw std::runtime_error("failed to allocate upload command buffer"); }
+		if (dedicatedTransfer)
+		{
+			allocInfo.commandPool = graphicsPool;
+			if (vkAllocateCommandBuffers(device.device(), &allocInfo, &batch.acquireCommands) != VK_SUCCESS)
+			{ throw std::runtime_error("failed to allocate upload command buffer"); }
+
+			VkSemaphoreCreateInfo semaphoreInfo{};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &batch.transferDone) != VK_SUCCESS)
+			{ throw std::runtime_error("failed to create upload semaphore"); }
+		}
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		if (vkCreateFence(device.device(), &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS)
+		{ throw std::runtime_error("failed to create upload fence"); }
+		return batch;
+	}
+
+	void UploadManager::destroyBatch(UploadBatch& batch)
+	{
+		vkDestroyFence(device.device(), batch.fence, nullptr);
+		if (batch.transferDone != VK_NULL_HANDLE) { vkDestroySemaphore(device.device(), batch.transferDone, nullptr); }
+		batch = UploadBatch{};
+	}
+
+	UploadManager::UploadBatch& UploadManager::beginRecording()
+	{
+		if (isRecording) { return recording; }
+
+		recording = makeBatch();
+		recording.ticket = nextTicket++;
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(recording.transferCommands, &beginInfo);
+		isRecording = true;
+		return recording;
+	}
+
+	bool UploadManager::allocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offsetOut)
+	{
+		if (size > ringSize) { return false; }
+		while (true)
+		{
+			// nothing in use, start over at the beginning of the ring
+			if (ringTail == ringHead) { ringHead = ringTail = alignUp(ringHead, ringSize); }
+
+			uint64_t start = alignUp(ringHead, alignment);
+			if (start % ringSize + size > ringSize) { start = alignUp(start, ringSize); } // a copy never wraps around the end
+			if (start + size - ringTail <= ringSize)
+			{
+				ringHead = start + size;
+				offsetOut = start % ringSize;
+				return true;
+			}
+
+			// full, the oldest batch gives its space back when it finishes. if that is the batch being recorded, it is submitted first
+			if (inFlight.empty()) { flush(); }
+			retireBatches(true);
+		}
+	}
+
+	VkBuffer UploadManager::stageData(const void* data, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offsetOut)
+	{
+		if (allocateStaging(size, alignment, offsetOut))
+		{
+			std::memcpy(static_cast<char*>(ring->getMappedMemory()) + offsetOut, data, static_cast<size_t>(size));
+			return ring->getBuffer();
+		}
+
+		// larger than the ring, staged on its own and released with the batch
+		auto staging = std::make_unique<GBuffer>(device, size, 1, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		staging->map();
+		staging->writeToBuffer(const_cast<void*>(data));
+		staging->unmap();
+		offsetOut = 0;
+		const VkBuffer buffer = staging->getBuffer();
+		beginRecording().dedicatedStaging.push_back(std::move(staging));
+		return buffer;
+	}
+
+	uint64_t UploadManager::uploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset)
+	{
+		if (size == 0) { return nextTicket - 1; }
+
+		// staged before the batch is started, making room in the ring may submit the batch being recorded
+		VkDeviceSize srcOffset = 0;
+		const VkBuffer srcBuffer = stageData(data, size, bufferAlignment, srcOffset);
+		UploadBatch& batch = beginRecording();
+
+		VkBufferCopy region{};
+		region.srcOffset = srcOffset;
+		region.dstOffset = dstOffset;
+		region.size = size;
+		vkCmdCopyBuffer(batch.transferCommands, srcBuffer, dstBuffer, 1, &region);
+
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = dstBuffer;
+		barrier.offset = dstOffset;
+		barrier.size = size;
+		bufferBarriers.push_back(barrier);
+		return batch.ticket;
+	}
+
+	uint64_t UploadManager::uploadImage(VkImage image, const void* texels, VkDeviceSize size, VkExtent3D extent, uint32_t layerCount,
+		VkImageLayout finalLayout)
+	{
+		if (size == 0) { return nextTicket - 1; }
+
+		VkDeviceSize srcOffset = 0;
+		const VkBuffer srcBuffer = stageData(texels, size, imageAlignment, srcOffset);
+		UploadBatch& batch = beginRecording();
+
+		// vkCmdCopyBufferToImage needs the transfer layout, the previous contents are discarded
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = layerCount;
+		vkCmdPipelineBarrier(batch.transferCommands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = srcOffset;
+		region.bufferRowLength = 0; // tightly packed
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = layerCount;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = extent;
+		vkCmdCopyBufferToImage(batch.transferCommands, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		// to the final layout once all copies of the batch are recorded
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = finalLayout;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		imageBarriers.push_back(barrier);
+		return batch.ticket;
+	}
+
+	uint64_t UploadManager::flush()
+	{
+		retireBatches(false);
+		if (!isRecording) { return nextTicket - 1; }
+
+		UploadBatch batch = std::move(recording);
+		isRecording = false;
+		batch.ringEnd = ringHead;
+		const uint32_t bufferBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+		const uint32_t imageBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+
+		if (dedicatedTransfer)
+		{
+			// the transfer queue releases the resources, the graphics queue acquires them with the same barriers once the copies are done
+			for (auto& barrier : bufferBarriers) { barrier.srcQueueFamilyIndex = transferFamily; barrier.dstQueueFamilyIndex = graphicsFamily; barrier.dstAccessMask = 0; }
+			for (auto& barrier : imageBarriers) { barrier.srcQueueFamilyIndex = transferFamily; barrier.dstQueueFamilyIndex = graphicsFamily; barrier.dstAccessMask = 0; }
+			vkCmdPipelineBarrier(batch.transferCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+				0, nullptr, bufferBarrierCount, bufferBarriers.data(), imageBarrierCount, imageBarriers.data());
+			vkEndCommandBuffer(batch.transferCommands);
+
+			for (auto& barrier : bufferBarriers) { barrier.srcAccessMask = 0; barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT; }
+			for (auto& barrier : imageBarriers) { barrier.srcAccessMask = 0; barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT; }
+			VkCommandBufferBeginInfo beginInfo{};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			vkBeginCommandBuffer(batch.acquireCommands, &beginInfo);
+			vkCmdPipelineBarrier(batch.acquireCommands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+				0, nullptr, bufferBarrierCount, bufferBarriers.data(), imageBarrierCount, imageBarriers.data());
+			vkEndCommandBuffer(batch.acquireCommands);
+
+			VkSubmitInfo transferSubmit{};
+			transferSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			transferSubmit.commandBufferCount = 1;
+			transferSubmit.pCommandBuffers = &batch.transferCommands;
+			transferSubmit.signalSemaphoreCount = 1;
+			transferSubmit.pSignalSemaphores = &batch.transferDone;
+			if (vkQueueSubmit(transferQueue, 1, &transferSubmit, VK_NULL_HANDLE) != VK_SUCCESS)
+			{ throw std::runtime_error("failed to submit uploads"); }
+
+			// later submissions to the graphics queue are ordered after this one, frames wait for the uploads on the GPU only
+			const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			VkSubmitInfo acquireSubmit{};
+			acquireSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			acquireSubmit.waitSemaphoreCount = 1;
+			acquireSubmit.pWaitSemaphores = &batch.transferDone;
+			acquireSubmit.pWaitDstStageMask = &waitStage;
+			acquireSubmit.commandBufferCount = 1;
+			acquireSubmit.pCommandBuffers = &batch.acquireCommands;
+			if (vkQueueSubmit(device.graphicsQueue(), 1, &acquireSubmit, batch.fence) != VK_SUCCESS)
+			{ throw std::runtime_error("failed to submit uploads"); }
+		}
+		else
+		{
+			vkCmdPipelineBarrier(batch.transferCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+				0, nullptr, bufferBarrierCount, bufferBarriers.data(), imageBarrierCount, imageBarriers.data());
+			vkEndCommandBuffer(batch.transferCommands);
+
+			VkSubmitInfo submitInfo{};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &batch.transferCommands;
+			if (vkQueueSubmit(transferQueue, 1, &submitInfo, batch.fence) != VK_SUCCESS)
+			{ throw std::runtime_error("failed to submit uploads"); }
+		}
+
+		bufferBarriers.clear();
+		imageBarriers.clear();
+		const uint64_t ticket = batch.ticket;
+		inFlight.push_back(std::move(batch));
+		return ticket;
+	}
+
+	void UploadManager::retireBatches(bool waitForOldest)
+	{
+		if (waitForOldest && !inFlight.empty())
+		{
+			vkWaitForFences(device.device(), 1, &inFlight.front().fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		}
+		while (!inFlight.empty() && vkGetFenceStatus(device.device(), inFlight.front().fence) == VK_SUCCESS)
+		{
+			UploadBatch& batch = inFlight.front();
+			ringTail = std::max(ringTail, batch.ringEnd); // a batch without ring data ends where an earlier one did
+			completedTicket = batch.ticket;
+			batch.dedicatedStaging.clear();
+			vkResetFences(device.device(), 1, &batch.fence);
+			vkResetCommandBuffer(batch.transferCommands, 0);
+			if (batch.acquireCommands != VK_NULL_HANDLE) { vkResetCommandBuffer(batch.acquireCommands, 0); }
+			freeBatches.push_back(std::move(batch));
+			inFlight.pop_front();
+		}
+	}
+
+	bool UploadManager::isComplete(uint64_t ticket)
+	{
+		retireBatches(false);
+		return ticket <= completedTicket;
+	}
+
+	void UploadManager::wait(uint64_t ticket)
+	{
+		if (isRecording && ticket >= recording.ticket) { flush(); }
+		while (ticket > completedTicket && !inFlight.empty()) { retireBatches(true); }
+	}
+
+}
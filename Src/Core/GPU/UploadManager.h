@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Core/GPU/Device.h"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace EngineCore
+{
+	class GBuffer;
+
+	/* batches uploads of CPU data into device local buffers and images, instead of a queue stall per copy
+	the data is copied into a persistently mapped staging ring right away (the caller's memory can be freed after the call),
+	the GPU copies are recorded into one command buffer and submitted together by flush(), completion is tracked with a fence per batch
+	copies run on a dedicated transfer queue if the device has one, ownership of the resources then passes to the graphics queue
+	either way the data is visible to all work submitted to the graphics queue after the flush, e.g. the frame being recorded
+	staging space is reclaimed as batches finish, an upload larger than the whole ring gets a staging buffer of its own
+	not thread safe, it is used from the thread submitting frames */
+	class UploadManager
+	{
+	public:
+		static constexpr VkDeviceSize DEFAULT_RING_SIZE = 64ull << 20; // bytes, must be a power of two
+
+		UploadManager(EngineDevice& device, VkDeviceSize ringSize = DEFAULT_RING_SIZE);
+		~UploadManager(); // waits for the submitted batches
+
+		UploadManager(const UploadManager&) = delete;
+		UploadManager& operator=(const UploadManager&) = delete;
+
+		/* copies size bytes to dstBuffer at dstOffset, the buffer needs VK_BUFFER_USAGE_TRANSFER_DST_BIT
+		returns the ticket of the batch the copy is part of */
+		uint64_t uploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+		/* fills mip level 0 of a color image from tightly packed texels and moves it from an undefined layout to finalLayout
+		the image needs VK_IMAGE_USAGE_TRANSFER_DST_BIT, returns the ticket of the batch the copy is part of */
+		uint64_t uploadImage(VkImage image, const void* texels, VkDeviceSize size, VkExtent3D extent, uint32_t layerCount = 1,
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		/* submits the uploads recorded since the last flush as one batch, without waiting, and reclaims the staging space of finished batches
+		returns the ticket of the submitted batch, or of the last one if nothing was recorded */
+		uint64_t flush();
+		// true once the batch with the ticket has finished on the GPU
+		bool isComplete(uint64_t ticket);
+		// blocks until the batch with the ticket has finished, submitting it first if needed
+		void wait(uint64_t ticket);
+		void waitIdle() { wait(flush()); }
+
+	private:
+		// command buffers and sync objects of one submission, reused once it has finished
+		struct UploadBatch
+		{
+			VkCommandBuffer transferCommands = VK_NULL_HANDLE;
+			VkCommandBuffer acquireCommands = VK_NULL_HANDLE; // graphics queue side of the ownership transfer (dedicated transfer queue only)
+			VkSemaphore transferDone = VK_NULL_HANDLE; // signals acquireCommands to start (dedicated transfer queue only)
+			VkFence fence = VK_NULL_HANDLE;
+			uint64_t ticket = 0;
+			uint64_t ringEnd = 0; // ring position after the batch's staging data
+			std::vector<std::unique_ptr<GBuffer>> dedicatedStaging; // uploads too large for the ring
+		};
+
+		EngineDevice& device;
+		uint32_t graphicsFamily = 0;
+		uint32_t transferFamily = 0;
+		bool dedicatedTransfer = false; // transferFamily differs from graphicsFamily, resources change owner after the copies
+		VkQueue transferQueue = VK_NULL_HANDLE;
+		VkCommandPool transferPool = VK_NULL_HANDLE;
+		VkCommandPool graphicsPool = VK_NULL_HANDLE; // dedicated transfer queue only
+		VkDeviceSize bufferAlignment = 16;
+		VkDeviceSize imageAlignment = 16;
+
+		// positions in the ring only ever grow, the byte offset is the position modulo the ring size
+		std::unique_ptr<GBuffer> ring;
+		VkDeviceSize ringSize = 0;
+		uint64_t ringHead = 0; // end of the last allocation
+		uint64_t ringTail = 0; // start of the oldest allocation still in use by the GPU
+
+		UploadBatch recording; // valid while isRecording
+		bool isRecording = false;
+		std::vector<VkBufferMemoryBarrier> bufferBarriers; // recorded at flush, after all copies of the batch
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		std::deque<UploadBatch> inFlight; // in submission order
+		std::vector<UploadBatch> freeBatches;
+		uint64_t nextTicket = 1;
+		uint64_t completedTicket = 0;
+
+		// offset of size bytes of staging space in the ring, false if it would not fit even when empty. waits for batches to finish if it is full
+		bool allocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offsetOut);
+		// writes the data to staging memory (the ring, or a buffer of its own added to the batch), returns the buffer and offset to copy from
+		VkBuffer stageData(const void* data, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offsetOut);
+		UploadBatch& beginRecording();
+		UploadBatch makeBatch();
+		void destroyBatch(UploadBatch& batch);
+		// reclaims the batches that have finished, in submission order, after waiting for the oldest one if asked to
+		void retireBatches(bool waitForOldest);
+	};
+
+}
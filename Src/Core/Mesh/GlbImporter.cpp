@@ -0,0 +1,465 @@
+#include "Core/Mesh/GlbImporter.h"
+#include "Core/Dependencies/json-rpg/Document.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+namespace EngineCore
+{
+	static constexpr uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+	static constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+	static constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+	// accessor component types and primitive modes, as numbered by the glTF specification
+	static constexpr int64_t GLTF_BYTE = 5120;
+	static constexpr int64_t GLTF_UNSIGNED_BYTE = 5121;
+	static constexpr int64_t GLTF_SHORT = 5122;
+	static constexpr int64_t GLTF_UNSIGNED_SHORT = 5123;
+	static constexpr int64_t GLTF_UNSIGNED_INT = 5125;
+	static constexpr int64_t GLTF_FLOAT = 5126;
+	static constexpr size_t GLTF_TRIANGLES = 4;
+	static constexpr size_t GLTF_TRIANGLE_STRIP = 5;
+	static constexpr size_t GLTF_TRIANGLE_FAN = 6;
+
+	static_assert(sizeof(Primitive::Vertex) == 11 * sizeof(float), "the zero-copy path expects tightly packed float vertices");
+
+	// elements of an accessor, bounds-checked against the binary chunk
+	struct GlbAccessor
+	{
+		const char* data = nullptr; // nullptr if the attribute is absent
+		size_t count = 0;
+		size_t stride = 0;
+		int64_t componentType = 0;
+		uint32_t components = 0;
+		bool normalized = false;
+	};
+
+	// one primitive of a mesh node, its triangles are appended to the importer's indices as it is read
+	struct GlbPrimitive
+	{
+		GlbAccessor position, color, normal, texcoord;
+		glm::mat4 transform{ 1.f };
+	};
+
+	struct GlbMeshInstance
+	{
+		size_t mesh;
+		glm::mat4 transform;
+	};
+
+	[[noreturn]] static void throwGlbError(const std::string& path, const std::string& message)
+	{
+		throw std::runtime_error("error loading mesh from file: " + path + ": " + message);
+	}
+
+	bool isGlbPath(const std::string& path)
+	{
+		if (path.size() < 4) { return false; }
+		std::string extension = path.substr(path.size() - 4);
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".glb";
+	}
+
+	static uint32_t readGlbWord(const char* data)
+	{
+		uint32_t word;
+		std::memcpy(&word, data, sizeof(word)); // GLB is little-endian, like every platform the engine runs on
+		return word;
+	}
+
+	// non-negative integer member of a JSON object, or the fallback if missing
+	static size_t getGltfCount(const JSON::Node& object, std::string_view key, size_t fallback, const std::string& path)
+	{
+		const JSON::Node* value = object.find(key);
+		if (!value) { return fallback; }
+		if (!value->isInteger() || value->asInt() < 0) { throwGlbError(path, "invalid " + std::string(key)); }
+		return static_cast<size_t>(value->asInt());
+	}
+
+	// element of a top-level array (e.g. "accessors") by index, throws if out of range
+	static const JSON::Node& getGltfElement(const JSON::Node& gltf, std::string_view array, size_t index, const std::string& path)
+	{
+		const JSON::Node& elements = gltf[array];
+		if (elements.type != JSON::ObjectType::Array || index >= elements.size())
+		{
+			throwGlbError(path, "reference to missing " + std::string(array) + " element " + std::to_string(index));
+		}
+		return elements[index];
+	}
+
+	static size_t getComponentSize(int64_t componentType)
+	{
+		switch (componentType)
+		{
+		case GLTF_BYTE: case GLTF_UNSIGNED_BYTE: return 1;
+		case GLTF_SHORT: case GLTF_UNSIGNED_SHORT: return 2;
+		case GLTF_UNSIGNED_INT: case GLTF_FLOAT: return 4;
+		default: return 0;
+		}
+	}
+
+	static uint32_t getComponentCount(std::string_view type)
+	{
+		if (type == "SCALAR") { return 1; }
+		if (type == "VEC2") { return 2; }
+		if (type == "VEC3") { return 3; }
+		if (type == "VEC4") { return 4; }
+		return 0; // matrices are not vertex attributes
+	}
+
+	static GlbAccessor getGlbAccessor(const JSON::Node& gltf, size_t index, std::string_view bin, const std::string& path)
+	{
+		const JSON::Node& accessor = getGltfElement(gltf, "accessors", index, path);
+		if (accessor.find("sparse")) { throwGlbError(path, "sparse accessors are not supported"); }
+		if (!accessor.find("bufferView")) { throwGlbError(path, "accessors without a buffer view are not supported"); }
+
+		GlbAccessor result;
+		result.componentType = accessor["componentType"].asInt();
+		result.components = getComponentCount(accessor["type"].getValue());
+		result.count = getGltfCount(accessor, "count", 0, path);
+		result.normalized = accessor["normalized"].getValue() == "true";
+		const size_t elementSize = getComponentSize(result.componentType) * result.components;
+		if (!elementSize) { throwGlbError(path, "unsupported accessor type"); }
+
+		const JSON::Node& bufferView = getGltfElement(gltf, "bufferViews", getGltfCount(accessor, "bufferView", 0, path), path);
+		const JSON::Node& buffer = getGltfElement(gltf, "buffers", getGltfCount(bufferView, "buffer", 0, path), path);
+		// the binary chunk is the first buffer, and the only one without a uri
+		if (buffer.find("uri") || getGltfCount(bufferView, "buffer", 0, path) != 0) { throwGlbError(path, "external buffers are not supported"); }
+
+		const size_t viewOffset = getGltfCount(bufferView, "byteOffset", 0, path);
+		const size_t viewLength = getGltfCount(bufferView, "byteLength", 0, path);
+		const size_t offset = getGltfCount(accessor, "byteOffset", 0, path);
+		result.stride = getGltfCount(bufferView, "byteStride", elementSize, path);
+		if (viewOffset > bin.size() || viewLength > bin.size() - viewOffset || result.stride < elementSize) { throwGlbError(path, "buffer view out of range"); }
+		if (result.count && (offset > viewLength || viewLength - offset < elementSize || (result.count - 1) > (viewLength - offset - elementSize) / result.stride))
+		{
+			throwGlbError(path, "accessor out of range");
+		}
+		result.data = bin.data() + viewOffset + offset;
+		return result;
+	}
+
+	// components of element i as floats, normalized integers are mapped to [0, 1] or [-1, 1], up to count components are written
+	static void readGlbFloats(const GlbAccessor& accessor, size_t i, float* out, uint32_t count)
+	{
+		const char* element = accessor.data + i * accessor.stride;
+		for (uint32_t k = 0; k < std::min(count, accessor.components); k++)
+		{
+			switch (accessor.componentType)
+			{
+			case GLTF_FLOAT: std::memcpy(&out[k], element + k * 4, 4); break;
+			case GLTF_UNSIGNED_BYTE:
+			{
+				uint8_t v; std::memcpy(&v, element + k, 1);
+				out[k] = accessor.normalized ? v / 255.f : v;
+				break;
+			}
+			case GLTF_BYTE:
+			{
+				int8_t v; std::memcpy(&v, element + k, 1);
+				out[k] = accessor.normalized ? std::max(v / 127.f, -1.f) : v;
+				break;
+			}
+			case GLTF_UNSIGNED_SHORT:
+			{
+				uint16_t v; std::memcpy(&v, element + k * 2, 2);
+				out[k] = accessor.normalized ? v / 65535.f : v;
+				break;
+			}
+			case GLTF_SHORT:
+			{
+				int16_t v; std::memcpy(&v, element + k * 2, 2);
+				out[k] = accessor.normalized ? std::max(v / 32767.f, -1.f) : v;
+				break;
+			}
+			default: break;
+			}
+		}
+	}
+
+	static uint32_t readGlbIndex(const GlbAccessor& accessor, size_t i)
+	{
+		const char* element = accessor.data + i * accessor.stride;
+		switch (accessor.componentType)
+		{
+		case GLTF_UNSIGNED_BYTE: { uint8_t v; std::memcpy(&v, element, 1); return v; }
+		case GLTF_UNSIGNED_SHORT: { uint16_t v; std::memcpy(&v, element, 2); return v; }
+		default: { uint32_t v; std::memcpy(&v, element, 4); return v; }
+		}
+	}
+
+	// node matrix, or translation * rotation * scale
+	static glm::mat4 getGltfNodeTransform(const JSON::Node& node)
+	{
+		glm::mat4 transform{ 1.f };
+		if (const JSON::Node* matrix = node.find("matrix"); matrix && matrix->size() == 16)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				for (int r = 0; r < 4; r++) { transform[c][r] = static_cast<float>((*matrix)[c * 4 + r].asDouble()); }
+			}
+			return transform;
+		}
+
+		glm::vec3 translation{ 0.f }, scale{ 1.f };
+		float x = 0.f, y = 0.f, z = 0.f, w = 1.f;
+		if (const JSON::Node* t = node.find("translation"); t && t->size() == 3)
+		{
+			translation = { static_cast<float>((*t)[0].asDouble()), static_cast<float>((*t)[1].asDouble()), static_cast<float>((*t)[2].asDouble()) };
+		}
+		if (const JSON::Node* r = node.find("rotation"); r && r->size() == 4)
+		{
+			x = static_cast<float>((*r)[0].asDouble());
+			y = static_cast<float>((*r)[1].asDouble());
+			z = static_cast<float>((*r)[2].asDouble());
+			w = static_cast<float>((*r)[3].asDouble());
+		}
+		if (const JSON::Node* s = node.find("scale"); s && s->size() == 3)
+		{
+			scale = { static_cast<float>((*s)[0].asDouble()), static_cast<float>((*s)[1].asDouble()), static_cast<float>((*s)[2].asDouble()) };
+		}
+
+		// unit quaternion (x, y, z, w) to rotation columns, each scaled by its axis
+		transform[0] = glm::vec4{ 1.f - 2.f * (y * y + z * z), 2.f * (x * y + z * w), 2.f * (x * z - y * w), 0.f } * scale.x;
+		transform[1] = glm::vec4{ 2.f * (x * y - z * w), 1.f - 2.f * (x * x + z * z), 2.f * (y * z + x * w), 0.f } * scale.y;
+		transform[2] = glm::vec4{ 2.f * (x * z + y * w), 2.f * (y * z - x * w), 1.f - 2.f * (x * x + y * y), 0.f } * scale.z;
+		transform[3] = glm::vec4{ translation, 1.f };
+		return transform;
+	}
+
+	// mesh nodes of the default scene (or of all root nodes without scenes), depth first in file order, with their world transforms
+	static std::vector<GlbMeshInstance> collectGltfMeshInstances(const JSON::Node& gltf, const std::string& path)
+	{
+		const JSON::Node& nodes = gltf["nodes"];
+		std::vector<size_t> roots;
+		if (gltf["scenes"].size())
+		{
+			const JSON::Node& scene = getGltfElement(gltf, "scenes", getGltfCount(gltf, "scene", 0, path), path);
+			for (const JSON::Node& node : scene["nodes"]) { roots.push_back(static_cast<size_t>(node.asInt())); }
+		}
+		else
+		{
+			std::vector<bool> isChild(nodes.size(), false);
+			for (const JSON::Node& node : nodes)
+			{
+				for (const JSON::Node& child : node["children"])
+				{
+					if (child.asInt() >= 0 && static_cast<size_t>(child.asInt()) < nodes.size()) { isChild[child.asInt()] = true; }
+				}
+			}
+			for (size_t n = 0; n < nodes.size(); n++)
+			{
+				if (!isChild[n]) { roots.push_back(n); }
+			}
+		}
+
+		struct PendingNode
+		{
+			size_t node;
+			glm::mat4 parentTransform;
+			size_t depth;
+		};
+		std::vector<PendingNode> pending;
+		for (auto root = roots.rbegin(); root != roots.rend(); ++root) { pending.push_back(PendingNode{ *root, glm::mat4{ 1.f }, 0 }); }
+
+		std::vector<GlbMeshInstance> instances;
+		while (!pending.empty())
+		{
+			const PendingNode current = pending.back();
+			pending.pop_back();
+			// a valid hierarchy is a forest, deeper than the node count means a cycle
+			if (current.depth > nodes.size()) { throwGlbError(path, "node hierarchy has a cycle"); }
+			const JSON::Node& node = getGltfElement(gltf, "nodes", current.node, path);
+			const glm::mat4 transform = current.parentTransform * getGltfNodeTransform(node);
+			if (node.find("mesh")) { instances.push_back(GlbMeshInstance{ getGltfCount(node, "mesh", 0, path), transform }); }
+
+			const JSON::Node& children = node["children"];
+			for (size_t c = children.size(); c-- > 0;)
+			{
+				if (children[c].asInt() < 0) { throwGlbError(path, "invalid child node"); }
+				pending.push_back(PendingNode{ static_cast<size_t>(children[c].asInt()), transform, current.depth + 1 });
+			}
+		}
+		return instances;
+	}
+
+	// the primitive's vertices have the layout of Primitive::Vertex in the file and need no transform
+	static bool hasEngineVertexLayout(const GlbPrimitive& primitive)
+	{
+		const auto isAttribute = [&](const GlbAccessor& accessor, uint32_t components, size_t offset)
+		{
+			return accessor.data == primitive.position.data + offset && accessor.componentType == GLTF_FLOAT && !accessor.normalized
+				&& accessor.components == components && accessor.stride == sizeof(Primitive::Vertex) && accessor.count == primitive.position.count;
+		};
+		return primitive.transform == glm::mat4{ 1.f } && reinterpret_cast<uintptr_t>(primitive.position.data) % alignof(Primitive::Vertex) == 0
+			&& isAttribute(primitive.position, 3, offsetof(Primitive::Vertex, position)) && isAttribute(primitive.color, 3, offsetof(Primitive::Vertex, color))
+			&& isAttribute(primitive.normal, 3, offsetof(Primitive::Vertex, normal)) && isAttribute(primitive.texcoord, 2, offsetof(Primitive::Vertex, uv));
+	}
+
+	void GlbImporter::load(const std::string& path)
+	{
+		vertices.clear();
+		indices.clear();
+		submeshes.clear();
+		view = Primitive::MeshView{};
+		zeroCopy = false;
+		skippedPrimitives = 0;
+		if (!file.open(path)) { throwGlbError(path, "cannot read file"); }
+
+		// 12-byte header, then chunks of (length, type, data), the JSON chunk first and the optional binary chunk second
+		const std::string_view data = file.view();
+		if (data.size() < 20 || readGlbWord(data.data()) != GLB_MAGIC || readGlbWord(data.data() + 4) != 2) { throwGlbError(path, "not a glTF 2.0 binary file"); }
+		std::string_view json, bin;
+		for (size_t offset = 12; offset + 8 <= data.size();)
+		{
+			const size_t length = readGlbWord(data.data() + offset);
+			const uint32_t type = readGlbWord(data.data() + offset + 4);
+			if (length > data.size() - offset - 8) { throwGlbError(path, "truncated chunk"); }
+			if (type == GLB_CHUNK_JSON && json.empty()) { json = data.substr(offset + 8, length); }
+			else if (type == GLB_CHUNK_BIN && bin.empty()) { bin = data.substr(offset + 8, length); }
+			offset += 8 + length;
+		}
+
+		JSON::Document document;
+		if (json.empty() || JSON::load(json, document) != JSON::Result::OK) { throwGlbError(path, "invalid JSON chunk"); }
+		const JSON::Node& gltf = document.root();
+		for (const JSON::Node& extension : gltf["extensionsRequired"])
+		{
+			// the others concern materials, which are not imported
+			if (extension.getValue() == "KHR_draco_mesh_compression" || extension.getValue() == "EXT_meshopt_compression")
+			{
+				throwGlbError(path, "compressed meshes (" + std::string(extension.getValue()) + ") are not supported");
+			}
+		}
+
+		std::vector<GlbPrimitive> primitives;
+		size_t vertexCount = 0;
+		for (const GlbMeshInstance& instance : collectGltfMeshInstances(gltf, path))
+		{
+			for (const JSON::Node& node : getGltfElement(gltf, "meshes", instance.mesh, path)["primitives"])
+			{
+				const size_t mode = getGltfCount(node, "mode", GLTF_TRIANGLES, path);
+				if (mode != GLTF_TRIANGLES && mode != GLTF_TRIANGLE_STRIP && mode != GLTF_TRIANGLE_FAN)
+				{
+					skippedPrimitives++; // points or lines
+					continue;
+				}
+				const JSON::Node& attributes = node["attributes"];
+				if (!attributes.find("POSITION")) { throwGlbError(path, "primitive without positions"); }
+
+				GlbPrimitive primitive;
+				primitive.transform = instance.transform;
+				primitive.position = getGlbAccessor(gltf, getGltfCount(attributes, "POSITION", 0, path), bin, path);
+				const auto getAttribute = [&](std::string_view name, GlbAccessor& accessorOut)
+				{
+					if (!attributes.find(name)) { return; }
+					accessorOut = getGlbAccessor(gltf, getGltfCount(attributes, name, 0, path), bin, path);
+					if (accessorOut.count != primitive.position.count) { throwGlbError(path, std::string(name) + " count differs from POSITION count"); }
+				};
+				getAttribute("COLOR_0", primitive.color);
+				getAttribute("NORMAL", primitive.normal);
+				getAttribute("TEXCOORD_0", primitive.texcoord);
+
+				// corners as given, or the vertices in order when not indexed
+				std::vector<uint32_t> corners;
+				if (node.find("indices"))
+				{
+					const GlbAccessor indexAccessor = getGlbAccessor(gltf, getGltfCount(node, "indices", 0, path), bin, path);
+					if (indexAccessor.components != 1 || indexAccessor.componentType == GLTF_FLOAT || indexAccessor.componentType == GLTF_BYTE
+						|| indexAccessor.componentType == GLTF_SHORT)
+					{
+						throwGlbError(path, "invalid index accessor");
+					}
+					corners.resize(indexAccessor.count);
+					for (size_t i = 0; i < corners.size(); i++)
+					{
+						corners[i] = readGlbIndex(indexAccessor, i);
+						if (corners[i] >= primitive.position.count) { throwGlbError(path, "index out of range"); }
+					}
+				}
+				else
+				{
+					corners.resize(primitive.position.count);
+					for (size_t i = 0; i < corners.size(); i++) { corners[i] = static_cast<uint32_t>(i); }
+				}
+
+				// triangle lists of the primitive, rebased onto the vertices of the primitives before it
+				const auto base = static_cast<uint32_t>(vertexCount);
+				const bool mirrored = glm::determinant(primitive.transform) < 0.f; // keeps the front faces front facing
+				const auto firstIndex = static_cast<uint32_t>(indices.size());
+				const auto addTriangle = [&](uint32_t a, uint32_t b, uint32_t c)
+				{
+					if (mirrored) { std::swap(b, c); }
+					indices.insert(indices.end(), { base + a, base + b, base + c });
+				};
+				if (mode == GLTF_TRIANGLES)
+				{
+					for (size_t i = 0; i + 2 < corners.size(); i += 3) { addTriangle(corners[i], corners[i + 1], corners[i + 2]); }
+				}
+				else if (mode == GLTF_TRIANGLE_STRIP)
+				{
+					for (size_t i = 0; i + 2 < corners.size(); i++)
+					{
+						if (i % 2) { addTriangle(corners[i + 1], corners[i], corners[i + 2]); }
+						else { addTriangle(corners[i], corners[i + 1], corners[i + 2]); }
+					}
+				}
+				else
+				{
+					for (size_t i = 1; i + 1 < corners.size(); i++) { addTriangle(corners[i], corners[i + 1], corners[0]); }
+				}
+				if (indices.size() == firstIndex) { continue; }
+
+				submeshes.push_back(Primitive::Submesh{ firstIndex, static_cast<uint32_t>(indices.size()) - firstIndex });
+				vertexCount += primitive.position.count;
+				if (vertexCount > UINT32_MAX) { throwGlbError(path, "too many vertices"); }
+				primitives.push_back(primitive);
+			}
+		}
+		if (primitives.empty()) { throwGlbError(path, "no triangles in the scene"); }
+
+		// zero-copy if every primitive is stored in the engine layout, each right after the one before
+		zeroCopy = true;
+		for (size_t p = 0; p < primitives.size() && zeroCopy; p++)
+		{
+			zeroCopy = hasEngineVertexLayout(primitives[p]) && (p == 0
+				|| primitives[p].position.data == primitives[p - 1].position.data + primitives[p - 1].position.count * sizeof(Primitive::Vertex));
+		}
+		if (zeroCopy)
+		{
+			view.vertices = { reinterpret_cast<const Primitive::Vertex*>(primitives[0].position.data), vertexCount };
+		}
+		else
+		{
+			vertices.resize(vertexCount);
+			size_t v = 0;
+			for (const GlbPrimitive& primitive : primitives)
+			{
+				const glm::mat3 normalTransform = glm::transpose(glm::inverse(glm::mat3(primitive.transform)));
+				for (size_t i = 0; i < primitive.position.count; i++, v++)
+				{
+					Primitive::Vertex& vertex = vertices[v];
+					readGlbFloats(primitive.position, i, &vertex.position.x, 3);
+					vertex.position = glm::vec3(primitive.transform * glm::vec4(vertex.position, 1.f));
+					if (primitive.color.data) { readGlbFloats(primitive.color, i, &vertex.color.x, 3); }
+					if (primitive.normal.data)
+					{
+						readGlbFloats(primitive.normal, i, &vertex.normal.x, 3);
+						const glm::vec3 normal = normalTransform * vertex.normal;
+						const float length = glm::length(normal);
+						vertex.normal = (length > 0.f) ? normal / length : normal;
+					}
+					// glTF has its uv origin at the top left like Vulkan, unlike OBJ it needs no flip
+					if (primitive.texcoord.data) { readGlbFloats(primitive.texcoord, i, &vertex.uv.x, 2); }
+				}
+			}
+			view.vertices = vertices;
+		}
+		view.indices = indices;
+		view.submeshes = submeshes;
+	}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Core/Primitive.h"
+#include "Core/Dependencies/json-rpg/MappedFile.h"
+
+#include <string>
+
+namespace EngineCore
+{
+	// true for paths ending in .glb (any case)
+	bool isGlbPath(const std::string& path);
+
+	/* binary glTF 2.0 (.glb) mesh importer, the file is memory mapped and its JSON chunk parsed with json-rpg
+	every primitive of every mesh node in the scene becomes a submesh, with the node's world transform baked into its vertices
+	vertices are not converted when the file already stores them in the Primitive::Vertex layout (position, color, normal, uv as
+	floats, interleaved with a stride of 44 bytes, one after another in file order, untransformed), the view then points into the mapping
+	so they are copied straight into the staging buffer. otherwise they are gathered from the accessors into an owned array
+	only triangle lists, strips and fans are imported, the buffers must be embedded (no uri), sparse and compressed data is not supported */
+	class GlbImporter
+	{
+	public:
+		GlbImporter() = default;
+		GlbImporter(const GlbImporter&) = delete;
+		GlbImporter& operator=(const GlbImporter&) = delete;
+
+		// throws if the file cannot be read, is not a valid GLB or uses something unsupported
+		void load(const std::string& path);
+
+		// valid while the importer lives, e.g. for constructing a Primitive
+		const Primitive::MeshView& getView() const { return view; }
+		bool isZeroCopy() const { return zeroCopy; } // the vertices are read from the mapped file
+		// primitives of points or lines that were left out, for the caller to report
+		uint32_t getSkippedPrimitiveCount() const { return skippedPrimitives; }
+
+	private:
+		JSON::MappedFile file;
+		std::vector<Primitive::Vertex> vertices; // converted vertices, empty when zero-copy
+		std::vector<uint32_t> indices; // glTF indices are relative to each primitive, they are always rebased
+		std::vector<Primitive::Submesh> submeshes;
+		Primitive::MeshView view{};
+		bool zeroCopy = false;
+		uint32_t skippedPrimitives = 0;
+	};
+
+}
@@ -0,0 +1,251 @@
+#include "Core/Mesh/MeshCache.h"
+#include "Core/Mesh/MeshOptimizer.h"
+#include "Core/Mesh/MeshSimplifier.h"
+#include "Core/Mesh/MeshletBuilder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace EngineCore
+{
+	static constexpr char MESH_CACHE_MAGIC[4] = { 'V', 'K', 'M', 'C' };
+	static constexpr uint32_t MESH_CACHE_VERSION = 3;
+	static constexpr size_t MESH_CACHE_ALIGNMENT = 16;
+
+	// byte offsets of the sections of a cache file
+	struct MeshCacheLayout
+	{
+		size_t submeshOffset;
+		size_t lodOffset;
+		size_t meshletOffset;
+		size_t vertexOffset;
+		size_t indexOffset;
+		size_t fileSize;
+	};
+
+	static size_t alignCacheOffset(size_t offset) { return (offset + MESH_CACHE_ALIGNMENT - 1) & ~(MESH_CACHE_ALIGNMENT - 1); }
+
+	static MeshCacheLayout getCacheLayout(size_t vertexCount, size_t indexCount, size_t submeshCount, size_t lodCount, size_t meshletCount)
+	{
+		MeshCacheLayout layout{};
+		layout.submeshOffset = alignCacheOffset(sizeof(MeshCacheHeader));
+		layout.lodOffset = alignCacheOffset(layout.submeshOffset + submeshCount * sizeof(Primitive::Submesh));
+		layout.meshletOffset = alignCacheOffset(layout.lodOffset + lodCount * sizeof(Primitive::Lod));
+		layout.vertexOffset = alignCacheOffset(layout.meshletOffset + meshletCount * sizeof(Primitive::Meshlet));
+		layout.indexOffset = alignCacheOffset(layout.vertexOffset + vertexCount * sizeof(Primitive::Vertex));
+		layout.fileSize = layout.indexOffset + indexCount * sizeof(uint32_t);
+		return layout;
+	}
+
+	// only the options that change the resulting streams, the cache stays valid when e.g. parallel is toggled
+	static uint32_t getCacheOptionBits(const MeshLoadOptions& options)
+	{
+		return (options.weldVertices ? 1u : 0u) | (options.optimize ? 2u : 0u) | (options.generateLods ? 4u : 0u) | (options.buildMeshlets ? 8u : 0u);
+	}
+
+	// size and write time of the source, false if it does not exist
+	static bool getSourceStamp(const std::string& sourcePath, uint64_t& sizeOut, int64_t& writeTimeOut)
+	{
+		std::error_code error;
+		sizeOut = std::filesystem::file_size(sourcePath, error);
+		if (error) { return false; }
+		const auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+		if (error) { return false; }
+		writeTimeOut = static_cast<int64_t>(writeTime.time_since_epoch().count());
+		return true;
+	}
+
+	static void computeBounds(std::span<const Primitive::Vertex> vertices, glm::vec3& minOut, glm::vec3& maxOut)
+	{
+		minOut = maxOut = vertices.empty() ? glm::vec3{ 0.f } : vertices[0].position;
+		for (const auto& v : vertices)
+		{
+			minOut = glm::min(minOut, v.position);
+			maxOut = glm::max(maxOut, v.position);
+		}
+	}
+
+	std::string getDefaultMeshCacheDirectory()
+	{
+		std::error_code error;
+		const std::filesystem::path temporary = std::filesystem::temp_directory_path(error);
+		return error ? std::string() : (temporary / "vk-rpg" / "meshcache").string();
+	}
+
+	std::string getMeshCachePath(const std::string& sourcePath, const std::string& cacheDirectory)
+	{
+		// FNV-1a of the full path, so sources with the same name in different directories get their own files
+		std::error_code error;
+		std::filesystem::path source = std::filesystem::absolute(sourcePath, error);
+		if (error) { source = sourcePath; }
+		uint64_t hash = 14695981039346656037ull;
+		for (char c : source.generic_string())
+		{
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 1099511628211ull;
+		}
+		std::ostringstream name;
+		name << source.filename().string() << "." << std::hex << std::setw(16) << std::setfill('0') << hash << ".meshcache";
+		return (std::filesystem::path(cacheDirectory) / name.str()).string();
+	}
+
+	bool writeMeshCache(const std::string& sourcePath, const MeshLoadOptions& options, const Primitive::MeshBuilder& mesh)
+	{
+		MeshCacheHeader header{};
+		std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+		header.version = MESH_CACHE_VERSION;
+		if (!getSourceStamp(sourcePath, header.sourceSize, header.sourceWriteTime)) { return false; }
+		header.options = getCacheOptionBits(options);
+		header.vertexSize = sizeof(Primitive::Vertex);
+		header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+		header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+		header.submeshCount = static_cast<uint32_t>(mesh.submeshes.size());
+		header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+		header.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+		glm::vec3 boundsMin, boundsMax;
+		computeBounds(mesh.vertices, boundsMin, boundsMax);
+		for (int k = 0; k < 3; k++)
+		{
+			header.boundsMin[k] = boundsMin[k];
+			header.boundsMax[k] = boundsMax[k];
+		}
+
+		// assembled in memory and written under a temporary name, so a crash never leaves a truncated cache behind
+		const MeshCacheLayout layout = getCacheLayout(mesh.vertices.size(), mesh.indices.size(), mesh.submeshes.size(), mesh.lods.size(), mesh.meshlets.size());
+		std::vector<char> data(layout.fileSize, 0);
+		std::memcpy(data.data(), &header, sizeof(header));
+		if (!mesh.submeshes.empty()) { std::memcpy(data.data() + layout.submeshOffset, mesh.submeshes.data(), mesh.submeshes.size() * sizeof(Primitive::Submesh)); }
+		if (!mesh.lods.empty()) { std::memcpy(data.data() + layout.lodOffset, mesh.lods.data(), mesh.lods.size() * sizeof(Primitive::Lod)); }
+		if (!mesh.meshlets.empty()) { std::memcpy(data.data() + layout.meshletOffset, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Primitive::Meshlet)); }
+		if (!mesh.vertices.empty()) { std::memcpy(data.data() + layout.vertexOffset, mesh.vertices.data(), mesh.vertices.size() * sizeof(Primitive::Vertex)); }
+		if (!mesh.indices.empty()) { std::memcpy(data.data() + layout.indexOffset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t)); }
+
+		if (options.cacheDirectory.empty()) { return false; }
+		std::error_code error;
+		std::filesystem::create_directories(options.cacheDirectory, error);
+		if (error) { return false; }
+		const std::string cachePath = getMeshCachePath(sourcePath, options.cacheDirectory);
+		const std::string temporaryPath = cachePath + ".tmp";
+		{
+			std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+			out.write(data.data(), static_cast<std::streamsize>(data.size()));
+			if (!out)
+			{
+				out.close();
+				std::filesystem::remove(temporaryPath, error);
+				return false;
+			}
+		}
+		std::filesystem::rename(temporaryPath, cachePath, error);
+		if (error)
+		{
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	bool MeshCache::open(const std::string& sourcePath, const MeshLoadOptions& options)
+	{
+		file.close();
+		imported = Primitive::MeshBuilder{};
+		glb.reset();
+		view = Primitive::MeshView{};
+		writeFailed = false;
+		if (options.cacheDirectory.empty()) { return false; }
+
+		uint64_t sourceSize = 0;
+		int64_t sourceWriteTime = 0;
+		if (!getSourceStamp(sourcePath, sourceSize, sourceWriteTime)) { return false; }
+		if (!file.open(getMeshCachePath(sourcePath, options.cacheDirectory))) { return false; }
+
+		const char* data = file.view().data();
+		MeshCacheHeader header;
+		bool valid = file.size() >= sizeof(header);
+		if (valid)
+		{
+			std::memcpy(&header, data, sizeof(header));
+			valid = std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) == 0 && header.version == MESH_CACHE_VERSION
+				&& header.vertexSize == sizeof(Primitive::Vertex) && header.options == getCacheOptionBits(options)
+				&& header.sourceSize == sourceSize && header.sourceWriteTime == sourceWriteTime;
+		}
+		const MeshCacheLayout layout = valid ? getCacheLayout(header.vertexCount, header.indexCount, header.submeshCount, header.lodCount, header.meshletCount)
+			: MeshCacheLayout{};
+		if (!valid || layout.fileSize != file.size())
+		{
+			file.close();
+			return false;
+		}
+
+		// the sections are aligned within the file, and the file itself is page aligned when mapped
+		view.submeshes = { reinterpret_cast<const Primitive::Submesh*>(data + layout.submeshOffset), header.submeshCount };
+		view.lods = { reinterpret_cast<const Primitive::Lod*>(data + layout.lodOffset), header.lodCount };
+		view.meshlets = { reinterpret_cast<const Primitive::Meshlet*>(data + layout.meshletOffset), header.meshletCount };
+		view.vertices = { reinterpret_cast<const Primitive::Vertex*>(data + layout.vertexOffset), header.vertexCount };
+		view.indices = { reinterpret_cast<const uint32_t*>(data + layout.indexOffset), header.indexCount };
+		boundsMin = { header.boundsMin[0], header.boundsMin[1], header.boundsMin[2] };
+		boundsMax = { header.boundsMax[0], header.boundsMax[1], header.boundsMax[2] };
+		return true;
+	}
+
+	void MeshCache::load(const std::string& sourcePath, const MeshLoadOptions& options)
+	{
+		if (isGlbPath(sourcePath))
+		{
+			// already binary, vertices in the engine layout are uploaded straight from the mapping
+			file.close();
+			imported = Primitive::MeshBuilder{};
+			writeFailed = false;
+			glb = std::make_unique<GlbImporter>();
+			glb->load(sourcePath);
+			if (glb->getSkippedPrimitiveCount())
+			{
+				std::cout << "mesh " << sourcePath << ": skipped " << glb->getSkippedPrimitiveCount() << " primitives of points or lines" << std::endl;
+			}
+			view = glb->getView();
+			if (!options.weldVertices)
+			{
+				// one vertex per face corner, as imported OBJ meshes without welding
+				imported.vertices.reserve(view.indices.size());
+				for (uint32_t index : view.indices) { imported.vertices.push_back(view.vertices[index]); }
+				view = imported.getView();
+			}
+			else if (!view.indices.empty() && (options.optimize || options.generateLods || options.buildMeshlets))
+			{
+				// the vertices stay mapped (in file order), only the indices are reordered and extended by the levels
+				imported.indices.assign(view.indices.begin(), view.indices.end());
+				if (options.optimize)
+				{
+					const MeshOptimizeStats stats = optimizeMeshIndices(view.vertices, imported.indices, view.submeshes);
+					if (options.printStats)
+					{
+						std::cout << "mesh " << sourcePath << ": " << view.vertices.size() << " vertices, " << imported.indices.size() / 3 << " triangles, ACMR "
+							<< stats.before.acmr << " -> " << stats.after.acmr << ", ATVR " << stats.before.atvr << " -> " << stats.after.atvr << std::endl;
+					}
+				}
+				if (options.generateLods) { generateMeshLods(view.vertices, imported.indices, imported.lods); }
+				if (options.buildMeshlets) { buildMeshlets(view.vertices, imported.indices, view.submeshes, imported.lods, imported.meshlets); }
+				view.indices = imported.indices;
+				view.lods = imported.lods;
+				view.meshlets = imported.meshlets;
+			}
+			computeBounds(view.vertices, boundsMin, boundsMax);
+			return;
+		}
+		if (open(sourcePath, options)) { return; }
+
+		file.close();
+		MeshLoadOptions importOptions = options;
+		importOptions.cacheDirectory.clear(); // the cache was just found out of date (or caching is off), it is written below
+		imported.loadFromFile(sourcePath, importOptions);
+		writeFailed = !options.cacheDirectory.empty() && !writeMeshCache(sourcePath, options, imported);
+		view = imported.getView();
+		computeBounds(imported.vertices, boundsMin, boundsMax);
+	}
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Core/Primitive.h"
+#include "Core/Mesh/GlbImporter.h"
+#include "Core/Dependencies/json-rpg/MappedFile.h"
+
+#include <memory>
+#include <string>
+
+namespace EngineCore
+{
+	/* engine-native binary mesh, the final vertex and index streams of an imported mesh as they are uploaded
+	written to MeshLoadOptions::cacheDirectory the first time the source is imported, later runs map it instead of parsing
+	nothing is written next to the assets, the directory is created when needed and caching is off unless one is given
+	the cache is stamped with the size and write time of the source and the load options, it is rewritten when any of them change
+	the layout is the machine's own (endianness, Primitive::Vertex), a cache from elsewhere is simply treated as out of date */
+	struct MeshCacheHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceSize;
+		int64_t sourceWriteTime; // ticks of std::filesystem::file_time_type
+		uint32_t options; // the MeshLoadOptions that change the result
+		uint32_t vertexSize; // sizeof(Primitive::Vertex) when written
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t submeshCount;
+		uint32_t lodCount;
+		uint32_t meshletCount;
+		float boundsMin[3];
+		float boundsMax[3];
+		// followed by the submeshes, LODs, meshlets, vertices and indices, each starting at a multiple of 16 bytes
+	};
+
+	// a directory under the system's temporary directory, for callers that have no writable location of their own
+	std::string getDefaultMeshCacheDirectory();
+	// the cache file of a source in cacheDirectory, named after the source file and a hash of its full path
+	std::string getMeshCachePath(const std::string& sourcePath, const std::string& cacheDirectory);
+
+	// returns false if the cache could not be written (e.g. a read-only directory), the mesh is still usable
+	bool writeMeshCache(const std::string& sourcePath, const MeshLoadOptions& options, const Primitive::MeshBuilder& mesh);
+
+	class MeshCache
+	{
+	public:
+		MeshCache() = default;
+		MeshCache(const MeshCache&) = delete;
+		MeshCache& operator=(const MeshCache&) = delete;
+
+		// maps the cache of the source file, returns false if it is missing or out of date (or options.cacheDirectory is empty)
+		bool open(const std::string& sourcePath, const MeshLoadOptions& options = MeshLoadOptions{});
+		/* like open(), but imports the source file if its cache is not up to date, which writes a new cache (see hasWriteFailed)
+		GLB files are never cached, they are mapped (see GlbImporter) and the options applied to the indices only, the vertices stay in file order
+		so they can be uploaded from the mapping. without weldVertices the vertices are expanded to one per face corner instead
+		MeshBuilder::loadFromFile loads GLB files through here, the result is the same from both
+		throws if the source cannot be loaded */
+		void load(const std::string& sourcePath, const MeshLoadOptions& options = MeshLoadOptions{});
+
+		// valid while the cache is open, e.g. for constructing a Primitive
+		const Primitive::MeshView& getView() const { return view; }
+		glm::vec3 getBoundsMin() const { return boundsMin; }
+		glm::vec3 getBoundsMax() const { return boundsMax; }
+		bool isMapped() const { return file.isMapped(); } // false if imported (GLB included), or if the cache was read into memory
+		bool hasWriteFailed() const { return writeFailed; } // true if the last load() imported the source but could not write its cache
+
+	private:
+		JSON::MappedFile file;
+		Primitive::MeshBuilder imported; // holds the streams when the cache was out of date
+		std::unique_ptr<GlbImporter> glb; // holds the mapped file (or the converted streams) of GLB sources
+		Primitive::MeshView view{};
+		glm::vec3 boundsMin{ 0.f };
+		glm::vec3 boundsMax{ 0.f };
+		bool writeFailed = false;
+	};
+
+}
@@ -0,0 +1,295 @@
+#include "Core/Mesh/MeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace EngineCore
+{
+	/* FIFO cache simulated with time stamps, a vertex is cached if fewer than cacheSize misses happened since it was loaded
+	returns the number of misses of the triangle */
+	static uint32_t simulateTriangle(const uint32_t* triangle, uint32_t cacheSize, std::vector<uint32_t>& timestamps, uint32_t& time)
+	{
+		uint32_t misses = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			const uint32_t v = triangle[k];
+			if (time - timestamps[v] > cacheSize)
+			{
+				timestamps[v] = time++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+
+	VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		VertexCacheStats stats{};
+		const size_t triangleCount = indices.size() / 3;
+		if (!triangleCount) { return stats; }
+
+		std::vector<uint32_t> timestamps(vertexCount, 0);
+		std::vector<bool> used(vertexCount, false);
+		uint32_t time = cacheSize + 1;
+		size_t misses = 0, usedCount = 0;
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			misses += simulateTriangle(&indices[t * 3], cacheSize, timestamps, time);
+			for (int k = 0; k < 3; k++)
+			{
+				if (!used[indices[t * 3 + k]]) { used[indices[t * 3 + k]] = true; usedCount++; }
+			}
+		}
+		stats.acmr = static_cast<float>(misses) / static_cast<float>(triangleCount);
+		stats.atvr = static_cast<float>(misses) / static_cast<float>(usedCount);
+		return stats;
+	}
+
+	std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		const size_t triangleCount = indices.size() / 3;
+		// vertex to triangle adjacency, triangles of vertex v are adjacency[offsets[v]] up to offsets[v + 1]
+		std::vector<uint32_t> liveCounts(vertexCount, 0);
+		for (uint32_t v : indices) { liveCounts[v]++; }
+		std::vector<uint32_t> offsets(vertexCount + 1, 0);
+		std::partial_sum(liveCounts.begin(), liveCounts.end(), offsets.begin() + 1);
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++) { adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3); }
+
+		std::vector<uint32_t> timestamps(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> deadEnds; // vertices of emitted triangles, most recent last
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+
+		uint32_t time = cacheSize + 1;
+		size_t cursor = 0; // sweeps the vertices once, for restarting when the dead-end stack runs dry
+		int64_t fanVertex = vertexCount ? 0 : -1;
+		while (fanVertex >= 0)
+		{
+			// emit all remaining triangles around the fanning vertex
+			candidates.clear();
+			const auto f = static_cast<uint32_t>(fanVertex);
+			for (uint32_t a = offsets[f]; a < offsets[f + 1]; a++)
+			{
+				const uint32_t t = adjacency[a];
+				if (emitted[t]) { continue; }
+				for (int k = 0; k < 3; k++)
+				{
+					const uint32_t v = indices[t * 3 + k];
+					result.push_back(v);
+					deadEnds.push_back(v);
+					candidates.push_back(v);
+					liveCounts[v]--;
+					if (time - timestamps[v] > cacheSize) { timestamps[v] = time++; }
+				}
+				emitted[t] = true;
+			}
+
+			// next fan around the candidate that stays longest in the cache even after its own fan is emitted
+			fanVertex = -1;
+			int64_t bestPriority = -1;
+			for (uint32_t v : candidates)
+			{
+				if (!liveCounts[v]) { continue; }
+				int64_t priority = 0;
+				if (time - timestamps[v] + 2 * liveCounts[v] <= cacheSize) { priority = time - timestamps[v]; }
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					fanVertex = v;
+				}
+			}
+			if (fanVertex >= 0) { continue; }
+
+			// dead end, continue from a recently used vertex or else the next unfinished one in input order
+			while (!deadEnds.empty() && fanVertex < 0)
+			{
+				const uint32_t v = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveCounts[v]) { fanVertex = v; }
+			}
+			while (fanVertex < 0 && cursor < vertexCount)
+			{
+				if (liveCounts[cursor]) { fanVertex = static_cast<int64_t>(cursor); }
+				cursor++;
+			}
+		}
+		return result;
+	}
+
+	std::vector<uint32_t> sortClustersForOverdraw(std::span<const uint32_t> indices, std::span<const Primitive::Vertex> vertices,
+		const std::vector<uint32_t>& clusters)
+	{
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		// clusters facing away from the mesh center are drawn first, they are the likeliest to occlude the rest
+		glm::vec3 meshCenter{ 0.f };
+		float meshArea = 0.f;
+		std::vector<float> sortKeys(clusters.size());
+		std::vector<glm::vec3> clusterCenters(clusters.size());
+		std::vector<glm::vec3> clusterNormals(clusters.size());
+		for (size_t c = 0; c < clusters.size(); c++)
+		{
+			const uint32_t end = (c + 1 < clusters.size()) ? clusters[c + 1] : triangleCount;
+			glm::vec3 center{ 0.f }, normal{ 0.f };
+			float area = 0.f;
+			for (uint32_t t = clusters[c]; t < end; t++)
+			{
+				const glm::vec3& a = vertices[indices[t * 3]].position;
+				const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+				const glm::vec3& d = vertices[indices[t * 3 + 2]].position;
+				const glm::vec3 n = glm::cross(b - a, d - a); // length is twice the area
+				const float triangleArea = glm::length(n);
+				center += (a + b + d) * (triangleArea / 3.f);
+				normal += n;
+				area += triangleArea;
+			}
+			meshCenter += center;
+			meshArea += area;
+			clusterCenters[c] = (area > 0.f) ? center / area : center;
+			const float normalLength = glm::length(normal);
+			clusterNormals[c] = (normalLength > 0.f) ? normal / normalLength : normal;
+		}
+		if (meshArea > 0.f) { meshCenter /= meshArea; }
+		for (size_t c = 0; c < clusters.size(); c++) { sortKeys[c] = glm::dot(clusterCenters[c] - meshCenter, clusterNormals[c]); }
+
+		std::vector<uint32_t> order(clusters.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+		return order;
+	}
+
+	std::vector<uint32_t> optimizeOverdraw(const std::vector<uint32_t>& indices, std::span<const Primitive::Vertex> vertices,
+		uint32_t cacheSize, float threshold)
+	{
+		const size_t triangleCount = indices.size() / 3;
+		if (!triangleCount) { return indices; }
+		std::vector<uint32_t> timestamps(vertices.size(), 0);
+		uint32_t time = cacheSize + 1;
+		const auto flushCache = [&]() { time += cacheSize + 1; };
+
+		// hard boundaries, where a triangle misses on all its vertices the cache order starts a new patch anyway
+		std::vector<uint32_t> hardClusters;
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			if (simulateTriangle(&indices[t * 3], cacheSize, timestamps, time) == 3 || !t) { hardClusters.push_back(static_cast<uint32_t>(t)); }
+		}
+
+		// soft boundaries, patches are split wherever the miss ratio so far is within threshold of the whole patch's
+		std::vector<uint32_t> clusters;
+		for (size_t c = 0; c < hardClusters.size(); c++)
+		{
+			const uint32_t begin = hardClusters[c];
+			const uint32_t end = (c + 1 < hardClusters.size()) ? hardClusters[c + 1] : static_cast<uint32_t>(triangleCount);
+			flushCache();
+			uint32_t patchMisses = 0;
+			for (uint32_t t = begin; t < end; t++) { patchMisses += simulateTriangle(&indices[t * 3], cacheSize, timestamps, time); }
+			const float target = threshold * static_cast<float>(patchMisses) / static_cast<float>(end - begin);
+
+			clusters.push_back(begin);
+			flushCache();
+			uint32_t misses = 0, triangles = 0;
+			for (uint32_t t = begin; t < end; t++)
+			{
+				misses += simulateTriangle(&indices[t * 3], cacheSize, timestamps, time);
+				triangles++;
+				if (t + 1 < end && static_cast<float>(misses) <= target * static_cast<float>(triangles))
+				{
+					clusters.push_back(t + 1);
+					flushCache();
+					misses = triangles = 0;
+				}
+			}
+		}
+
+		const std::vector<uint32_t> order = sortClustersForOverdraw(indices, vertices, clusters);
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		for (uint32_t c : order)
+		{
+			const uint32_t end = (c + 1 < clusters.size()) ? clusters[c + 1] : static_cast<uint32_t>(triangleCount);
+			result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+		}
+		return result;
+	}
+
+	void optimizeVertexFetch(Primitive::MeshBuilder& mesh)
+	{
+		constexpr uint32_t UNUSED = UINT32_MAX;
+		std::vector<uint32_t> remap(mesh.vertices.size(), UNUSED);
+		std::vector<Primitive::Vertex> vertices;
+		vertices.reserve(mesh.vertices.size());
+		for (uint32_t& index : mesh.indices)
+		{
+			if (remap[index] == UNUSED)
+			{
+				remap[index] = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(mesh.vertices[index]);
+			}
+			index = remap[index];
+		}
+		mesh.vertices = std::move(vertices);
+	}
+
+	MeshOptimizeStats optimizeMeshIndices(std::span<const Primitive::Vertex> vertices, std::vector<uint32_t>& indices,
+		std::span<const Primitive::Submesh> submeshes, const MeshOptimizeOptions& options)
+	{
+		MeshOptimizeStats stats{};
+		if (indices.empty() || indices.size() % 3) { return stats; }
+		stats.before = analyzeVertexCache(indices, vertices.size(), options.cacheSize);
+
+		if (submeshes.size() <= 1)
+		{
+			indices = optimizeVertexCache(indices, vertices.size(), options.cacheSize);
+			indices = optimizeOverdraw(indices, vertices, options.cacheSize, options.overdrawThreshold);
+		}
+		else
+		{
+			// triangles are reordered within their submesh, on local copies indexing only the submesh's own vertices
+			constexpr uint32_t UNUSED = UINT32_MAX;
+			std::vector<uint32_t> localOf(vertices.size(), UNUSED);
+			for (const Primitive::Submesh& submesh : submeshes)
+			{
+				const auto first = indices.begin() + submesh.firstIndex;
+				std::vector<uint32_t> globalOf;
+				std::vector<Primitive::Vertex> localVertices;
+				std::vector<uint32_t> localIndices(submesh.indexCount);
+				for (uint32_t i = 0; i < submesh.indexCount; i++)
+				{
+					const uint32_t v = first[i];
+					if (localOf[v] == UNUSED)
+					{
+						localOf[v] = static_cast<uint32_t>(globalOf.size());
+						globalOf.push_back(v);
+						localVertices.push_back(vertices[v]);
+					}
+					localIndices[i] = localOf[v];
+				}
+				if (submesh.indexCount % 3 == 0)
+				{
+					localIndices = optimizeVertexCache(localIndices, localVertices.size(), options.cacheSize);
+					localIndices = optimizeOverdraw(localIndices, localVertices, options.cacheSize, options.overdrawThreshold);
+				}
+				for (uint32_t i = 0; i < submesh.indexCount; i++) { first[i] = globalOf[localIndices[i]]; }
+				for (uint32_t v : globalOf) { localOf[v] = UNUSED; }
+			}
+		}
+
+		stats.after = analyzeVertexCache(indices, vertices.size(), options.cacheSize);
+		return stats;
+	}
+
+	MeshOptimizeStats optimizeMesh(Primitive::MeshBuilder& mesh, const MeshOptimizeOptions& options)
+	{
+		if (mesh.indices.empty() || mesh.indices.size() % 3) { return MeshOptimizeStats{}; }
+		MeshOptimizeStats stats = optimizeMeshIndices(mesh.vertices, mesh.indices, mesh.submeshes, options);
+		optimizeVertexFetch(mesh);
+
+		stats.after = analyzeVertexCache(mesh.indices, mesh.vertices.size(), options.cacheSize);
+		return stats;
+	}
+
+}
@@ -0,0 +1,317 @@
+#include "Core/Mesh/MeshSimplifier.h"
+#include "Core/Mesh/MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace EngineCore
+{
+	static constexpr double BORDER_PLANE_WEIGHT = 10.0; // keeps open borders in shape, relative to the faces' area weight
+	static constexpr float MAX_NORMAL_ROTATION_COS = 0.5f; // collapses turning a triangle by 60 degrees or more are rejected, they tend to fold the surface
+
+	// symmetric matrix of a set of planes, for the weighted sum of squared distances of a point to them
+	struct Quadric
+	{
+		double a00 = 0.0, a11 = 0.0, a22 = 0.0, a01 = 0.0, a02 = 0.0, a12 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+		double c = 0.0;
+		double weight = 0.0;
+	};
+
+	// points p with dot(normal, p) + distance = 0, normal of unit length
+	static Quadric makePlaneQuadric(const glm::vec3& normal, float distance, double weight)
+	{
+		const double x = normal.x, y = normal.y, z = normal.z, d = distance;
+		Quadric q;
+		q.a00 = weight * x * x; q.a11 = weight * y * y; q.a22 = weight * z * z;
+		q.a01 = weight * x * y; q.a02 = weight * x * z; q.a12 = weight * y * z;
+		q.b0 = weight * x * d; q.b1 = weight * y * d; q.b2 = weight * z * d;
+		q.c = weight * d * d;
+		q.weight = weight;
+		return q;
+	}
+
+	static void addQuadric(Quadric& q, const Quadric& other)
+	{
+		q.a00 += other.a00; q.a11 += other.a11; q.a22 += other.a22;
+		q.a01 += other.a01; q.a02 += other.a02; q.a12 += other.a12;
+		q.b0 += other.b0; q.b1 += other.b1; q.b2 += other.b2;
+		q.c += other.c;
+		q.weight += other.weight;
+	}
+
+	// weighted mean of the squared distances to the planes
+	static double evaluateQuadric(const Quadric& q, const glm::vec3& p)
+	{
+		if (q.weight <= 0.0) { return 0.0; }
+		const double x = p.x, y = p.y, z = p.z;
+		const double r = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z + 2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z)
+			+ 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+		return std::fabs(r) / q.weight;
+	}
+
+	enum class SimplifyVertexKind : uint8_t
+	{
+		Manifold, // interior vertex, collapses along any edge
+		Border, // on an open border, collapses along it
+		Locked // seam, border corner or non-manifold, stays in place
+	};
+
+	static uint64_t makeEdgeKey(uint32_t a, uint32_t b)
+	{
+		return (a < b) ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+	}
+
+	// border edges are used by one triangle only
+	static bool isBorderEdge(const std::vector<uint64_t>& sortedEdges, uint32_t a, uint32_t b)
+	{
+		const uint64_t key = makeEdgeKey(a, b);
+		const auto first = std::lower_bound(sortedEdges.begin(), sortedEdges.end(), key);
+		return first != sortedEdges.end() && *first == key && (first + 1 == sortedEdges.end() || first[1] != key);
+	}
+
+	// edges of all triangles (sorted, once per triangle using them) and the kind of every vertex
+	static void analyzeTopology(const std::vector<uint32_t>& indices, const std::vector<bool>& seams, std::vector<uint64_t>& edgesOut,
+		std::vector<SimplifyVertexKind>& kindsOut)
+	{
+		edgesOut.clear();
+		edgesOut.reserve(indices.size());
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			edgesOut.push_back(makeEdgeKey(indices[i], indices[i + 1]));
+			edgesOut.push_back(makeEdgeKey(indices[i + 1], indices[i + 2]));
+			edgesOut.push_back(makeEdgeKey(indices[i + 2], indices[i]));
+		}
+		std::sort(edgesOut.begin(), edgesOut.end());
+
+		kindsOut.assign(seams.size(), SimplifyVertexKind::Manifold);
+		std::vector<uint8_t> borderEdges(seams.size(), 0);
+		for (size_t e = 0; e < edgesOut.size();)
+		{
+			size_t end = e + 1;
+			while (end < edgesOut.size() && edgesOut[end] == edgesOut[e]) { end++; }
+			const auto a = static_cast<uint32_t>(edgesOut[e] >> 32);
+			const auto b = static_cast<uint32_t>(edgesOut[e]);
+			if (end - e == 1)
+			{
+				borderEdges[a] = static_cast<uint8_t>(std::min(borderEdges[a] + 1, 255));
+				borderEdges[b] = static_cast<uint8_t>(std::min(borderEdges[b] + 1, 255));
+			}
+			else if (end - e > 2)
+			{
+				kindsOut[a] = kindsOut[b] = SimplifyVertexKind::Locked;
+			}
+			e = end;
+		}
+		for (size_t v = 0; v < seams.size(); v++)
+		{
+			if (seams[v]) { kindsOut[v] = SimplifyVertexKind::Locked; }
+			else if (kindsOut[v] == SimplifyVertexKind::Manifold && borderEdges[v])
+			{
+				// a vertex where borders meet (or end) is a corner of the outline
+				kindsOut[v] = (borderEdges[v] == 2) ? SimplifyVertexKind::Border : SimplifyVertexKind::Locked;
+			}
+		}
+	}
+
+	// vertices sharing their position with another vertex, i.e. on a normal or uv seam
+	static std::vector<bool> findSeamVertices(std::span<const Primitive::Vertex> vertices)
+	{
+		std::vector<uint32_t> order(vertices.size());
+		std::iota(order.begin(), order.end(), 0);
+		const auto less = [&](uint32_t a, uint32_t b)
+		{
+			const glm::vec3& p = vertices[a].position;
+			const glm::vec3& q = vertices[b].position;
+			return (p.x != q.x) ? p.x < q.x : (p.y != q.y) ? p.y < q.y : p.z < q.z;
+		};
+		std::sort(order.begin(), order.end(), less);
+
+		std::vector<bool> seams(vertices.size(), false);
+		for (size_t i = 1; i < order.size(); i++)
+		{
+			if (vertices[order[i]].position == vertices[order[i - 1]].position) { seams[order[i]] = seams[order[i - 1]] = true; }
+		}
+		return seams;
+	}
+
+	static float getMeshRadius(std::span<const Primitive::Vertex> vertices)
+	{
+		glm::vec3 extent{ 0.f };
+		for (const auto& v : vertices) { extent = glm::max(extent, glm::abs(v.position)); }
+		return glm::length(extent);
+	}
+
+	std::vector<uint32_t> simplifyMesh(std::span<const uint32_t> indices, std::span<const Primitive::Vertex> vertices,
+		size_t targetIndexCount, float maxError, float& errorOut)
+	{
+		errorOut = 0.f;
+		std::vector<uint32_t> result(indices.begin(), indices.end());
+		const float radius = getMeshRadius(vertices);
+		if (result.size() % 3 || result.size() <= targetIndexCount || radius <= 0.f) { return result; }
+
+		const std::vector<bool> seams = findSeamVertices(vertices);
+		std::vector<uint64_t> edges;
+		std::vector<SimplifyVertexKind> kinds;
+		analyzeTopology(result, seams, edges, kinds);
+
+		// quadrics of the planes of the faces around each vertex, and of planes standing on open borders
+		std::vector<Quadric> quadrics(vertices.size());
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			const uint32_t corners[3] = { result[i], result[i + 1], result[i + 2] };
+			const glm::vec3& a = vertices[corners[0]].position;
+			glm::vec3 normal = glm::cross(vertices[corners[1]].position - a, vertices[corners[2]].position - a);
+			const float doubleArea = glm::length(normal);
+			if (doubleArea <= 0.f) { continue; }
+			normal /= doubleArea;
+			const Quadric face = makePlaneQuadric(normal, -glm::dot(normal, a), 0.5 * doubleArea);
+			for (uint32_t v : corners) { addQuadric(quadrics[v], face); }
+
+			for (int k = 0; k < 3; k++)
+			{
+				const uint32_t from = corners[k], to = corners[(k + 1) % 3];
+				if (!isBorderEdge(edges, from, to)) { continue; }
+				const glm::vec3 edge = vertices[to].position - vertices[from].position;
+				const glm::vec3 borderNormal = glm::cross(edge, normal);
+				const float length = glm::length(borderNormal);
+				if (length <= 0.f) { continue; }
+				const Quadric border = makePlaneQuadric(borderNormal / length, -glm::dot(borderNormal / length, vertices[from].position),
+					BORDER_PLANE_WEIGHT * glm::dot(edge, edge));
+				addQuadric(quadrics[from], border);
+				addQuadric(quadrics[to], border);
+			}
+		}
+
+		struct Collapse
+		{
+			double cost;
+			uint32_t from, to;
+		};
+		std::vector<Collapse> collapses;
+		std::vector<uint32_t> remap(vertices.size());
+		std::iota(remap.begin(), remap.end(), 0);
+		std::vector<uint32_t> offsets(vertices.size() + 1), adjacency;
+		std::vector<bool> touched(vertices.size());
+		const double maxCost = static_cast<double>(maxError) * maxError * radius * radius;
+		double largestCost = 0.0;
+
+		// each pass collapses the cheapest edges not touching each other, until the target or the error limit is reached
+		while (result.size() > targetIndexCount)
+		{
+			collapses.clear();
+			for (size_t e = 0; e < edges.size(); e++)
+			{
+				if (e > 0 && edges[e] == edges[e - 1]) { continue; }
+				const bool border = e + 1 == edges.size() || edges[e + 1] != edges[e];
+				const auto a = static_cast<uint32_t>(edges[e] >> 32);
+				const auto b = static_cast<uint32_t>(edges[e]);
+				const auto canMove = [&](uint32_t v)
+				{
+					return kinds[v] == SimplifyVertexKind::Manifold || (kinds[v] == SimplifyVertexKind::Border && border);
+				};
+				if (canMove(a)) { collapses.push_back(Collapse{ evaluateQuadric(quadrics[a], vertices[b].position), a, b }); }
+				if (canMove(b)) { collapses.push_back(Collapse{ evaluateQuadric(quadrics[b], vertices[a].position), b, a }); }
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+			// triangles around each vertex, for checking the triangles a collapse changes
+			std::fill(offsets.begin(), offsets.end(), 0);
+			for (uint32_t v : result) { offsets[v + 1]++; }
+			std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+			adjacency.resize(result.size());
+			std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < result.size(); i++) { adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3); }
+
+			std::fill(touched.begin(), touched.end(), false);
+			const size_t triangleCount = result.size() / 3;
+			const size_t targetTriangles = targetIndexCount / 3;
+			size_t removedTriangles = 0, performed = 0;
+			for (const Collapse& collapse : collapses)
+			{
+				if (collapse.cost > maxCost || triangleCount - removedTriangles <= targetTriangles) { break; }
+				if (touched[collapse.from] || touched[collapse.to]) { continue; }
+
+				// triangles keeping both ends would have to stay front facing, those holding the edge disappear
+				const glm::vec3& from = vertices[collapse.from].position;
+				const glm::vec3& to = vertices[collapse.to].position;
+				size_t removed = 0;
+				bool flips = false;
+				for (uint32_t a = offsets[collapse.from]; a < offsets[collapse.from + 1] && !flips; a++)
+				{
+					const uint32_t* triangle = &result[adjacency[a] * 3];
+					if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+					{
+						removed++;
+						continue;
+					}
+					const int k = (triangle[0] == collapse.from) ? 0 : (triangle[1] == collapse.from) ? 1 : 2;
+					const glm::vec3& b = vertices[triangle[(k + 1) % 3]].position;
+					const glm::vec3& c = vertices[triangle[(k + 2) % 3]].position;
+					const glm::vec3 before = glm::cross(b - from, c - from);
+					const glm::vec3 after = glm::cross(b - to, c - to);
+					flips = glm::dot(before, after) <= MAX_NORMAL_ROTATION_COS * glm::length(before) * glm::length(after);
+				}
+				if (flips) { continue; }
+
+				remap[collapse.from] = collapse.to;
+				addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+				// every triangle changes once per pass at most, so the checks above stay exact
+				for (uint32_t a = offsets[collapse.from]; a < offsets[collapse.from + 1]; a++)
+				{
+					const uint32_t* triangle = &result[adjacency[a] * 3];
+					touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+				}
+				largestCost = std::max(largestCost, collapse.cost);
+				removedTriangles += removed;
+				performed++;
+			}
+			if (!performed) { break; }
+
+			size_t write = 0;
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				const uint32_t a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+				if (a == b || b == c || c == a) { continue; }
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+			result.resize(write);
+			analyzeTopology(result, seams, edges, kinds);
+		}
+
+		errorOut = static_cast<float>(std::sqrt(largestCost)) / radius;
+		return result;
+	}
+
+	void generateMeshLods(std::span<const Primitive::Vertex> vertices, std::vector<uint32_t>& indices, std::vector<Primitive::Lod>& lodsOut,
+		const MeshLodOptions& options)
+	{
+		lodsOut.clear();
+		if (indices.empty() || indices.size() % 3) { return; }
+		lodsOut.push_back(Primitive::Lod{ 0, static_cast<uint32_t>(indices.size()), 0.f });
+
+		std::vector<uint32_t> level(indices.begin(), indices.end());
+		float error = 0.f;
+		while (lodsOut.size() < options.maxLevels)
+		{
+			const size_t targetTriangles = static_cast<size_t>(static_cast<float>(level.size() / 3) * options.reduction);
+			if (targetTriangles < options.minTriangles) { break; }
+			float levelError = 0.f;
+			std::vector<uint32_t> simplified = simplifyMesh(level, vertices, targetTriangles * 3, options.maxError, levelError);
+			// a level barely smaller than the one before is not worth its memory, the mesh is as simple as the limits allow
+			if (simplified.size() * 10 > level.size() * 9) { break; }
+
+			// errors of the steps add up at most, each level is simplified from the one before
+			error += levelError;
+			simplified = optimizeVertexCache(simplified, vertices.size(), MeshOptimizeOptions{}.cacheSize);
+			lodsOut.push_back(Primitive::Lod{ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), error });
+			indices.insert(indices.end(), simplified.begin(), simplified.end());
+			level = std::move(simplified);
+		}
+		if (lodsOut.size() == 1) { lodsOut.clear(); }
+	}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Core/Primitive.h"
+
+#include <span>
+#include <vector>
+
+namespace EngineCore
+{
+	// how generateMeshLods builds the chain of levels
+	struct MeshLodOptions
+	{
+		uint32_t maxLevels = 5; // including the full mesh
+		float reduction = 0.5f; // triangle count of each level relative to the one before
+		float maxError = 0.1f; // largest error of one simplification step, relative to the radius of the mesh bounds
+		size_t minTriangles = 64; // levels would be smaller than this are not generated
+	};
+
+	/* quadric error metric edge collapse (Garland & Heckbert), vertices are collapsed onto one of their neighbours
+	so the result indexes the same vertices as the input and shares its vertex buffer
+	vertices on attribute seams (another vertex at the same position) and on non-manifold edges stay in place,
+	those on open borders only move along the border
+	stops at targetIndexCount, or before the first collapse of an error above maxError (relative to the radius of the mesh bounds)
+	errorOut is the largest error of a performed collapse, relative to the same radius */
+	std::vector<uint32_t> simplifyMesh(std::span<const uint32_t> indices, std::span<const Primitive::Vertex> vertices,
+		size_t targetIndexCount, float maxError, float& errorOut);
+
+	/* simplifies the mesh into a chain of levels, each from the one before, and appends their indices to the mesh's
+	lodsOut gets the full mesh as level 0 followed by the simplified levels, it is left empty if no level could be made
+	the levels are optimized for the vertex cache, submeshes are not kept apart */
+	void generateMeshLods(std::span<const Primitive::Vertex> vertices, std::vector<uint32_t>& indices, std::vector<Primitive::Lod>& lodsOut,
+		const MeshLodOptions& options = MeshLodOptions{});
+
+}
@@ -0,0 +1,292 @@
+#include "Core/Mesh/MeshletBuilder.h"
+#include "Core/Mesh/MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace EngineCore
+{
+	static constexpr float MESHLET_FACING_WEIGHT = 0.5f; // cost of a triangle facing opposite to the meshlet so far, in vertices added
+	static constexpr float MESHLET_DISTANCE_WEIGHT = 0.5f; // cost per mean edge length between a triangle and the meshlet's centroid, keeps meshlets round
+	static constexpr uint32_t MESHLET_CACHE_SIZE = 16;
+	static constexpr uint32_t UNASSIGNED = UINT32_MAX; // no meshlet, or no range vertex, yet
+
+	// unit normal, zero for degenerate triangles
+	static glm::vec3 getTriangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		const glm::vec3 n = glm::cross(b - a, c - a);
+		const float length = glm::length(n);
+		return (length > 0.f) ? n / length : glm::vec3(0.f);
+	}
+
+	Primitive::Meshlet computeMeshletBounds(std::span<const uint32_t> indices, std::span<const Primitive::Vertex> vertices)
+	{
+		Primitive::Meshlet meshlet;
+		if (indices.empty()) { return meshlet; }
+
+		glm::vec3 min(std::numeric_limits<float>::max());
+		glm::vec3 max(std::numeric_limits<float>::lowest());
+		for (uint32_t index : indices)
+		{
+			min = glm::min(min, vertices[index].position);
+			max = glm::max(max, vertices[index].position);
+		}
+		meshlet.center = (min + max) * 0.5f;
+		float radiusSquared = 0.f;
+		for (uint32_t index : indices)
+		{
+			const glm::vec3 d = vertices[index].position - meshlet.center;
+			radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+		}
+		meshlet.radius = std::sqrt(radiusSquared);
+
+		// the narrowest cone around the mean normal holding all normals, degenerate triangles face nowhere and are left out
+		glm::vec3 normalSum(0.f);
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			normalSum += getTriangleNormal(vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position);
+		}
+		const float sumLength = glm::length(normalSum);
+		if (sumLength <= 0.f) { return meshlet; }
+		const glm::vec3 axis = normalSum / sumLength;
+		float minDot = 1.f;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const glm::vec3 n = getTriangleNormal(vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position);
+			if (glm::dot(n, n) > 0.f) { minDot = std::min(minDot, glm::dot(n, axis)); }
+		}
+		// a cone wider than a half space always has a triangle facing the camera
+		if (minDot <= 0.f) { return meshlet; }
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+		return meshlet;
+	}
+
+	// state of the meshlets of one index range, vertices are numbered locally to the range
+	struct MeshletRangeBuilder
+	{
+		std::span<const Primitive::Vertex> vertices;
+		std::vector<uint32_t> used; // range vertex -> mesh vertex
+		std::vector<uint32_t> corners; // range vertex of every index
+		std::vector<uint32_t> ordered; // indices of the range, meshlet after meshlet
+
+		std::vector<uint32_t> vertexMeshlet; // last meshlet using each vertex
+		std::vector<uint32_t> vertexSlot; // position of each vertex in that meshlet
+		std::vector<uint32_t> meshletVertices; // range vertices of the current meshlet
+		std::vector<uint32_t> meshletTriangles;
+		uint32_t meshletId = 0;
+	};
+
+	// appends the current meshlet, its triangles ordered for the vertex cache
+	static void finishMeshlet(MeshletRangeBuilder& builder, uint32_t firstIndex, std::vector<Primitive::Meshlet>& meshletsOut)
+	{
+		std::vector<uint32_t> local;
+		local.reserve(builder.meshletTriangles.size() * 3);
+		for (uint32_t triangle : builder.meshletTriangles)
+		{
+			for (uint32_t corner = 0; corner < 3; corner++) { local.push_back(builder.vertexSlot[builder.corners[triangle * 3 + corner]]); }
+		}
+		const std::vector<uint32_t> reordered = optimizeVertexCache(local, builder.meshletVertices.size(), MESHLET_CACHE_SIZE);
+
+		const size_t start = builder.ordered.size();
+		for (uint32_t slot : reordered) { builder.ordered.push_back(builder.used[builder.meshletVertices[slot]]); }
+		Primitive::Meshlet meshlet = computeMeshletBounds(std::span<const uint32_t>(builder.ordered).subspan(start), builder.vertices);
+		meshlet.firstIndex = firstIndex + static_cast<uint32_t>(start);
+		meshlet.indexCount = static_cast<uint32_t>(reordered.size());
+		meshletsOut.push_back(meshlet);
+
+		builder.meshletVertices.clear();
+		builder.meshletTriangles.clear();
+		builder.meshletId++;
+	}
+
+	// reorders the meshlets of a range from firstMeshlet on (and their indices) like optimizeOverdraw orders its clusters
+	static void sortMeshletsForOverdraw(MeshletRangeBuilder& builder, uint32_t firstIndex, size_t firstMeshlet, std::vector<Primitive::Meshlet>& meshletsOut)
+	{
+		const size_t meshletCount = meshletsOut.size() - firstMeshlet;
+		if (meshletCount < 2) { return; }
+
+		std::vector<uint32_t> clusters(meshletCount);
+		for (size_t m = 0; m < meshletCount; m++) { clusters[m] = (meshletsOut[firstMeshlet + m].firstIndex - firstIndex) / 3; }
+		const std::vector<uint32_t> order = sortClustersForOverdraw(builder.ordered, builder.vertices, clusters);
+
+		std::vector<uint32_t> ordered;
+		ordered.reserve(builder.ordered.size());
+		std::vector<Primitive::Meshlet> meshlets;
+		meshlets.reserve(meshletCount);
+		for (uint32_t m : order)
+		{
+			Primitive::Meshlet meshlet = meshletsOut[firstMeshlet + m];
+			const auto first = builder.ordered.begin() + (meshlet.firstIndex - firstIndex);
+			meshlet.firstIndex = firstIndex + static_cast<uint32_t>(ordered.size());
+			ordered.insert(ordered.end(), first, first + meshlet.indexCount);
+			meshlets.push_back(meshlet);
+		}
+		builder.ordered = std::move(ordered);
+		std::copy(meshlets.begin(), meshlets.end(), meshletsOut.begin() + firstMeshlet);
+	}
+
+	// localOf maps mesh vertices to range vertices, it is all UNASSIGNED between calls
+	static void buildRangeMeshlets(std::span<const Primitive::Vertex> vertices, std::span<uint32_t> indices, uint32_t firstIndex,
+		std::vector<uint32_t>& localOf, std::vector<Primitive::Meshlet>& meshletsOut)
+	{
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (triangleCount == 0) { return; }
+
+		const size_t firstMeshlet = meshletsOut.size();
+		MeshletRangeBuilder builder;
+		builder.vertices = vertices;
+		builder.corners.resize(indices.size());
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			uint32_t& local = localOf[indices[i]];
+			if (local == UNASSIGNED)
+			{
+				local = static_cast<uint32_t>(builder.used.size());
+				builder.used.push_back(indices[i]);
+			}
+			builder.corners[i] = local;
+		}
+		for (uint32_t vertex : builder.used) { localOf[vertex] = UNASSIGNED; }
+		const size_t vertexCount = builder.used.size();
+
+		// triangles around each vertex
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (uint32_t corner : builder.corners) { adjacencyOffsets[corner + 1]++; }
+		for (size_t v = 0; v < vertexCount; v++) { adjacencyOffsets[v + 1] += adjacencyOffsets[v]; }
+		std::vector<uint32_t> adjacency(builder.corners.size());
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < builder.corners.size(); i++) { adjacency[fill[builder.corners[i]]++] = static_cast<uint32_t>(i / 3); }
+		}
+
+		std::vector<glm::vec3> normals(triangleCount);
+		std::vector<glm::vec3> centroids(triangleCount);
+		float edgeLengthSum = 0.f;
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			const glm::vec3& a = vertices[indices[t * 3]].position;
+			const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+			const glm::vec3& c = vertices[indices[t * 3 + 2]].position;
+			normals[t] = getTriangleNormal(a, b, c);
+			centroids[t] = (a + b + c) / 3.f;
+			edgeLengthSum += glm::length(b - a) + glm::length(c - b) + glm::length(a - c);
+		}
+		// distances are measured in mean edge lengths, the scale of the mesh does not matter
+		const float edgeLength = edgeLengthSum / static_cast<float>(triangleCount * 3);
+		const float distanceWeight = (edgeLength > 0.f) ? MESHLET_DISTANCE_WEIGHT / edgeLength : 0.f;
+
+		builder.ordered.reserve(indices.size());
+		builder.vertexMeshlet.assign(vertexCount, UNASSIGNED);
+		builder.vertexSlot.assign(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> candidateMeshlet(triangleCount, UNASSIGNED); // last meshlet the triangle was a candidate of
+		std::vector<uint32_t> candidates; // triangles sharing a vertex with the current meshlet
+		glm::vec3 normalSum(0.f);
+		glm::vec3 centroidSum(0.f);
+		uint32_t seed = 0;
+		uint32_t emittedCount = 0;
+		while (emittedCount < triangleCount)
+		{
+			const float facingLength = glm::length(normalSum);
+			const glm::vec3 meshletCentroid = builder.meshletTriangles.empty() ? glm::vec3(0.f) : centroidSum / static_cast<float>(builder.meshletTriangles.size());
+			uint32_t best = UNASSIGNED;
+			float bestScore = std::numeric_limits<float>::max();
+			for (size_t i = 0; i < candidates.size();)
+			{
+				const uint32_t t = candidates[i];
+				uint32_t added = 0;
+				for (uint32_t corner = 0; corner < 3; corner++) { added += builder.vertexMeshlet[builder.corners[t * 3 + corner]] != builder.meshletId; }
+				// the meshlet only grows, a triangle that does not fit now never will
+				if (emitted[t] || builder.meshletVertices.size() + added > MESHLET_MAX_VERTICES)
+				{
+					candidates[i] = candidates.back();
+					candidates.pop_back();
+					continue;
+				}
+				const float facing = (facingLength > 0.f) ? glm::dot(normals[t], normalSum) / facingLength : 1.f;
+				const float score = static_cast<float>(added) + MESHLET_FACING_WEIGHT * (1.f - facing)
+					+ distanceWeight * glm::length(centroids[t] - meshletCentroid);
+				if (score < bestScore)
+				{
+					bestScore = score;
+					best = t;
+				}
+				i++;
+			}
+			if (best == UNASSIGNED)
+			{
+				// nothing connected fits, rather than gathering far apart triangles start over elsewhere
+				if (!builder.meshletTriangles.empty())
+				{
+					finishMeshlet(builder, firstIndex, meshletsOut);
+					candidates.clear();
+					normalSum = glm::vec3(0.f);
+					centroidSum = glm::vec3(0.f);
+					continue;
+				}
+				while (emitted[seed]) { seed++; }
+				best = seed;
+			}
+
+			emitted[best] = true;
+			emittedCount++;
+			builder.meshletTriangles.push_back(best);
+			normalSum += normals[best];
+			centroidSum += centroids[best];
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				const uint32_t v = builder.corners[best * 3 + corner];
+				if (builder.vertexMeshlet[v] == builder.meshletId) { continue; }
+				builder.vertexMeshlet[v] = builder.meshletId;
+				builder.vertexSlot[v] = static_cast<uint32_t>(builder.meshletVertices.size());
+				builder.meshletVertices.push_back(v);
+				for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; a++)
+				{
+					const uint32_t t = adjacency[a];
+					if (emitted[t] || candidateMeshlet[t] == builder.meshletId) { continue; }
+					candidateMeshlet[t] = builder.meshletId;
+					candidates.push_back(t);
+				}
+			}
+			if (builder.meshletTriangles.size() == MESHLET_MAX_TRIANGLES)
+			{
+				finishMeshlet(builder, firstIndex, meshletsOut);
+				candidates.clear();
+				normalSum = glm::vec3(0.f);
+				centroidSum = glm::vec3(0.f);
+			}
+		}
+		if (!builder.meshletTriangles.empty()) { finishMeshlet(builder, firstIndex, meshletsOut); }
+		// regrouping the triangles lost the overdraw order of optimizeMesh, it is restored at meshlet granularity
+		sortMeshletsForOverdraw(builder, firstIndex, firstMeshlet, meshletsOut);
+		std::copy(builder.ordered.begin(), builder.ordered.end(), indices.begin());
+	}
+
+	void buildMeshlets(std::span<const Primitive::Vertex> vertices, std::vector<uint32_t>& indices, std::span<const Primitive::Submesh> submeshes,
+		std::span<const Primitive::Lod> lods, std::vector<Primitive::Meshlet>& meshletsOut)
+	{
+		meshletsOut.clear();
+
+		// submeshes keep their materials apart, levels share no triangles
+		std::vector<std::pair<uint32_t, uint32_t>> ranges;
+		const uint32_t fullCount = lods.empty() ? static_cast<uint32_t>(indices.size()) : lods[0].indexCount;
+		if (submeshes.empty()) { ranges.emplace_back(0, fullCount); }
+		for (const Primitive::Submesh& submesh : submeshes) { ranges.emplace_back(submesh.firstIndex, submesh.indexCount); }
+		for (size_t level = 1; level < lods.size(); level++) { ranges.emplace_back(lods[level].firstIndex, lods[level].indexCount); }
+		std::sort(ranges.begin(), ranges.end());
+		for (const auto& [first, count] : ranges)
+		{
+			if (count % 3 != 0 || static_cast<size_t>(first) + count > indices.size()) { return; }
+		}
+
+		std::vector<uint32_t> localOf(vertices.size(), UNASSIGNED);
+		for (const auto& [first, count] : ranges)
+		{
+			buildRangeMeshlets(vertices, std::span<uint32_t>(indices).subspan(first, count), first, localOf, meshletsOut);
+		}
+	}
+
+}
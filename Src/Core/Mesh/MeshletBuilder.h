@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Core/Primitive.h"
+
+#include <span>
+#include <vector>
+
+namespace EngineCore
+{
+	static constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+	static constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+	/* splits every index range of the mesh (each submesh of the full mesh, and each simplified level after it) into meshlets
+	of at most MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES triangles, reordering the triangles within the range
+	so every meshlet is a contiguous run of indices. meshlets grow across shared vertices, preferring triangles that add few
+	vertices and face like the meshlet so far, which keeps the bounds tight and the normal cones narrow
+	the triangles of each meshlet are then ordered for the vertex cache, and the meshlets of each range for overdraw (see optimizeOverdraw)
+	meshletsOut is left empty if an index range does not hold whole triangles */
+	void buildMeshlets(std::span<const Primitive::Vertex> vertices, std::vector<uint32_t>& indices, std::span<const Primitive::Submesh> submeshes,
+		std::span<const Primitive::Lod> lods, std::vector<Primitive::Meshlet>& meshletsOut);
+
+	// bounding sphere and normal cone of a triangle list, the index range is left for the caller to fill in
+	Primitive::Meshlet computeMeshletBounds(std::span<const uint32_t> indices, std::span<const Primitive::Vertex> vertices);
+
+}
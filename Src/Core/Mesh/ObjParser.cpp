@@ -0,0 +1,291 @@
+#define TINYOBJLOADER_IMPLEMENTATION // mesh file loader, compiled here so the parallel parser can share its record parsing
+#include "Core/Mesh/ObjParser.h"
+#include "Core/Dependencies/json-rpg/MappedFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace EngineCore
+{
+	void parallelFor(size_t count, const std::function<void(size_t)>& task)
+	{
+		const size_t numThreads = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+		std::atomic<size_t> next{ 0 };
+		auto worker = [&]()
+		{
+			for (size_t i = next++; i < count; i = next++) { task(i); }
+		};
+		std::vector<std::thread> threads;
+		for (size_t t = 1; t < numThreads; t++) { threads.emplace_back(worker); }
+		worker();
+		for (auto& thread : threads) { thread.join(); }
+	}
+
+	// face corner, indices are zero-based and -1 if absent
+	struct ObjCorner
+	{
+		int v, vt, vn;
+		uint8_t relative; // bit per index (1 v, 2 vt, 4 vn) that was negative, so it is counted from the chunk's first record
+	};
+
+	// records of one chunk of the file, parsed independently of the other chunks
+	struct ObjChunk
+	{
+		std::vector<tinyobj::real_t> positions;
+		std::vector<tinyobj::real_t> normals;
+		std::vector<tinyobj::real_t> texcoords;
+		std::vector<ObjCorner> corners;
+		std::vector<uint32_t> faceSizes; // corners of each face
+		std::vector<uint32_t> shapeBreaks; // number of faces before each g or o record
+		std::vector<tinyobj::index_t> indices; // triangulated faces
+		std::vector<size_t> shapeEnds; // size of indices at each shape break
+		int baseV = 0, baseVt = 0, baseVn = 0; // records in the chunks before
+		bool valid = true;
+	};
+
+	static bool isObjSpace(char c) { return c == ' ' || c == '\t'; }
+	static bool isObjLineEnd(char c) { return c == '\r' || c == '\n' || c == '\0'; }
+
+	// same as tinyobj's fixIndex, except that relative indices are resolved against the chunk's count and flagged
+	static bool fixObjIndex(int index, int count, int& indexOut, uint8_t bit, uint8_t& relativeOut)
+	{
+		if (index > 0) { indexOut = index - 1; return true; }
+		if (index == 0) { return false; }
+		indexOut = count + index;
+		relativeOut |= bit;
+		return true;
+	}
+
+	// i, i/j, i//k or i/j/k, the token is moved past it like tinyobj's parseTriple does
+	static bool parseObjCorner(const char*& token, const ObjChunk& chunk, ObjCorner& cornerOut)
+	{
+		cornerOut = ObjCorner{ -1, -1, -1, 0 };
+		const int vCount = static_cast<int>(chunk.positions.size() / 3);
+		const int vtCount = static_cast<int>(chunk.texcoords.size() / 2);
+		const int vnCount = static_cast<int>(chunk.normals.size() / 3);
+
+		if (!fixObjIndex(std::atoi(token), vCount, cornerOut.v, 1, cornerOut.relative)) { return false; }
+		token += std::strcspn(token, "/ \t\r");
+		if (token[0] != '/') { return true; }
+		token++;
+		if (token[0] == '/')
+		{
+			token++;
+			if (!fixObjIndex(std::atoi(token), vnCount, cornerOut.vn, 4, cornerOut.relative)) { return false; }
+			token += std::strcspn(token, "/ \t\r");
+			return true;
+		}
+		if (!fixObjIndex(std::atoi(token), vtCount, cornerOut.vt, 2, cornerOut.relative)) { return false; }
+		token += std::strcspn(token, "/ \t\r");
+		if (token[0] != '/') { return true; }
+		token++;
+		if (!fixObjIndex(std::atoi(token), vnCount, cornerOut.vn, 4, cornerOut.relative)) { return false; }
+		token += std::strcspn(token, "/ \t\r");
+		return true;
+	}
+
+	// lines of the chunk are null-terminated in place, the record parsing is tinyobj's own
+	static void parseObjChunk(std::string& text, ObjChunk& chunk)
+	{
+		std::replace_if(text.begin(), text.end(), [](char c) { return c == '\r' || c == '\n'; }, '\0');
+		const char* end = text.data() + text.size();
+		for (const char* line = text.data(); line < end; line += std::strlen(line) + 1)
+		{
+			const char* token = line + std::strspn(line, " \t");
+			if (token[0] == '\0' || token[0] == '#') { continue; }
+
+			if (token[0] == 'v' && isObjSpace(token[1]))
+			{
+				token += 2;
+				tinyobj::real_t x, y, z, r, g, b;
+				tinyobj::parseVertexWithColor(&x, &y, &z, &r, &g, &b, &token);
+				chunk.positions.insert(chunk.positions.end(), { x, y, z });
+			}
+			else if (token[0] == 'v' && token[1] == 'n' && isObjSpace(token[2]))
+			{
+				token += 3;
+				tinyobj::real_t x, y, z;
+				tinyobj::parseReal3(&x, &y, &z, &token);
+				chunk.normals.insert(chunk.normals.end(), { x, y, z });
+			}
+			else if (token[0] == 'v' && token[1] == 't' && isObjSpace(token[2]))
+			{
+				token += 3;
+				tinyobj::real_t x, y;
+				tinyobj::parseReal2(&x, &y, &token);
+				chunk.texcoords.insert(chunk.texcoords.end(), { x, y });
+			}
+			else if (token[0] == 'f' && isObjSpace(token[1]))
+			{
+				token += 2;
+				token += std::strspn(token, " \t");
+				uint32_t size = 0;
+				while (!isObjLineEnd(token[0]))
+				{
+					ObjCorner corner;
+					if (!parseObjCorner(token, chunk, corner))
+					{
+						chunk.valid = false;
+						return;
+					}
+					chunk.corners.push_back(corner);
+					size++;
+					token += std::strspn(token, " \t\r");
+				}
+				chunk.faceSizes.push_back(size);
+			}
+			else if ((token[0] == 'g' || token[0] == 'o') && isObjSpace(token[1]))
+			{
+				chunk.shapeBreaks.push_back(static_cast<uint32_t>(chunk.faceSizes.size()));
+			}
+		}
+	}
+
+	/* turns the chunk's faces into triangles of absolute indices, polygons are split by tinyobj itself
+	needs the positions of the whole file, the split of quads and larger polygons depends on them */
+	static void triangulateObjChunk(ObjChunk& chunk, const std::vector<tinyobj::real_t>& positions)
+	{
+		auto absolute = [&](const ObjCorner& c) -> tinyobj::index_t
+		{
+			tinyobj::index_t index;
+			index.vertex_index = (c.relative & 1) ? chunk.baseV + c.v : c.v;
+			index.texcoord_index = (c.relative & 2) ? chunk.baseVt + c.vt : c.vt;
+			index.normal_index = (c.relative & 4) ? chunk.baseVn + c.vn : c.vn;
+			return index;
+		};
+
+		tinyobj::PrimGroup polygon;
+		polygon.faceGroup.resize(1);
+		tinyobj::shape_t triangulated;
+		const std::vector<tinyobj::tag_t> noTags;
+		const std::string noName;
+		std::string warnings;
+
+		chunk.indices.reserve(chunk.corners.size());
+		size_t nextBreak = 0;
+		const ObjCorner* corner = chunk.corners.data();
+		for (size_t f = 0; f <= chunk.faceSizes.size(); f++)
+		{
+			while (nextBreak < chunk.shapeBreaks.size() && chunk.shapeBreaks[nextBreak] == f)
+			{
+				chunk.shapeEnds.push_back(chunk.indices.size());
+				nextBreak++;
+			}
+			if (f == chunk.faceSizes.size()) { break; }
+
+			const uint32_t size = chunk.faceSizes[f];
+			if (size == 3)
+			{
+				// tinyobj passes triangles through as they are
+				for (uint32_t k = 0; k < 3; k++) { chunk.indices.push_back(absolute(corner[k])); }
+			}
+			else if (size > 3)
+			{
+				auto& vertexIndices = polygon.faceGroup[0].vertex_indices;
+				vertexIndices.clear();
+				for (uint32_t k = 0; k < size; k++)
+				{
+					const tinyobj::index_t index = absolute(corner[k]);
+					vertexIndices.emplace_back(index.vertex_index, index.texcoord_index, index.normal_index);
+				}
+				triangulated.mesh.indices.clear();
+				triangulated.mesh.num_face_vertices.clear();
+				triangulated.mesh.material_ids.clear();
+				triangulated.mesh.smoothing_group_ids.clear();
+				tinyobj::exportGroupsToShape(&triangulated, polygon, noTags, -1, noName, true, positions, &warnings);
+				chunk.indices.insert(chunk.indices.end(), triangulated.mesh.indices.begin(), triangulated.mesh.indices.end());
+			}
+			// faces of fewer than 3 corners are dropped, as by tinyobj
+			corner += size;
+		}
+	}
+
+	bool loadObjParallel(const std::string& path, tinyobj::attrib_t& attribOut, std::vector<tinyobj::shape_t>& shapesOut, std::string& errorOut)
+	{
+		JSON::MappedFile file;
+		if (!file.open(path))
+		{
+			errorOut = "cannot read " + path;
+			return false;
+		}
+		const std::string_view text = file.view();
+
+		// chunks of at least 1 MB, several per thread to even out the load, each ends after a line break
+		constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+		const size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+		const size_t numChunks = std::clamp<size_t>(text.size() / MIN_CHUNK_SIZE, 1, numThreads * 4);
+		std::vector<size_t> bounds{ 0 };
+		for (size_t c = 1; c < numChunks; c++)
+		{
+			const size_t lineBreak = text.find('\n', std::max(bounds.back(), c * text.size() / numChunks));
+			if (lineBreak == std::string_view::npos) { break; }
+			bounds.push_back(lineBreak + 1);
+		}
+		bounds.push_back(text.size());
+
+		std::vector<ObjChunk> chunks(bounds.size() - 1);
+		parallelFor(chunks.size(), [&](size_t c)
+		{
+			std::string chunkText(text.substr(bounds[c], bounds[c + 1] - bounds[c]));
+			parseObjChunk(chunkText, chunks[c]);
+		});
+
+		// the records of earlier chunks give the bases of relative indices, and the offsets to merge at
+		size_t positionCount = 0, normalCount = 0, texcoordCount = 0;
+		for (ObjChunk& chunk : chunks)
+		{
+			if (!chunk.valid)
+			{
+				errorOut = "invalid face (e.g. an index of 0) in " + path;
+				return false;
+			}
+			chunk.baseV = static_cast<int>(positionCount / 3);
+			chunk.baseVn = static_cast<int>(normalCount / 3);
+			chunk.baseVt = static_cast<int>(texcoordCount / 2);
+			positionCount += chunk.positions.size();
+			normalCount += chunk.normals.size();
+			texcoordCount += chunk.texcoords.size();
+		}
+		attribOut = tinyobj::attrib_t{};
+		attribOut.vertices.reserve(positionCount);
+		attribOut.normals.reserve(normalCount);
+		attribOut.texcoords.reserve(texcoordCount);
+		for (ObjChunk& chunk : chunks)
+		{
+			attribOut.vertices.insert(attribOut.vertices.end(), chunk.positions.begin(), chunk.positions.end());
+			attribOut.normals.insert(attribOut.normals.end(), chunk.normals.begin(), chunk.normals.end());
+			attribOut.texcoords.insert(attribOut.texcoords.end(), chunk.texcoords.begin(), chunk.texcoords.end());
+			chunk.positions = {};
+			chunk.normals = {};
+			chunk.texcoords = {};
+		}
+
+		parallelFor(chunks.size(), [&](size_t c) { triangulateObjChunk(chunks[c], attribOut.vertices); });
+
+		// a shape runs from one g or o record to the next, across chunks
+		shapesOut.clear();
+		tinyobj::shape_t shape;
+		auto appendShape = [&]()
+		{
+			if (!shape.mesh.indices.empty()) { shapesOut.push_back(std::move(shape)); }
+			shape = tinyobj::shape_t{};
+		};
+		for (const ObjChunk& chunk : chunks)
+		{
+			size_t begin = 0;
+			for (size_t end : chunk.shapeEnds)
+			{
+				shape.mesh.indices.insert(shape.mesh.indices.end(), chunk.indices.begin() + begin, chunk.indices.begin() + end);
+				appendShape();
+				begin = end;
+			}
+			shape.mesh.indices.insert(shape.mesh.indices.end(), chunk.indices.begin() + begin, chunk.indices.end());
+		}
+		appendShape();
+		return true;
+	}
+
+}
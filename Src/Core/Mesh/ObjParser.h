@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Core/ThirdParty/tiny_obj_loader.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace EngineCore
+{
+	/* parallel replacement for tinyobj::LoadObj (triangulated, materials ignored)
+	the file is split into line-aligned chunks whose v/vn/vt/f records are parsed on all cores, then merged in file order
+	positions, normals, texcoords and the shapes' indices come out the same as from tinyobj, with two exceptions:
+	shapes without triangles are left out, and vertex colors, lines, points and materials are not read
+	returns false with a message in errorOut if the file cannot be read or holds an invalid face */
+	bool loadObjParallel(const std::string& path, tinyobj::attrib_t& attribOut, std::vector<tinyobj::shape_t>& shapesOut, std::string& errorOut);
+
+	// runs task(i) for every i below count, spread over worker threads and the calling thread
+	void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+}
@@ -0,0 +1,72 @@
+#include "Core/Mesh/VertexFormat.h"
+#include "Core/Primitive.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace EngineCore
+{
+	uint32_t getVertexSize(VertexFormat format)
+	{
+		return (format == VertexFormat::Float32) ? sizeof(Primitive::Vertex) : sizeof(CompactVertex);
+	}
+
+	uint16_t floatToHalf(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+		const uint32_t magnitude = bits & 0x7FFFFFFF;
+
+		if (magnitude > 0x7F800000) { return sign | 0x7E00; } // NaN
+		if (magnitude >= 0x47800000) { return sign | 0x7C00; } // 65536 and above (or infinity)
+		if (magnitude < 0x38800000)
+		{
+			// subnormal half (below 2^-14), the mantissa with its implicit bit is shifted down to units of 2^-24
+			if (magnitude < 0x33000000) { return sign; } // 2^-25 and below round to zero
+			const uint32_t exponent = magnitude >> 23;
+			const uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+			const uint32_t shift = 126 - exponent;
+			uint32_t half = mantissa >> shift;
+			const uint32_t remainder = mantissa & ((1u << shift) - 1);
+			const uint32_t halfway = 1u << (shift - 1);
+			if (remainder > halfway || (remainder == halfway && (half & 1))) { half++; }
+			return sign | static_cast<uint16_t>(half);
+		}
+		// rebias the exponent from 127 to 15 and drop 13 mantissa bits, a rounding carry correctly bumps the exponent
+		uint32_t half = (magnitude - 0x38000000) >> 13;
+		const uint32_t remainder = magnitude & 0x1FFF;
+		if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) { half++; }
+		return sign | static_cast<uint16_t>(half);
+	}
+
+	int16_t floatToSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+	}
+
+	glm::vec2 octahedralEncode(const glm::vec3& normal)
+	{
+		const float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+		if (l1 == 0.f) { return glm::vec2{ 0.f }; }
+		glm::vec2 p{ normal.x / l1, normal.y / l1 };
+		if (normal.z < 0.f)
+		{
+			// the lower hemisphere is folded over the diagonals
+			p = glm::vec2{ (1.f - std::abs(p.y)) * (p.x >= 0.f ? 1.f : -1.f),
+						(1.f - std::abs(p.x)) * (p.y >= 0.f ? 1.f : -1.f) };
+		}
+		return p;
+	}
+
+	glm::vec3 octahedralDecode(const glm::vec2& encoded)
+	{
+		glm::vec3 n{ encoded.x, encoded.y, 1.f - std::abs(encoded.x) - std::abs(encoded.y) };
+		const float t = std::max(-n.z, 0.f);
+		n.x += (n.x >= 0.f) ? -t : t;
+		n.y += (n.y >= 0.f) ? -t : t;
+		return glm::normalize(n);
+	}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+namespace EngineCore
+{
+	/* layout of the vertices of a Primitive's vertex buffer, the material drawing it must use the same one
+	the compact formats drop the vertex color and need a vertex shader that decodes the normal (e.g. shader_compact.vert) */
+	enum class VertexFormat
+	{
+		Float32,		// Primitive::Vertex as is, 44 bytes
+		Half,			// CompactVertex with half-float positions, 16 bytes
+		Normalized16	// CompactVertex with 16-bit normalized integer positions, 16 bytes, evenly precise over the whole mesh
+	};
+
+	/* positions are divided by the mesh extent into [-1, 1] (w is 1), so the model matrix has to scale them back (see Primitive::getPositionScale)
+	normals are octahedral encoded, UVs are half-floats */
+	struct CompactVertex
+	{
+		uint16_t position[4]; // half-float or snorm16 bits, depending on the format
+		int16_t normal[2]; // snorm16
+		uint16_t uv[2]; // half-float
+	};
+	static_assert(sizeof(CompactVertex) == 16, "CompactVertex must stay tightly packed");
+
+	uint32_t getVertexSize(VertexFormat format);
+
+	// IEEE 754 binary16 bits of a float, rounded to nearest even, out of range values become infinity
+	uint16_t floatToHalf(float value);
+	// clamped to [-1, 1]
+	int16_t floatToSnorm16(float value);
+
+	/* maps a unit vector onto the octahedron folded into the [-1, 1] square, 2 components instead of 3
+	errors are spread evenly over the sphere, at 16 bits per component they stay far below shading precision */
+	glm::vec2 octahedralEncode(const glm::vec3& normal);
+	glm::vec3 octahedralDecode(const glm::vec2& encoded);
+
+}
@@ -0,0 +1,73 @@
+#include "Core/Mesh/VertexWelder.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+namespace EngineCore
+{
+	static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+	static constexpr size_t VERTEX_WORDS = sizeof(Primitive::Vertex) / sizeof(uint32_t);
+	static_assert(sizeof(Primitive::Vertex) == VERTEX_WORDS * sizeof(float), "Vertex is expected to be tightly packed floats");
+
+	// float bits of all attributes, -0 is turned into 0 so that the two weld together
+	using VertexKey = std::array<uint32_t, VERTEX_WORDS>;
+	static VertexKey makeKey(const Primitive::Vertex& vertex)
+	{
+		float values[VERTEX_WORDS];
+		std::memcpy(values, &vertex, sizeof(values));
+		VertexKey key;
+		for (size_t i = 0; i < VERTEX_WORDS; i++) { key[i] = std::bit_cast<uint32_t>(values[i] + 0.f); }
+		return key;
+	}
+
+	static uint32_t hashKey(const VertexKey& key)
+	{
+		uint64_t h = 0x9E3779B97F4A7C15ull;
+		for (uint32_t word : key) { h = (h ^ word) * 0xFF51AFD7ED558CCDull; }
+		h ^= h >> 32;
+		return static_cast<uint32_t>(h);
+	}
+
+	VertexWelder::VertexWelder(size_t expectedVertices)
+	{
+		vertices.reserve(expectedVertices);
+		hashes.reserve(expectedVertices);
+		rehash(std::bit_ceil(std::max<size_t>(expectedVertices * 2, 64)));
+	}
+
+	uint32_t VertexWelder::add(const Primitive::Vertex& vertex)
+	{
+		const VertexKey key = makeKey(vertex);
+		const uint32_t hash = hashKey(key);
+		size_t slot = hash & mask;
+		while (table[slot] != EMPTY_SLOT)
+		{
+			const uint32_t candidate = table[slot];
+			if (hashes[candidate] == hash && makeKey(vertices[candidate]) == key) { return candidate; }
+			slot = (slot + 1) & mask; // linear probing
+		}
+
+		const auto index = static_cast<uint32_t>(vertices.size());
+		vertices.push_back(vertex);
+		hashes.push_back(hash);
+		table[slot] = index;
+		// kept at most half full, probe sequences stay short
+		if (vertices.size() * 2 > table.size()) { rehash(table.size() * 2); }
+		return index;
+	}
+
+	void VertexWelder::rehash(size_t newCapacity)
+	{
+		table.assign(newCapacity, EMPTY_SLOT);
+		mask = newCapacity - 1;
+		for (uint32_t i = 0; i < static_cast<uint32_t>(vertices.size()); i++)
+		{
+			size_t slot = hashes[i] & mask;
+			while (table[slot] != EMPTY_SLOT) { slot = (slot + 1) & mask; }
+			table[slot] = i;
+		}
+	}
+
+}
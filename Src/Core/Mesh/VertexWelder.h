@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Core/Primitive.h"
+
+#include <vector>
+
+namespace EngineCore
+{
+	/* merges identical vertices of a vertex stream into an indexed mesh
+	vertices are compared bitwise on all attributes (except that -0 and 0 are equal), uses an open addressing hash table */
+	class VertexWelder
+	{
+	public:
+		// expectedVertices sizes the table up front, adding more is fine but rehashes
+		explicit VertexWelder(size_t expectedVertices = 0);
+
+		// returns the index of the vertex, adding it if no identical vertex was added before
+		uint32_t add(const Primitive::Vertex& vertex);
+
+		// unique vertices in order of first use
+		const std::vector<Primitive::Vertex>& getVertices() const { return vertices; }
+		std::vector<Primitive::Vertex> releaseVertices() { return std::move(vertices); }
+
+	private:
+		void rehash(size_t newCapacity);
+
+		std::vector<Primitive::Vertex> vertices;
+		std::vector<uint32_t> hashes; // per vertex, so rehashing and probing do not hash again
+		std::vector<uint32_t> table; // vertex index per slot, EMPTY_SLOT if free
+		size_t mask = 0;
+	};
+
+}
@@ -1,18 +1,29 @@
 #include "Core/Primitive.h"
 #include "Core/GPU/Material.h"
+#include "Core/GPU/UploadManager.h"
+#include "Core/Mesh/GlbImporter.h"
+#include "Core/Mesh/MeshCache.h"
+#include "Core/Mesh/MeshOptimizer.h"
+#include "Core/Mesh/MeshletBuilder.h"
+#include "Core/Mesh/MeshSimplifier.h"
+#include "Core/Mesh/ObjParser.h"
+#include "Core/Mesh/VertexWelder.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
-
-#define TINYOBJLOADER_IMPLEMENTATION // mesh file loader
-#include "Core/ThirdParty/tiny_obj_loader.h"
+#include <iostream>
 
 namespace EngineCore
 {
-	Primitive::Primitive(EngineDevice& device, const MeshBuilder& builder) : device{ device }
+	Primitive::Primitive(EngineDevice& device, const MeshBuilder& builder, VertexFormat format) : Primitive(device, builder.getView(), format) {}
+
+	Primitive::Primitive(EngineDevice& device, const MeshView& mesh, VertexFormat format) : device{ device }, vertexFormat{ format }
 	{
-		createVertexBuffers(builder.vertices);
-		createIndexBuffers(builder.indices);
+		createVertexBuffers(mesh.vertices);
+		createIndexBuffers(mesh.indices);
+		lods.assign(mesh.lods.begin(), mesh.lods.end());
+		meshlets.assign(mesh.meshlets.begin(), mesh.meshlets.end());
 	}
 
 	Primitive::Primitive(EngineDevice& device, const std::vector<Vertex>& vertices) : device{ device }
@@ -40,56 +51,94 @@ namespace EngineCore
 		return false;
     }
 
-    void Primitive::createVertexBuffers(const std::vector<Vertex>& vertices)
+	// an empty axis (e.g. a flat plane) is left unscaled, its positions are all 0
+	static float axisScale(float extent) { return (extent > 0.f) ? extent : 1.f; }
+
+	glm::vec3 Primitive::getPositionScale() const
+	{
+		if (vertexFormat == VertexFormat::Float32) { return glm::vec3{ 1.f }; }
+		return glm::vec3{ axisScale(extent.x), axisScale(extent.y), axisScale(extent.z) };
+	}
+
+	static std::vector<CompactVertex> makeCompactVertices(std::span<const Primitive::Vertex> vertices, VertexFormat format, const glm::vec3& positionScale)
+	{
+		std::vector<CompactVertex> compact(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			const Primitive::Vertex& v = vertices[i];
+			CompactVertex& c = compact[i];
+			const glm::vec3 position = v.position / positionScale;
+			for (int k = 0; k < 3; k++)
+			{
+				c.position[k] = (format == VertexFormat::Half) ? floatToHalf(position[k]) : static_cast<uint16_t>(floatToSnorm16(position[k]));
+			}
+			c.position[3] = (format == VertexFormat::Half) ? floatToHalf(1.f) : static_cast<uint16_t>(floatToSnorm16(1.f));
+			const glm::vec2 normal = octahedralEncode(v.normal);
+			c.normal[0] = floatToSnorm16(normal.x);
+			c.normal[1] = floatToSnorm16(normal.y);
+			c.uv[0] = floatToHalf(v.uv.x);
+			c.uv[1] = floatToHalf(v.uv.y);
+		}
+		return compact;
+	}
+
+    void Primitive::createVertexBuffers(std::span<const Vertex> vertices)
 	{
 		generateOOBB(vertices);
 		vertexCount = static_cast<uint32_t>(vertices.size());
 		assert(vertexCount >= 3 && "vertexCount cannot be below 3");
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-		uint32_t vertexSize = sizeof(vertices[0]);
-		// temporary buffer to transfer from CPU (host) to GPU (device)
-		GBuffer stagingBuffer
-		{
-			device, vertexSize, vertexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)vertices.data()); // write vertices
+		if (vertexFormat == VertexFormat::Float32) { uploadVertices(vertices.data(), sizeof(Vertex)); }
+		else
+		{
+			const std::vector<CompactVertex> compact = makeCompactVertices(vertices, vertexFormat, getPositionScale());
+			uploadVertices(compact.data(), sizeof(CompactVertex));
+		}
+	}
 
+	void Primitive::uploadVertices(const void* vertices, uint32_t vertexSize)
+	{
+		VkDeviceSize bufferSize = static_cast<VkDeviceSize>(vertexSize) * vertexCount;
 		// destination buffer, GPU only for speed (not host accessible)
 		vertexBuffer = std::make_unique<GBuffer>(device, vertexSize, vertexCount,
 			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-		device.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+		// staged and copied with the other uploads of the frame, without waiting (see GPU/UploadManager.h)
+		device.getUploadManager().uploadBuffer(vertexBuffer->getBuffer(), vertices, bufferSize);
 	}
 
-	void Primitive::createIndexBuffers(const std::vector<uint32_t>& indices)
+	void Primitive::createIndexBuffers(std::span<const uint32_t> indices)
 	{
 		indexCount = static_cast<uint32_t>(indices.size());
 		hasIndexBuffer = indexCount > 0;
 		if (!hasIndexBuffer) { return; }
-		VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-		uint32_t indexSize = sizeof(indices[0]);
-		// same as for vertex buffer
-		GBuffer stagingBuffer
+		// meshes with few enough vertices get 16-bit indices, halving the index data
+		if (vertexCount <= UINT16_MAX)
 		{
-			device, indexSize, indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)indices.data());
+			std::vector<uint16_t> narrowIndices(indexCount);
+			for (uint32_t i = 0; i < indexCount; i++) { narrowIndices[i] = static_cast<uint16_t>(indices[i]); }
+			indexType = VK_INDEX_TYPE_UINT16;
+			uploadIndices(narrowIndices.data(), sizeof(uint16_t));
+		}
+		else
+		{
+			indexType = VK_INDEX_TYPE_UINT32;
+			uploadIndices(indices.data(), sizeof(uint32_t));
+		}
+	}
 
+	void Primitive::uploadIndices(const void* indices, uint32_t indexSize)
+	{
+		VkDeviceSize bufferSize = static_cast<VkDeviceSize>(indexSize) * indexCount;
+		// same as for vertex buffer
 		indexBuffer = std::make_unique<GBuffer>(device, indexSize, indexCount,
 			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT); // note INDEX_BUFFER_BIT
 
-		device.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+		device.getUploadManager().uploadBuffer(indexBuffer->getBuffer(), indices, bufferSize);
 	}
 
-	void Primitive::generateOOBB(const std::vector<Vertex>& vertices)
+	void Primitive::generateOOBB(std::span<const Vertex> vertices)
 	{
 		for (const auto& v : vertices)
 		{
@@ -104,54 +153,171 @@ namespace EngineCore
 		VkBuffer buffers[] = { vertexBuffer->getBuffer() };
 		VkDeviceSize offsets[] = { 0 };
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
-		if (hasIndexBuffer) { vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32); }
+		if (hasIndexBuffer) { vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, indexType); }
 	}
 
 	void Primitive::draw(VkCommandBuffer commandBuffer)
 	{
-		if (hasIndexBuffer) { vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0); }
+		if (hasIndexBuffer && !lods.empty()) { vkCmdDrawIndexed(commandBuffer, lods[selectedLod].indexCount, 1, lods[selectedLod].firstIndex, 0, 0); }
+		else if (hasIndexBuffer) { vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0); }
 		else { vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0); }
 	}
 
-	void Primitive::MeshBuilder::loadFromFile(const std::string& path)
+	void Primitive::drawIndexRange(VkCommandBuffer commandBuffer, uint32_t firstIndex, uint32_t indexCount)
+	{
+		vkCmdDrawIndexed(commandBuffer, indexCount, 1, firstIndex, 0, 0);
+	}
+
+	std::span<const Primitive::Meshlet> Primitive::getMeshlets() const
+	{
+		// meshlets are sorted by their first index, those of one level are a run
+		const uint32_t first = lods.empty() ? 0 : lods[selectedLod].firstIndex;
+		const uint32_t end = lods.empty() ? indexCount : first + lods[selectedLod].indexCount;
+		const auto byIndex = [](const Meshlet& meshlet, uint32_t index) { return meshlet.firstIndex < index; };
+		const auto begin = std::lower_bound(meshlets.begin(), meshlets.end(), first, byIndex);
+		return { begin, std::lower_bound(begin, meshlets.end(), end, byIndex) };
+	}
+
+	// vertex of one face corner of an OBJ mesh
+	static Primitive::Vertex makeObjVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index)
+	{
+		Primitive::Vertex vert{};
+		if (index.vertex_index >= 0)
+		{
+			vert.position = { attrib.vertices[3 * index.vertex_index],
+							attrib.vertices[3 * index.vertex_index + 1],
+							attrib.vertices[3 * index.vertex_index + 2] };
+		}
+		if (index.normal_index >= 0)
+		{
+			vert.normal = { attrib.normals[3 * index.normal_index],
+							attrib.normals[3 * index.normal_index + 1],
+							attrib.normals[3 * index.normal_index + 2] };
+		}
+		if (index.texcoord_index >= 0)
+		{
+			vert.uv = { attrib.texcoords[2 * index.texcoord_index],
+						1 - attrib.texcoords[2 * index.texcoord_index + 1] };
+		}
+		return vert;
+	}
+
+	// OBJ format mesh, using TinyObjLoader (or the parallel parser built on it)
+	static void importObjMesh(const std::string& path, const MeshLoadOptions& options, Primitive::MeshBuilder& mesh)
 	{
-		// TODO: support different mesh formats
-		// OBJ format mesh loader, using TinyObjLoader (for now)
 		tinyobj::attrib_t attrib;
 		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warn, err;
-		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str()))
+		if (options.parallel)
 		{
-			throw std::runtime_error("error loading mesh from file: " + warn + err);
+			std::string err;
+			if (!loadObjParallel(path, attrib, shapes, err)) { throw std::runtime_error("error loading mesh from file: " + err); }
 		}
+		else
+		{
+			std::vector<tinyobj::material_t> materials;
+			std::string warn, err;
+			if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str()))
+			{
+				throw std::runtime_error("error loading mesh from file: " + warn + err);
+			}
+			// shapes of only lines or points would be empty submeshes (and the parallel parser leaves them out)
+			std::erase_if(shapes, [](const tinyobj::shape_t& shape) { return shape.mesh.indices.empty(); });
+		}
+		if (!options.weldVertices)
+		{
+			// one vertex per face corner, indices = 0 to indicate non-indexed primitive
+			for (const auto& shape : shapes)
+			{
+				for (const auto& index : shape.mesh.indices) { mesh.vertices.push_back(makeObjVertex(attrib, index)); }
+			}
+			return;
+		}
+
+		// shapes are welded separately (on worker threads if allowed), then appended one after another
+		std::vector<std::vector<Primitive::Vertex>> shapeVertices(shapes.size());
+		std::vector<std::vector<uint32_t>> shapeIndices(shapes.size());
+		auto weldShape = [&](size_t s)
+		{
+			const auto& objIndices = shapes[s].mesh.indices;
+			VertexWelder welder(objIndices.size() / 4); // OBJ corners usually share a vertex with 4-6 others
+			shapeIndices[s].reserve(objIndices.size());
+			for (const auto& index : objIndices) { shapeIndices[s].push_back(welder.add(makeObjVertex(attrib, index))); }
+			shapeVertices[s] = welder.releaseVertices();
+		};
+		if (options.parallel && shapes.size() > 1) { parallelFor(shapes.size(), weldShape); }
+		else
+		{
+			for (size_t s = 0; s < shapes.size(); s++) { weldShape(s); }
+		}
+
+		size_t totalVertices = 0, totalIndices = 0;
+		for (size_t s = 0; s < shapes.size(); s++)
+		{
+			totalVertices += shapeVertices[s].size();
+			totalIndices += shapeIndices[s].size();
+		}
+		mesh.vertices.reserve(totalVertices);
+		mesh.indices.reserve(totalIndices);
+		for (size_t s = 0; s < shapes.size(); s++)
+		{
+			const auto base = static_cast<uint32_t>(mesh.vertices.size());
+			mesh.submeshes.push_back(Primitive::Submesh{ static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(shapeIndices[s].size()) });
+			mesh.vertices.insert(mesh.vertices.end(), shapeVertices[s].begin(), shapeVertices[s].end());
+			for (uint32_t index : shapeIndices[s]) { mesh.indices.push_back(base + index); }
+		}
+	}
+
+	void Primitive::MeshBuilder::loadFromFile(const std::string& path, const MeshLoadOptions& options)
+	{
+		if (isGlbPath(path) || !options.cacheDirectory.empty())
+		{
+			// GLB files are never cached, the cache of OBJ files is read (or imported and written) there
+			MeshCache cache;
+			cache.load(path, options);
+			const MeshView& view = cache.getView();
+			vertices.assign(view.vertices.begin(), view.vertices.end());
+			indices.assign(view.indices.begin(), view.indices.end());
+			submeshes.assign(view.submeshes.begin(), view.submeshes.end());
+			lods.assign(view.lods.begin(), view.lods.end());
+			meshlets.assign(view.meshlets.begin(), view.meshlets.end());
+			return;
+		}
+
 		vertices.clear();
-		indices.clear(); // indices = 0 for OBJ format to indicate non-indexed primitive
-		for (const auto& shape : shapes)
+		indices.clear();
+		submeshes.clear();
+		lods.clear();
+		meshlets.clear();
+		importObjMesh(path, options, *this);
+
+		MeshOptimizeStats stats{};
+		if (options.optimize && !indices.empty()) { stats = optimizeMesh(*this); }
+		// after optimizing, the levels are appended to the reordered indices
+		if (options.generateLods && !indices.empty())
 		{
-			for (const auto& index : shape.mesh.indices)
+			generateMeshLods(vertices, indices, lods);
+			if (options.printStats)
 			{
-				Vertex vert{};
-				if (index.vertex_index >= 0)
-				{
-					vert.position = { attrib.vertices[3 * index.vertex_index],
-									attrib.vertices[3 * index.vertex_index + 1],
-									attrib.vertices[3 * index.vertex_index + 2] };
-				}
-				if (index.normal_index >= 0)
-				{
-					vert.normal = { attrib.normals[3 * index.normal_index],
-									attrib.normals[3 * index.normal_index + 1],
-									attrib.normals[3 * index.normal_index + 2] };
-				}
-				if (index.texcoord_index >= 0)
-				{
-					vert.uv = { attrib.texcoords[2 * index.texcoord_index],
-								1 - attrib.texcoords[2 * index.texcoord_index + 1] };
-				}
-				vertices.push_back(vert); // add vertex
+				std::cout << "mesh " << path << ": " << lods.size() << " levels of detail";
+				for (const Lod& lod : lods) { std::cout << ", " << lod.indexCount / 3 << " triangles (error " << lod.error << ")"; }
+				std::cout << std::endl;
 			}
 		}
+		// last, since it reorders the triangles of every submesh and level
+		if (options.buildMeshlets && !indices.empty())
+		{
+			buildMeshlets(vertices, indices, submeshes, lods, meshlets);
+			if (options.optimize) { optimizeVertexFetch(*this); } // the vertices again in order of first use
+			if (options.printStats) { std::cout << "mesh " << path << ": " << meshlets.size() << " meshlets" << std::endl; }
+		}
+		if (options.optimize && options.printStats && !indices.empty())
+		{
+			// measured on the full detail indices as they are uploaded, after the meshlets reordered them
+			const size_t fullCount = lods.empty() ? indices.size() : lods[0].indexCount;
+			stats.after = analyzeVertexCache(std::vector<uint32_t>(indices.begin(), indices.begin() + fullCount), vertices.size());
+			std::cout << "mesh " << path << ": " << vertices.size() << " vertices, " << fullCount / 3 << " triangles, ACMR "
+				<< stats.before.acmr << " -> " << stats.after.acmr << ", ATVR " << stats.before.atvr << " -> " << stats.after.atvr << std::endl;
+		}
 	}
 
 	void Primitive::MeshBuilder::makeCubeMesh()
@@ -209,17 +375,28 @@ namespace EngineCore
 					4,5,4, 5,6,5, 6,7,6, 7,4,7 };	// ceiling
 	}
 
-	std::vector<VkVertexInputBindingDescription> Primitive::Vertex::getBindingDescriptions()
+	std::vector<VkVertexInputBindingDescription> Primitive::Vertex::getBindingDescriptions(VertexFormat format)
 	{
 		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
 		bindingDescriptions[0].binding = 0;
-		bindingDescriptions[0].stride = sizeof(Vertex);
+		bindingDescriptions[0].stride = getVertexSize(format);
 		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 		return bindingDescriptions;
 	}
 
-	std::vector<VkVertexInputAttributeDescription> Primitive::Vertex::getAttributeDescriptions()
+	std::vector<VkVertexInputAttributeDescription> Primitive::Vertex::getAttributeDescriptions(VertexFormat format)
 	{
+		if (format != VertexFormat::Float32)
+		{
+			// no color (location 1), the normal is 2 octahedral components
+			const VkFormat positionFormat = (format == VertexFormat::Half) ? VK_FORMAT_R16G16B16A16_SFLOAT : VK_FORMAT_R16G16B16A16_SNORM;
+			return
+			{
+				{ 0, 0, positionFormat, offsetof(CompactVertex, position) },
+				{ 2, 0, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertex, normal) },
+				{ 3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactVertex, uv) }
+			};
+		}
 		return
 		{
 			// location, binding, format, offset
@@ -2,20 +2,36 @@
 
 #include "Core/GPU/Device.h"
 #include "Core/GPU/Buffer.h"
+#include "Core/Mesh/VertexFormat.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <vector>
 #include <stdexcept>
 #include <memory>
+#include <span>
+#include <string>
 
 namespace EngineCore 
 {
 	class Material;
 	struct MaterialCreateInfo;
 
+	// how MeshBuilder::loadFromFile turns a file into a mesh
+	struct MeshLoadOptions
+	{
+		bool weldVertices = true; // merge identical vertices into an indexed mesh, otherwise one vertex per face corner
+		bool parallel = false; // parse the file and weld its shapes on worker threads (see Mesh/ObjParser.h), pays off for large files
+		bool optimize = true; // reorder welded meshes for the vertex cache, overdraw and vertex fetch (see Mesh/MeshOptimizer.h)
+		bool printStats = false; // print the vertex cache miss ratios before and after optimizing
+		std::string cacheDirectory{}; // where the binary cache of the mesh is read and written (see Mesh/MeshCache.h), empty disables caching
+		bool generateLods = true; // append simplified levels of detail to welded meshes (see Mesh/MeshSimplifier.h)
+		bool buildMeshlets = true; // group the triangles of welded meshes into clusters culled separately when drawn (see Mesh/MeshletBuilder.h)
+	};
+
 	class Primitive
 	{
 	public:
@@ -25,21 +41,65 @@ namespace EngineCore
 			glm::vec3 color{};
 			glm::vec3 normal{};
 			glm::vec2 uv{};
-			// binding/attribute descriptions are read by the pipeline
-			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
-			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+			// binding/attribute descriptions are read by the pipeline, for the vertex buffer layout of the given format
+			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions(VertexFormat format = VertexFormat::Float32);
+			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(VertexFormat format = VertexFormat::Float32);
+		};
+
+		// range of the index buffer holding one part of a mesh (e.g. an OBJ shape)
+		struct Submesh
+		{
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+		};
+
+		// range of the index buffer holding one level of detail, all levels index the same vertices
+		struct Lod
+		{
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+			float error = 0.f; // largest deviation from the full mesh, relative to the radius of its bounds
+		};
+
+		// cluster of neighbouring triangles, a range of the index buffer culled apart from the rest of the mesh
+		struct Meshlet
+		{
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+			glm::vec3 center{}; // bounding sphere, in mesh space
+			float radius = 0.f;
+			glm::vec3 coneAxis{}; // average facing of the triangles
+			float coneCutoff = 1.f; // sine of the spread of the triangles' normals around the axis, 1 if they cannot all face away at once
+		};
+
+		// non-owning vertex and index streams, of a MeshBuilder or of a memory mapped mesh cache file
+		struct MeshView
+		{
+			std::span<const Vertex> vertices;
+			std::span<const uint32_t> indices;
+			std::span<const Submesh> submeshes;
+			std::span<const Lod> lods;
+			std::span<const Meshlet> meshlets;
 		};
 
 		struct MeshBuilder
 		{
 			std::vector<Vertex> vertices{};
 			std::vector<uint32_t> indices{};
+			std::vector<Submesh> submeshes{}; // filled by loadFromFile for indexed meshes, the optimizer keeps triangles within their submesh
+			std::vector<Lod> lods{}; // empty, or the full mesh followed by its simplified levels, whose indices are appended after the full mesh's
+			std::vector<Meshlet> meshlets{}; // empty, or covering all indices in index order (every submesh and level split separately)
+			MeshView getView() const { return MeshView{ vertices, indices, submeshes, lods, meshlets }; }
 			void makeCubeMesh();
 			void makeCubeMeshWireframe();
-			void loadFromFile(const std::string& path);
+			// OBJ, or binary glTF if the path ends in .glb (GLB files and cached OBJ files are loaded through MeshCache::load, see Mesh/MeshCache.h)
+			void loadFromFile(const std::string& path, const MeshLoadOptions& options = MeshLoadOptions{});
 		};
 
-		Primitive(EngineDevice& device, const MeshBuilder& builder);
+		// the vertices are converted to the format on upload, the builder keeps full precision
+		Primitive(EngineDevice& device, const MeshBuilder& builder, VertexFormat format = VertexFormat::Float32);
+		// the streams are copied straight into the staging buffers, so they only have to outlive the constructor
+		Primitive(EngineDevice& device, const MeshView& mesh, VertexFormat format = VertexFormat::Float32);
 		Primitive(EngineDevice& device, const std::vector<Vertex>& vertices);
 		Primitive(EngineDevice& device);
 		~Primitive() = default;
@@ -49,8 +109,10 @@ namespace EngineCore
 
 		// binds the primitive's vertices to a command buffer (preparation to render)
 		void bind(VkCommandBuffer commandBuffer);
-		// records a draw call to the command buffer (final step to render mesh)
+		// records a draw call to the command buffer (final step to render mesh), of the selected level of detail
 		void draw(VkCommandBuffer commandBuffer);
+		// records a draw call of part of the index buffer, e.g. of visible meshlets
+		void drawIndexRange(VkCommandBuffer commandBuffer, uint32_t firstIndex, uint32_t indexCount);
 
 		void setMaterial(std::shared_ptr<Material> newMaterial);
 		void setMaterial(const MaterialCreateInfo& info);
@@ -64,9 +126,25 @@ namespace EngineCore
 
 		bool isPointInsideOOBB(const Vec& point);
 
+		// levels of detail, none for meshes without indices or LODs, the selected one is drawn
+		uint32_t getLodCount() const { return static_cast<uint32_t>(lods.size()); }
+		const Lod& getLod(uint32_t index) const { return lods[index]; }
+		uint32_t getSelectedLod() const { return selectedLod; }
+		void selectLod(uint32_t index) { selectedLod = std::min(index, lods.empty() ? 0u : getLodCount() - 1); }
+		// meshlets of the selected level of detail, empty if the mesh has none
+		std::span<const Meshlet> getMeshlets() const;
+		// radius of the bounds around the mesh origin (see generateOOBB), in mesh space
+		float getBoundingRadius() const { return glm::length(glm::vec3{ extent.x, extent.y, extent.z }); }
+
+		VertexFormat getVertexFormat() const { return vertexFormat; }
+		// compact formats store positions relative to the extent, the model matrix is scaled by this when drawing
+		glm::vec3 getPositionScale() const;
+
 	private:
-		void createVertexBuffers(const std::vector<Vertex>& vertices);
-		void createIndexBuffers(const std::vector<uint32_t>& indices);
+		void createVertexBuffers(std::span<const Vertex> vertices);
+		void uploadVertices(const void* vertices, uint32_t vertexSize);
+		void createIndexBuffers(std::span<const uint32_t> indices);
+		void uploadIndices(const void* indices, uint32_t indexSize);
 
 		EngineDevice& device;
 
@@ -75,11 +153,16 @@ namespace EngineCore
 
 		std::unique_ptr<GBuffer> vertexBuffer;
 		std::unique_ptr<GBuffer> indexBuffer;
-		uint32_t vertexCount;
-		uint32_t indexCount;
+		uint32_t vertexCount = 0;
+		uint32_t indexCount = 0;
 		bool hasIndexBuffer = false;
+		std::vector<Lod> lods;
+		uint32_t selectedLod = 0;
+		std::vector<Meshlet> meshlets;
+		VertexFormat vertexFormat = VertexFormat::Float32;
+		VkIndexType indexType = VK_INDEX_TYPE_UINT32; // 16-bit when all vertices can be addressed with it
 
-		void generateOOBB(const std::vector<Vertex>& vertices);
+		void generateOOBB(std::span<const Vertex> vertices);
 		Vec extent{};
 	};
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+#include "Core/Dependencies/json-rpg/Bind.h"
+#include "Core/Types/CommonTypes.h"
+#include "Core/GPU/Material.h"
+#include "Core/WorldSystem/SectorDescription.h"
+
+// field tables for decoding engine types directly from JSON text, see JSON::decode()
+
+// vectors are read from [x, y, z] or { "x": .., "y": .., "z": .. }
+template<typename T>
+struct JSON::Binding<Vector3D<T>>
+{
+	static constexpr auto fields = std::make_tuple(
+		JSON_FIELD(Vector3D<T>, x), JSON_FIELD(Vector3D<T>, y), JSON_FIELD(Vector3D<T>, z));
+};
+
+template<>
+struct JSON::Binding<Transform>
+{
+	static constexpr auto fields = std::make_tuple(
+		JSON_FIELD(Transform, translation), JSON_FIELD(Transform, rotation), JSON_FIELD(Transform, scale));
+};
+
+template<>
+struct JSON::EnumNames<VkPrimitiveTopology>
+{
+	static constexpr std::array names{
+		std::pair<JSON::str_view, VkPrimitiveTopology>{ "pointList", VK_PRIMITIVE_TOPOLOGY_POINT_LIST },
+		std::pair<JSON::str_view, VkPrimitiveTopology>{ "lineList", VK_PRIMITIVE_TOPOLOGY_LINE_LIST },
+		std::pair<JSON::str_view, VkPrimitiveTopology>{ "lineStrip", VK_PRIMITIVE_TOPOLOGY_LINE_STRIP },
+		std::pair<JSON::str_view, VkPrimitiveTopology>{ "triangleList", VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST },
+		std::pair<JSON::str_view, VkPrimitiveTopology>{ "triangleStrip", VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP },
+		std::pair<JSON::str_view, VkPrimitiveTopology>{ "triangleFan", VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN } };
+};
+
+template<>
+struct JSON::EnumNames<VkPolygonMode>
+{
+	static constexpr std::array names{
+		std::pair<JSON::str_view, VkPolygonMode>{ "fill", VK_POLYGON_MODE_FILL },
+		std::pair<JSON::str_view, VkPolygonMode>{ "line", VK_POLYGON_MODE_LINE },
+		std::pair<JSON::str_view, VkPolygonMode>{ "point", VK_POLYGON_MODE_POINT } };
+};
+
+template<>
+struct JSON::EnumNames<EngineCore::VertexFormat>
+{
+	static constexpr std::array names{
+		std::pair<JSON::str_view, EngineCore::VertexFormat>{ "float32", EngineCore::VertexFormat::Float32 },
+		std::pair<JSON::str_view, EngineCore::VertexFormat>{ "half", EngineCore::VertexFormat::Half },
+		std::pair<JSON::str_view, EngineCore::VertexFormat>{ "normalized16", EngineCore::VertexFormat::Normalized16 } };
+};
+
+// cullModeFlags is a plain VkCullModeFlagBits mask (0 none, 1 front, 2 back)
+template<>
+struct JSON::Binding<EngineCore::MaterialShadingProperties>
+{
+	using T = EngineCore::MaterialShadingProperties;
+	static constexpr auto fields = std::make_tuple(
+		JSON_FIELD(T, primitiveType), JSON_FIELD(T, polygonMode), JSON_FIELD(T, cullModeFlags),
+		JSON_FIELD(T, lineWidth), JSON_FIELD(T, useVertexInput), JSON_FIELD(T, enableDepth), JSON_FIELD(T, vertexFormat));
+};
+
+template<>
+struct JSON::Binding<WorldSystem::SectorCoord>
+{
+	static constexpr auto fields = std::make_tuple(
+		JSON_FIELD(WorldSystem::SectorCoord, x), JSON_FIELD(WorldSystem::SectorCoord, y), JSON_FIELD(WorldSystem::SectorCoord, z));
+};
+
+template<>
+struct JSON::Binding<WorldSystem::SectorObjectDescription>
+{
+	using T = WorldSystem::SectorObjectDescription;
+	static constexpr auto fields = std::make_tuple(JSON_FIELD(T, mesh), JSON_FIELD(T, transform), JSON_FIELD(T, shading));
+};
+
+template<>
+struct JSON::Binding<WorldSystem::SectorDescription>
+{
+	using T = WorldSystem::SectorDescription;
+	static constexpr auto fields = std::make_tuple(JSON_FIELD(T, coordinates), JSON_FIELD(T, objects));
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include "Core/Types/CommonTypes.h"
+#include "Core/WorldSystem/Sector.h"
+#include "Core/GPU/Material.h"
+
+#include <string>
+#include <vector>
+
+namespace WorldSystem
+{
+	// a mesh placed in a sector, as stored in sector files
+	struct SectorObjectDescription
+	{
+		std::string mesh; // relative to the resource directory
+		Transform transform{};
+		EngineCore::MaterialShadingProperties shading{};
+	};
+
+	// contents of a sector file, see Core/Types/JSONBindings.h for the field names
+	struct SectorDescription
+	{
+		SectorCoord coordinates;
+		std::vector<SectorObjectDescription> objects;
+	};
+
+}
@@ -2,14 +2,19 @@
 #include "Core/WorldSystem/World.h"
 #include "Core/Camera.h"
 #include "Core/Primitive.h"
+#include "Core/Mesh/MeshCache.h"
 #include "Core/GPU/Material.h"
 #include "Core/GPU/Buffer.h"
 #include "Core/GPU/Image.h"
+#include "Core/GPU/UploadManager.h"
 #include "Core/Engine.h"
+#include "Core/Types/JSONBindings.h"
 
 #include <cmath>
 #include <algorithm>
 #include <iostream>
+#include <format>
+#include <stdexcept>
 
 
 namespace WorldSystem
@@ -131,25 +136,54 @@ namespace WorldSystem
 		return it->get();
 	}
 
+	SectorDescription World::readSectorDescription(const std::string& path)
+	{
+		// decoded straight from the text, no intermediate JSON tree
+		SectorDescription description{};
+		const JSON::Result result = JSON::decodeFile(path, description);
+		if (result != JSON::Result::OK)
+		{
+			throw std::runtime_error(std::format("failed to read sector description {} (error {})", path, static_cast<int>(result)));
+		}
+		return description;
+	}
+
+	Sector& World::loadSectorFromFile(const std::string& path)
+	{
+		const SectorDescription description = readSectorDescription(path);
+		assert(!getSector(description.coordinates) && "attempted to load an already loaded world sector");
+		sectors.push_back(std::make_unique<Sector>(description.coordinates));
+		populateSector(*sectors.back(), description);
+		return *sectors.back();
+	}
+
 	void World::createDemoSectorContent()
 	{
-		auto& sector = *sectors[0]; // get the persistent sector
+		SectorDescription description{};
+		SectorObjectDescription& teapot = description.objects.emplace_back();
+		teapot.mesh = "Meshes/teapot.obj"; // TODO: hardcoded path
+		teapot.transform.translation = Vec{ 17.f + 1500.f, 0.f, 0.f };
+		teapot.transform.rotation.z = 95.f;
+		teapot.transform.scale = 30.f * 5.f;
+		teapot.shading.cullModeFlags = VK_CULL_MODE_NONE;
+		populateSector(*sectors[0], description); // the persistent sector
+	}
 
+	void World::populateSector(Sector& sector, const SectorDescription& description)
+	{
 		// create 3D primitive(s)
-		for (size_t i = 0; i < 1; i++)
+		const size_t first = sector.primitives.size();
+		EngineCore::MeshLoadOptions loadOptions{};
+		loadOptions.cacheDirectory = EngineCore::getDefaultMeshCacheDirectory(); // not next to the assets, which may be read-only
+		for (const SectorObjectDescription& object : description.objects)
 		{
-			EngineCore::Primitive::MeshBuilder builder{};
-			builder.loadFromFile(makePath("Meshes/teapot.obj")); // TODO: hardcoded path
-			sector.primitives.push_back(std::make_unique<EngineCore::Primitive>(device, builder));
-			sector.primitives.back()->getTransform().translation = Vec{ 17.f + (i * 17.f), 0.f, 0.f };
-			sector.primitives.back()->getTransform().scale = 30.f;
-			if (i == 0)
-			{
-				sector.primitives.back()->getTransform().scale *= 5.f; // scale up the second mesh
-				sector.primitives.back()->getTransform().translation.x += 1500.f;
-				sector.primitives.back()->getTransform().rotation.z += 95.f;
-			}
+			EngineCore::MeshCache meshCache{};
+			meshCache.load(makePath(object.mesh.c_str()), loadOptions);
+			if (meshCache.hasWriteFailed()) { std::cout << "mesh " << object.mesh << ": could not write its cache" << std::endl; }
+			sector.primitives.push_back(std::make_unique<EngineCore::Primitive>(device, meshCache.getView(), object.shading.vertexFormat));
+			sector.primitives.back()->getTransform() = object.transform;
 		}
+		device.getUploadManager().flush(); // the sector's meshes go to the GPU as one batch
 
 		// create material-specific descriptor set (the set must be initialized before using its layout)
 		EngineCore::UBO_Struct ubo{};
@@ -160,14 +194,16 @@ namespace WorldSystem
 		matSet->addUBO(ubo, device);
 		matSet->finalize(); // create material-specific descriptor set
 
-		// create demo material
+		// create materials
 		EngineCore::ShaderFilePaths shader(makePath("Shaders/shader.vert.spv"), makePath("Shaders/pbr.frag.spv"));
-		for (size_t i = 0; i < sector.primitives.size(); i++)
+		EngineCore::ShaderFilePaths compactShader(makePath("Shaders/shader_compact.vert.spv"), makePath("Shaders/pbr.frag.spv"));
+		for (size_t i = first; i < sector.primitives.size(); i++)
 		{
 			// TODO: materials should automatically include the layout of their own set (if present) on construct!!!
-			EngineCore::MaterialCreateInfo matInfo(shader, std::vector<VkDescriptorSetLayout>{ engine.getGlobalDescriptorLayout(), matSet->getLayout() },
+			const bool compact = description.objects[i - first].shading.vertexFormat != EngineCore::VertexFormat::Float32;
+			EngineCore::MaterialCreateInfo matInfo(compact ? compactShader : shader, std::vector<VkDescriptorSetLayout>{ engine.getGlobalDescriptorLayout(), matSet->getLayout() },
 						engine.getRenderSettings().sampleCountMSAA, engine.getRenderer().getBaseRenderpass().getRenderpass(), sizeof(EngineCore::ShaderPushConstants::MeshPushConstants));
-			matInfo.shadingProperties.cullModeFlags = VK_CULL_MODE_NONE;
+			matInfo.shadingProperties = description.objects[i - first].shading;
 
 			sector.primitives[i]->setMaterial(matInfo);
 			sector.primitives[i]->getMaterial()->setMaterialSpecificDescriptorSet(matSet); // TODO: better way to create material-specific sets
@@ -1,6 +1,7 @@
 #pragma once
 #include "Core/Types/CommonTypes.h"
 #include "Core/WorldSystem/Sector.h"
+#include "Core/WorldSystem/SectorDescription.h"
 
 #include <stdint.h>
 #include <memory>
@@ -22,6 +23,10 @@ namespace WorldSystem
 		World(EngineCore::EngineDevice& device, EngineCore::EngineApplication& engine);
 
 		void createDemoSectorContent();
+		// decodes a sector file, throws if the file can't be read or doesn't match SectorDescription
+		static SectorDescription readSectorDescription(const std::string& path);
+		// creates the sector described by the file, its content is loaded right away
+		Sector& loadSectorFromFile(const std::string& path);
 		// checks whether we have moved into a new sector
 		void sectorUpdate(EngineCore::Camera& camera);
 
@@ -44,6 +49,8 @@ namespace WorldSystem
 		Sector* getSector(const SectorCoord& coord);
 		Sector& loadSector(const SectorCoord& sectorPosition);
 		void forgetSector(const SectorCoord& coord);
+		// creates primitives and materials for every object in the description
+		void populateSector(Sector& sector, const SectorDescription& description);
 
 	private:
 		EngineCore::EngineDevice& device;